@@ -51,6 +51,26 @@
 		</xsl:choose>
 		
 	</xsl:template>
+
+	<!--
+		The property setter takes the ordinal that follows the getter's one. No
+		other member of the interface may use it, the schema cannot tell that.
+	-->
+	<xsl:template name="setter_ordinal">
+		<xsl:variable name="ordinal" select="@ordinal + 1" />
+		<xsl:if test="../*[@ordinal = $ordinal]">
+			<xsl:message terminate="yes">
+				<xsl:text>The setter of '</xsl:text>
+				<xsl:value-of select="@name" />
+				<xsl:text>' takes ordinal </xsl:text>
+				<xsl:value-of select="$ordinal" />
+				<xsl:text>, which is already used by '</xsl:text>
+				<xsl:value-of select="../*[@ordinal = $ordinal]/@name" />
+				<xsl:text>'.</xsl:text>
+			</xsl:message>
+		</xsl:if>
+		<xsl:value-of select="$ordinal" />
+	</xsl:template>
 	
 </xsl:stylesheet>
 
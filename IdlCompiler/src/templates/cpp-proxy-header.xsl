@@ -63,7 +63,8 @@
 				explicit IInterface_Proxy( NanoRpc::IRpcMessageSender *sender ) : sender_( sender ) {}
 				
 			For ordinary interfaces:
-				explicit IInterface_Proxy( NanoRpc::IRpcClient *client, NanoRpc::RpcObjectId object_id = 0 ) : client_( client ), object_id_( object_id ) {}
+				explicit IInterface_Proxy( NanoRpc::IRpcClient *client, NanoRpc::RpcObjectId object_id = 0 ) : client_( client ), object_id_( object_id ), target_( NULL ) {}
+				IInterface_Proxy( NanoRpc::IRpcClient *client, NanoRpc::RpcFuture *target ) : client_( client ), object_id_( 0 ), target_( target ) {}
 				virtual ~IInterface_Proxy();
 		-->
 		<xsl:text>class </xsl:text><xsl:value-of select="@name" />
@@ -78,7 +79,15 @@
 				<xsl:text>_Proxy( NanoRpc::IRpcMessageSender *sender ) : sender_( sender ) {}</xsl:text>
 			</xsl:when>
 			<xsl:otherwise>
-				<xsl:text>&#09;explicit </xsl:text><xsl:value-of select="@name"/><xsl:text>_Proxy( NanoRpc::IRpcClient *client, NanoRpc::RpcObjectId object_id = 0 ) :&#10;&#09;&#09;client_( client ), object_id_( object_id )&#10;&#09;{&#10;&#09;}&#10;&#10;</xsl:text>
+				<xsl:text>&#09;explicit </xsl:text><xsl:value-of select="@name"/><xsl:text>_Proxy( NanoRpc::IRpcClient *client, NanoRpc::RpcObjectId object_id = 0 ) :&#10;&#09;&#09;client_( client ), object_id_( object_id ), target_( NULL )&#10;&#09;{&#10;&#09;}&#10;&#10;</xsl:text>
+				<!--
+					The proxy of the object returned by the call that is still pending. Its calls
+					are pipelined on that call, see NanoRpc::RpcServer, or wait for it if the
+					server does not accept the pipelined calls. The proxy owns the object:
+					its destructor waits for the call and releases the object the call returned,
+					so the future must outlive the proxy and EndMethod must not be called on it.
+				-->
+				<xsl:text>&#09;</xsl:text><xsl:value-of select="@name"/><xsl:text>_Proxy( NanoRpc::IRpcClient *client, NanoRpc::RpcFuture *target ) :&#10;&#09;&#09;client_( client ), object_id_( 0 ), target_( target )&#10;&#09;{&#10;&#09;}&#10;&#10;</xsl:text>
 				<xsl:text>&#09;virtual ~</xsl:text><xsl:value-of select="@name"/><xsl:text>_Proxy();&#10;</xsl:text>
 			</xsl:otherwise>
 		</xsl:choose>
@@ -87,6 +96,11 @@
 		<xsl:apply-templates select="xmlidl:property" />
 		<xsl:apply-templates select="xmlidl:method" />
 
+		<xsl:if test="not( @source='true' or @source='yes' or @source='1' ) and count( xmlidl:method ) != 0">
+			<xsl:text>&#10;</xsl:text>
+			<xsl:apply-templates select="xmlidl:method" mode="declare_async" />
+		</xsl:if>
+
 		<xsl:text>&#10;</xsl:text>
 		<!--
 			For source interfaces:
@@ -100,6 +114,7 @@
 			private:
 				NanoRpc::IRpcClient *client_;
 				NanoRpc::RpcObjectId object_id_;
+				NanoRpc::RpcFuture *target_;
 			};
 		-->
 		<xsl:text>private:&#10;</xsl:text>
@@ -110,6 +125,7 @@
 			<xsl:otherwise>
 				<xsl:text>&#09;NanoRpc::IRpcClient *client_;&#10;</xsl:text>
 				<xsl:text>&#09;NanoRpc::RpcObjectId object_id_;&#10;</xsl:text>
+				<xsl:text>&#09;NanoRpc::RpcFuture *target_;&#10;</xsl:text>
 			</xsl:otherwise>
 		</xsl:choose>
 
@@ -160,6 +176,34 @@
 		<xsl:text>&#10;</xsl:text>
 	</xsl:template>
 
+	<xsl:template match="xmlidl:method" mode="declare_async" >
+		<!-- void MethodAsync(ARGUMENTS, NanoRpc::RpcFuture *future); -->
+		<xsl:text>&#09;void </xsl:text>
+		<xsl:value-of select="@name" />
+		<xsl:text>Async(</xsl:text>
+		<xsl:apply-templates select="xmlidl:arguments" />
+		<xsl:if test="count( xmlidl:arguments/xmlidl:argument ) != 0">
+			<xsl:text>, </xsl:text>
+		</xsl:if>
+		<xsl:text>NanoRpc::RpcFuture *future);</xsl:text>
+		<xsl:text>&#10;</xsl:text>
+
+		<!-- RETURN_TYPE EndMethod(NanoRpc::RpcFuture *future[, COMPLEX_TYPE *return_value]); -->
+		<xsl:if test="count( xmlidl:returns ) != 0" >
+			<xsl:text>&#09;</xsl:text>
+			<xsl:call-template name="declare_method_return_type"/>
+			<xsl:text> End</xsl:text>
+			<xsl:value-of select="@name" />
+			<xsl:text>(NanoRpc::RpcFuture *future</xsl:text>
+			<xsl:call-template name="declare_return_argument">
+				<xsl:with-param name="type" select="xmlidl:returns/@type"/>
+				<xsl:with-param name="separate" select="true()"/>
+			</xsl:call-template>
+			<xsl:text>);</xsl:text>
+			<xsl:text>&#10;</xsl:text>
+		</xsl:if>
+	</xsl:template>
+
 	<xsl:template name="declare_method_return_type" >
 		<xsl:choose>
 			<xsl:when test="count( xmlidl:returns ) != 0" >
@@ -200,10 +244,12 @@
 
 	<xsl:template name="declare_return_argument" >
 		<xsl:param name="type" select="@type"/>
+		<!-- The return argument follows some other argument, even if the method has none. -->
+		<xsl:param name="separate" select="false()"/>
 		<xsl:if test="not( $type='bool' or $type='int' or $type='long' or $type='double' or
 						count( /xmlidl:idl/xmlidl:enumerations/xmlidl:enum[@name=$type] ) != 0 or
 						count( /xmlidl:idl/xmlidl:interfaces/xmlidl:interface[@name=$type] ) != 0 )">
-			<xsl:if test="count( xmlidl:arguments/xmlidl:argument ) != 0">
+			<xsl:if test="count( xmlidl:arguments/xmlidl:argument ) != 0 or $separate">
 				<xsl:text>, </xsl:text>
 			</xsl:if>
 			<xsl:call-template name="map_type" >
@@ -52,28 +52,33 @@
 			<xsl:text>_Proxy()&#10;{&#10;</xsl:text>
 
 			<!--
-				if( object_id_ != 0 ) {
-					try {
-						NanoRpc::RpcMessage rpc_message;
-						rpc_message.mutable_call()->set_service( "NanoRpc.ObjectManagerService" );
-						rpc_message.mutable_call()->set_method( "Delete" );
-						rpc_message.mutable_call()->add_parameters()->set_uint32_value( object_id_ );
-						client_->Send( rpc_message );
+				The client collects the released objects and deletes them in bulk. The
+				pipelined proxy releases the object its target call returned.
+
+				try {
+					if( object_id_ != 0 ) {
+						client_->ReleaseObject( object_id_ );
 					}
-					catch( ... ) {
+					else if( target_ != NULL ) {
+						const NanoRpc::RpcResult &rpc_result = target_->get_result();
+						if( rpc_result.status() == NanoRpc::RpcSucceeded )
+							client_->ReleaseObject( rpc_result.call_result().object_id_value() );
 					}
 				}
+				catch( ... ) {
+				}
 			-->
-			<xsl:text>&#09;<![CDATA[if( object_id_ != 0 ) {]]>&#10;</xsl:text>
-			<xsl:text>&#09;&#09;<![CDATA[try {]]>&#10;</xsl:text>
-			<xsl:text>&#09;&#09;&#09;<![CDATA[NanoRpc::RpcMessage rpc_message;]]>&#10;</xsl:text>
-			<xsl:text>&#09;&#09;&#09;<![CDATA[rpc_message.mutable_call()->set_service( "NanoRpc.ObjectManagerService" );]]>&#10;</xsl:text>
-			<xsl:text>&#09;&#09;&#09;<![CDATA[rpc_message.mutable_call()->set_method( "Delete" );]]>&#10;</xsl:text>
-			<xsl:text>&#09;&#09;&#09;<![CDATA[rpc_message.mutable_call()->add_parameters()->set_uint32_value( object_id_ );]]>&#10;</xsl:text>
-			<xsl:text>&#09;&#09;&#09;<![CDATA[client_->Send( rpc_message );]]>&#10;</xsl:text>
+			<xsl:text>&#09;<![CDATA[try {]]>&#10;</xsl:text>
+			<xsl:text>&#09;&#09;<![CDATA[if( object_id_ != 0 ) {]]>&#10;</xsl:text>
+			<xsl:text>&#09;&#09;&#09;<![CDATA[client_->ReleaseObject( object_id_ );]]>&#10;</xsl:text>
 			<xsl:text>&#09;&#09;<![CDATA[}]]>&#10;</xsl:text>
-			<xsl:text>&#09;&#09;<![CDATA[catch( ... ) {]]>&#10;</xsl:text>
+			<xsl:text>&#09;&#09;<![CDATA[else if( target_ != NULL ) {]]>&#10;</xsl:text>
+			<xsl:text>&#09;&#09;&#09;<![CDATA[const NanoRpc::RpcResult &rpc_result = target_->get_result();]]>&#10;</xsl:text>
+			<xsl:text>&#09;&#09;&#09;<![CDATA[if( rpc_result.status() == NanoRpc::RpcSucceeded )]]>&#10;</xsl:text>
+			<xsl:text>&#09;&#09;&#09;&#09;<![CDATA[client_->ReleaseObject( rpc_result.call_result().object_id_value() );]]>&#10;</xsl:text>
 			<xsl:text>&#09;&#09;<![CDATA[}]]>&#10;</xsl:text>
+			<xsl:text>&#09;<![CDATA[}]]>&#10;</xsl:text>
+			<xsl:text>&#09;<![CDATA[catch( ... ) {]]>&#10;</xsl:text>
 			<xsl:text>&#09;<![CDATA[}]]></xsl:text>
 			
 			<xsl:text>&#10;}&#10;&#10;&#10;</xsl:text>
@@ -81,6 +86,10 @@
 
 		<xsl:apply-templates select="xmlidl:property" />
 		<xsl:apply-templates select="xmlidl:method" />
+
+		<xsl:if test ="not( @source='true' or @source='yes' or @source='1' )">
+			<xsl:apply-templates select="xmlidl:method" mode="generate_async" />
+		</xsl:if>
 	</xsl:template>
 
 	<xsl:template match="xmlidl:property" >
@@ -158,9 +167,73 @@
 		<xsl:text>}&#10;&#10;&#10;</xsl:text>
 	</xsl:template>
 
-	<xsl:template match="xmlidl:property" mode="generate_get_property_body" >
+	<xsl:template match="xmlidl:method" mode="generate_async" >
+		<!--
+			The call is sent without waiting for the result, which is then picked up
+			from the future by EndMethod (or by the future's callback).
+
+			void [classname]_Proxy::MethodAsync(ARGUMENTS, NanoRpc::RpcFuture *future)
+			{
+				...
+				client_->SendWithFuture( rpc_message, future );
+			}
+		-->
+		<xsl:text>void </xsl:text>
+		<xsl:value-of select="../@name" />
+		<xsl:text>_Proxy::</xsl:text>
+		<xsl:value-of select="@name" />
+		<xsl:text>Async(</xsl:text>
+		<xsl:apply-templates select="xmlidl:arguments" />
+		<xsl:if test="count( xmlidl:arguments/xmlidl:argument ) != 0">
+			<xsl:text>, </xsl:text>
+		</xsl:if>
+		<xsl:text>NanoRpc::RpcFuture *future)&#10;</xsl:text>
+		<xsl:text>{&#10;</xsl:text>
+
 		<xsl:call-template name="serialize_arguments" />
 
+		<!-- The calls may be pipelined on the object before it is returned. -->
+		<xsl:if test="count( /xmlidl:idl/xmlidl:interfaces/xmlidl:interface[@name=current()/xmlidl:returns/@type] ) != 0">
+			<xsl:text>&#09;<![CDATA[rpc_message.mutable_call()->set_is_pipeline_target( true );]]>&#10;</xsl:text>
+		</xsl:if>
+
+		<xsl:text>&#10;&#09;<![CDATA[client_->SendWithFuture( rpc_message, future );]]>&#10;</xsl:text>
+		<xsl:text>}&#10;&#10;&#10;</xsl:text>
+
+		<!--
+			RETURN_TYPE [classname]_Proxy::EndMethod(NanoRpc::RpcFuture *future[, COMPLEX_TYPE *return_value])
+			{
+				const NanoRpc::RpcResult &rpc_result = future->get_result();
+				...
+			}
+		-->
+		<xsl:if test="count( xmlidl:returns ) != 0" >
+			<xsl:call-template name="declare_method_return_type"/>
+			<xsl:text> </xsl:text>
+			<xsl:value-of select="../@name" />
+			<xsl:text>_Proxy::End</xsl:text>
+			<xsl:value-of select="@name" />
+			<xsl:text>(NanoRpc::RpcFuture *future</xsl:text>
+			<xsl:call-template name="declare_return_argument">
+				<xsl:with-param name="type" select="xmlidl:returns/@type"/>
+				<xsl:with-param name="separate" select="true()"/>
+			</xsl:call-template>
+			<xsl:text>)&#10;</xsl:text>
+			<xsl:text>{&#10;</xsl:text>
+			<xsl:text>&#09;<![CDATA[const NanoRpc::RpcResult &rpc_result = future->get_result();]]>&#10;</xsl:text>
+			<!-- TODO: Handle errorneous result -->
+			<xsl:call-template name="deserialize_return_value">
+				<xsl:with-param name="type" select="xmlidl:returns/@type"/>
+			</xsl:call-template>
+			<xsl:text>}&#10;&#10;&#10;</xsl:text>
+		</xsl:if>
+	</xsl:template>
+
+	<xsl:template match="xmlidl:property" mode="generate_get_property_body" >
+		<xsl:call-template name="serialize_arguments">
+			<xsl:with-param name="method_name" select="concat( 'get_', @name )"/>
+		</xsl:call-template>
+
 		<xsl:text>&#10;&#09;if( object_id_ != 0 )&#10;&#09;&#09;rpc_message.mutable_call()->set_object_id( object_id_ );&#10;</xsl:text>
 
 		<xsl:text>&#10;&#09;NanoRpc::RpcResult rpc_result;&#10;</xsl:text>
@@ -175,9 +248,17 @@
 		because property does not have arguments node. This is a temporary shortcut to intitialize
 		service and method fields.
 		-->
-		<xsl:call-template name="serialize_arguments" />
-		<xsl:call-template name="serialize_value" >
-			<xsl:with-param name="name" select="'value'"/>
+		<xsl:call-template name="serialize_arguments">
+			<xsl:with-param name="method_name" select="concat( 'set_', @name )"/>
+			<xsl:with-param name="ordinal">
+				<xsl:if test="boolean(@ordinal)">
+					<xsl:call-template name="setter_ordinal"/>
+				</xsl:if>
+			</xsl:with-param>
+		</xsl:call-template>
+		<xsl:call-template name="serialize_parameters" >
+			<xsl:with-param name="values" select="."/>
+			<xsl:with-param name="value_name" select="'value'"/>
 		</xsl:call-template>
 		
 	</xsl:template>
@@ -221,10 +302,12 @@
 
 	<xsl:template name="declare_return_argument" >
 		<xsl:param name="type" select="@type"/>
+		<!-- The return argument follows some other argument, even if the method has none. -->
+		<xsl:param name="separate" select="false()"/>
 		<xsl:if test="not( $type='bool' or $type='int' or $type='long' or $type='double' or
 						count( /xmlidl:idl/xmlidl:enumerations/xmlidl:enum[@name=$type] ) != 0 or
 						count( /xmlidl:idl/xmlidl:interfaces/xmlidl:interface[@name=$type] ) != 0 )">
-			<xsl:if test="count( xmlidl:arguments/xmlidl:argument ) != 0">
+			<xsl:if test="count( xmlidl:arguments/xmlidl:argument ) != 0 or $separate">
 				<xsl:text>, </xsl:text>
 			</xsl:if>
 			<xsl:call-template name="map_type" >
@@ -281,6 +364,8 @@
 	</xsl:template>
 
 	<xsl:template name="serialize_arguments">
+		<xsl:param name="method_name" select="@name" />
+		<xsl:param name="ordinal" select="@ordinal" />
 		<xsl:text>&#09;NanoRpc::RpcMessage rpc_message;&#10;</xsl:text>
 		
 		<!-- Set interface name. -->
@@ -292,7 +377,18 @@
 			</xsl:when>
 
 			<xsl:otherwise>
-				<xsl:text>&#10;&#09;if( object_id_ != 0 ) {&#10;&#09;&#09;rpc_message.mutable_call()->set_object_id( object_id_ );&#10;&#09;}&#10;&#09;else {&#10;</xsl:text>
+				<!--
+					The server that does not accept the pipelined calls gets the call once the
+					target completes, addressed to the object the target returned. If the target
+					failed, the call carries neither and the server fails it.
+				-->
+				<xsl:text>&#10;&#09;NanoRpc::RpcObjectId object_id = object_id_;&#10;</xsl:text>
+				<xsl:text>&#09;if( object_id == 0 &amp;&amp; target_ != NULL &amp;&amp; !client_->AcceptsPipelinedCalls() ) {&#10;</xsl:text>
+				<xsl:text>&#09;&#09;const NanoRpc::RpcResult &amp;target_result = target_->get_result();&#10;</xsl:text>
+				<xsl:text>&#09;&#09;if( target_result.status() == NanoRpc::RpcSucceeded )&#10;</xsl:text>
+				<xsl:text>&#09;&#09;&#09;object_id = target_result.call_result().object_id_value();&#10;&#09;}&#10;</xsl:text>
+				<xsl:text>&#10;&#09;if( object_id != 0 ) {&#10;&#09;&#09;rpc_message.mutable_call()->set_object_id( object_id );&#10;&#09;}&#10;</xsl:text>
+				<xsl:text>&#09;else if( target_ != NULL ) {&#10;&#09;&#09;if( client_->AcceptsPipelinedCalls() )&#10;&#09;&#09;&#09;rpc_message.mutable_call()->set_target_call_id( target_->get_call_id() );&#10;&#09;}&#10;&#09;else {&#10;</xsl:text>
 				<xsl:text>&#09;&#09;<![CDATA[rpc_message.mutable_call()->set_service( "]]></xsl:text>
 				<xsl:call-template name="insert_service_name"/>
 				<xsl:text><![CDATA[" );]]>&#10;&#09;}&#10;&#10;</xsl:text>
@@ -301,64 +397,147 @@
 
 		<!-- Set method name. -->
 		<xsl:text>&#09;<![CDATA[rpc_message.mutable_call()->set_method( "]]></xsl:text>
-		<xsl:value-of select="@name"/>
+		<xsl:value-of select="$method_name"/>
 		<xsl:text><![CDATA[" );]]>&#10;</xsl:text>
 
-		<xsl:apply-templates select="xmlidl:arguments" mode="serialize_argument" />
+		<!-- The ordinal assigned in the IDL spares the stub the name lookup. -->
+		<xsl:if test="string($ordinal) != ''">
+			<xsl:text>&#09;<![CDATA[rpc_message.mutable_call()->set_method_ordinal( ]]></xsl:text>
+			<xsl:value-of select="$ordinal"/>
+			<xsl:text><![CDATA[ );]]>&#10;</xsl:text>
+		</xsl:if>
+
+		<xsl:call-template name="serialize_parameters" />
+	</xsl:template>
+
+	<!--
+		The arguments are packed into one record for the servers that unpack
+		them, see NanoRpc::RpcPackedWriter, and go as the parameters otherwise.
+		The events are sent as the parameters, the server does not know which
+		clients unpack them.
+
+		if( client_->AcceptsPackedParameters() ) {
+			NanoRpc::RpcPackedWriter writer( rpc_message.mutable_call()->mutable_packed_parameters() );
+			writer.WriteInt( a );
+			...
+		}
+		else {
+			rpc_message.mutable_call()->add_parameters()->set_int32_value( a );
+			...
+		}
+	-->
+	<xsl:template name="serialize_parameters">
+		<!-- The arguments, or the property with the value to set. -->
+		<xsl:param name="values" select="xmlidl:arguments/xmlidl:argument" />
+		<!-- Names the value instead of its @name, if not empty. -->
+		<xsl:param name="value_name" select="''" />
+		<xsl:choose>
+			<xsl:when test ="../@source='true' or ../@source='yes' or ../@source='1'">
+				<xsl:for-each select="$values">
+					<xsl:call-template name="serialize_value">
+						<xsl:with-param name="name" select="concat( $value_name, @name[$value_name = ''] )"/>
+					</xsl:call-template>
+				</xsl:for-each>
+			</xsl:when>
+
+			<xsl:when test="count( $values ) != 0">
+				<xsl:text>&#10;&#09;if( client_->AcceptsPackedParameters() ) {&#10;</xsl:text>
+				<xsl:text>&#09;&#09;NanoRpc::RpcPackedWriter writer( rpc_message.mutable_call()->mutable_packed_parameters() );&#10;</xsl:text>
+				<xsl:for-each select="$values">
+					<xsl:call-template name="pack_value">
+						<xsl:with-param name="name" select="concat( $value_name, @name[$value_name = ''] )"/>
+					</xsl:call-template>
+				</xsl:for-each>
+				<xsl:text>&#09;}&#10;&#09;else {&#10;</xsl:text>
+				<xsl:for-each select="$values">
+					<xsl:call-template name="serialize_value">
+						<xsl:with-param name="name" select="concat( $value_name, @name[$value_name = ''] )"/>
+						<xsl:with-param name="indent" select="'&#09;&#09;'"/>
+					</xsl:call-template>
+				</xsl:for-each>
+				<xsl:text>&#09;}&#10;</xsl:text>
+			</xsl:when>
+		</xsl:choose>
 	</xsl:template>
 
-	<xsl:template match="xmlidl:argument" mode="serialize_argument" >
-		<xsl:call-template name="serialize_value" />
+	<xsl:template name="pack_value" >
+		<xsl:param name="type" select="@type" />
+		<xsl:param name="name" select="@name" />
+		<xsl:text>&#09;&#09;writer.</xsl:text>
+		<xsl:choose>
+			<xsl:when test="$type='bool'" >
+				<xsl:text>WriteBool</xsl:text>
+			</xsl:when>
+			<xsl:when test="$type='int' or count( /xmlidl:idl/xmlidl:enumerations/xmlidl:enum[@name=$type] ) != 0" >
+				<xsl:text>WriteInt</xsl:text>
+			</xsl:when>
+			<xsl:when test="$type='long'" >
+				<xsl:text>WriteLong</xsl:text>
+			</xsl:when>
+			<xsl:when test="$type='double'" >
+				<xsl:text>WriteDouble</xsl:text>
+			</xsl:when>
+			<xsl:when test="$type='string'" >
+				<xsl:text>WriteString</xsl:text>
+			</xsl:when>
+			<xsl:otherwise>
+				<xsl:text>WriteMessage</xsl:text>
+			</xsl:otherwise>
+		</xsl:choose>
+		<xsl:text>( </xsl:text>
+		<xsl:value-of select="$name"/>
+		<xsl:text> );&#10;</xsl:text>
 	</xsl:template>
 
 	<xsl:template name="serialize_value" >
 		<xsl:param name="type" select="@type" />
 		<xsl:param name="name" select="@name" />
+		<xsl:param name="indent" select="'&#09;'" />
 		<xsl:choose>
 			<xsl:when test="$type='bool'" >
-				<xsl:text>&#09;</xsl:text>
+				<xsl:value-of select="$indent"/>
 				<xsl:text>rpc_message.mutable_call()->add_parameters()->set_bool_value( </xsl:text>
 				<xsl:value-of select="$name"/>
 				<xsl:text> );</xsl:text>
 			</xsl:when>
 			<xsl:when test="$type='int'" >
-				<xsl:text>&#09;</xsl:text>
+				<xsl:value-of select="$indent"/>
 				<xsl:text>rpc_message.mutable_call()->add_parameters()->set_int32_value( </xsl:text>
 				<xsl:value-of select="$name"/>
 				<xsl:text> );</xsl:text>
 			</xsl:when>
 			<xsl:when test="$type='long'" >
-				<xsl:text>&#09;</xsl:text>
+				<xsl:value-of select="$indent"/>
 				<xsl:text>rpc_message.mutable_call()->add_parameters()->set_int64_value( </xsl:text>
 				<xsl:value-of select="$name"/>
 				<xsl:text> );</xsl:text>
 			</xsl:when>
 			<xsl:when test="$type='double'" >
-				<xsl:text>&#09;</xsl:text>
+				<xsl:value-of select="$indent"/>
 				<xsl:text>rpc_message.mutable_call()->add_parameters()->set_double_value( </xsl:text>
 				<xsl:value-of select="$name"/>
 				<xsl:text> );</xsl:text>
 			</xsl:when>
 			<xsl:when test="$type='string'" >
-				<xsl:text>&#09;</xsl:text>
+				<xsl:value-of select="$indent"/>
 				<xsl:text>NanoRpc::WideToUtf8String( </xsl:text>
 				<xsl:value-of select="$name"/>
 				<xsl:text>, </xsl:text>
 				<xsl:text>rpc_message.mutable_call()->add_parameters()->mutable_string_value() );</xsl:text>
 			</xsl:when>
 			<xsl:when test="count( /xmlidl:idl/xmlidl:enumerations/xmlidl:enum[@name=$type] ) != 0" >
-				<xsl:text>&#09;</xsl:text>
+				<xsl:value-of select="$indent"/>
 				<xsl:text>rpc_message.mutable_call()->add_parameters()->set_int32_value( </xsl:text>
 				<xsl:value-of select="$name"/>
 				<xsl:text> );</xsl:text>
 			</xsl:when>
 			<xsl:otherwise>
-				<xsl:text>&#09;</xsl:text>
+				<xsl:value-of select="$indent"/>
 				<xsl:text>std::string str;</xsl:text>
-				<xsl:text>&#10;&#09;</xsl:text>
+				<xsl:text>&#10;</xsl:text><xsl:value-of select="$indent"/>
 				<xsl:value-of select="$name"/>
 				<xsl:text><![CDATA[.SerializeToString( &str );]]></xsl:text>
-				<xsl:text>&#10;&#09;</xsl:text>
+				<xsl:text>&#10;</xsl:text><xsl:value-of select="$indent"/>
 				<xsl:text>rpc_message.mutable_call()->add_parameters()->set_proto_value( str );</xsl:text>
 			</xsl:otherwise>
 		</xsl:choose>
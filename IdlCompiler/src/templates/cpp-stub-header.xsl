@@ -89,11 +89,64 @@
 				IExampleService* impl_;
 		-->
 		<xsl:text>private:&#10;</xsl:text>
+
+		<!--
+			enum MethodOrdinal {
+				UnknownMethod = 0,
+				Method_Add = 1,
+				LocalMethodOrdinals = 0x10000,
+				Method_Reset,
+			};
+
+			static MethodOrdinal GetMethodOrdinal( const NanoRpc::RpcCall &rpc_call );
+
+			The ordinals assigned in the IDL may be sent on the wire, the rest
+			are only used for the dispatch.
+		-->
+		<xsl:text>&#09;enum MethodOrdinal {&#10;</xsl:text>
+		<xsl:text>&#09;&#09;UnknownMethod = 0,&#10;</xsl:text>
+		<xsl:apply-templates select="xmlidl:property[@ordinal] | xmlidl:method[@ordinal]" mode="declare_method_ordinal" />
+		<xsl:text>&#09;&#09;LocalMethodOrdinals = 0x10000,&#10;</xsl:text>
+		<xsl:apply-templates select="xmlidl:property[not(@ordinal)] | xmlidl:method[not(@ordinal)]" mode="declare_method_ordinal" />
+		<xsl:text>&#09;};&#10;&#10;</xsl:text>
+		<xsl:text>&#09;<![CDATA[static MethodOrdinal GetMethodOrdinal( const NanoRpc::RpcCall &rpc_call );]]>&#10;&#10;</xsl:text>
+
 		<xsl:text>&#09;NanoRpc::IRpcObjectManager* object_manager_;&#10;</xsl:text>
 		<xsl:text>&#09;</xsl:text><xsl:value-of select="@name" /><xsl:text>* impl_;&#10;</xsl:text>
 
 		<xsl:text>};&#10;&#10;&#10;</xsl:text>
 	</xsl:template>
 
+	<xsl:template match="xmlidl:property" mode="declare_method_ordinal">
+		<xsl:text>&#09;&#09;Method_get_</xsl:text>
+		<xsl:value-of select="@name" />
+		<xsl:if test="boolean(@ordinal)">
+			<xsl:text> = </xsl:text>
+			<xsl:value-of select="@ordinal" />
+		</xsl:if>
+		<xsl:text>,&#10;</xsl:text>
+
+		<!-- The setter takes the ordinal that follows the getter's one. -->
+		<xsl:if test="count(@readonly)=0 or @readonly='false' or @readonly='no' or @readonly='0'" >
+			<xsl:text>&#09;&#09;Method_set_</xsl:text>
+			<xsl:value-of select="@name" />
+			<xsl:if test="boolean(@ordinal)">
+				<xsl:text> = </xsl:text>
+				<xsl:call-template name="setter_ordinal" />
+			</xsl:if>
+			<xsl:text>,&#10;</xsl:text>
+		</xsl:if>
+	</xsl:template>
+
+	<xsl:template match="xmlidl:method" mode="declare_method_ordinal">
+		<xsl:text>&#09;&#09;Method_</xsl:text>
+		<xsl:value-of select="@name" />
+		<xsl:if test="boolean(@ordinal)">
+			<xsl:text> = </xsl:text>
+			<xsl:value-of select="@ordinal" />
+		</xsl:if>
+		<xsl:text>,&#10;</xsl:text>
+	</xsl:template>
+
 </xsl:stylesheet>
 
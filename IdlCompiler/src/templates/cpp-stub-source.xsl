@@ -49,58 +49,137 @@
 		<xsl:value-of select="@name" />
 		<xsl:text>_Stub::</xsl:text>
 		<xsl:text><![CDATA[GetInterfaceName() const]]></xsl:text>
-		<xsl:text>&#10;{&#10;&#09;return &quot;</xsl:text>
-		
-		<xsl:if test="boolean(../../@namespace)">
-			<xsl:value-of select="../../@namespace" />
-		</xsl:if>
-		<xsl:text>.</xsl:text>
-		<xsl:value-of select="@name"/>
+		<xsl:text>&#10;{&#10;&#09;return </xsl:text>
+		<xsl:call-template name="interface_name" />
+		<xsl:text>;&#10;}&#10;&#10;&#10;</xsl:text>
+
+		<!--
+			The ordinal sent by the proxy is used as is. Otherwise the method name
+			is looked up by its length first, so at most a few names of the same
+			length are compared.
+		-->
+		<xsl:value-of select="@name" />
+		<xsl:text>_Stub::MethodOrdinal </xsl:text>
+		<xsl:value-of select="@name" />
+		<xsl:text>_Stub::</xsl:text>
+		<xsl:text><![CDATA[GetMethodOrdinal( const NanoRpc::RpcCall &rpc_call )]]></xsl:text>
+		<xsl:text>&#10;{&#10;</xsl:text>
+		<xsl:text>&#09;if( rpc_call.has_method_ordinal() ) {&#10;</xsl:text>
+		<xsl:text>&#09;&#09;if( rpc_call.method_ordinal() >= LocalMethodOrdinals )&#10;</xsl:text>
+		<xsl:text>&#09;&#09;&#09;return UnknownMethod;&#10;</xsl:text>
+		<xsl:text>&#09;&#09;return static_cast&lt;MethodOrdinal&gt;( rpc_call.method_ordinal() );&#10;</xsl:text>
+		<xsl:text>&#09;}&#10;&#10;</xsl:text>
+		<xsl:text>&#09;<![CDATA[const std::string &method = rpc_call.method();]]>&#10;</xsl:text>
+		<xsl:text>&#09;switch( method.size() ) {&#10;</xsl:text>
 
-		<xsl:text>&quot;;&#10;}&#10;&#10;&#10;</xsl:text>
+		<xsl:apply-templates select="xmlidl:property | xmlidl:method" mode="generate_method_lookup"/>
+
+		<xsl:text>&#09;}&#10;&#10;</xsl:text>
+		<xsl:text>&#09;return UnknownMethod;&#10;}&#10;&#10;&#10;</xsl:text>
 
 		<xsl:text><![CDATA[void ]]></xsl:text>
 		<xsl:value-of select="@name" />
 		<xsl:text>_Stub::</xsl:text>
 		<xsl:text><![CDATA[CallMethod( const NanoRpc::RpcCall &rpc_call, NanoRpc::RpcResult *rpc_result )]]></xsl:text>
 		<xsl:text>&#10;{&#10;</xsl:text>
+		<xsl:text>&#09;switch( GetMethodOrdinal( rpc_call ) ) {&#10;</xsl:text>
 
 		<xsl:apply-templates select="xmlidl:property | xmlidl:method" mode="generate_call_dispatcher"/>
-		
+
+		<xsl:text>&#09;default:&#10;</xsl:text>
+		<xsl:text>&#09;&#09;rpc_result->set_status( NanoRpc::RpcUnknownMethod );&#10;</xsl:text>
+		<xsl:text>&#09;&#09;break;&#10;</xsl:text>
+		<xsl:text>&#09;}&#10;</xsl:text>
+
 		<xsl:text>&#10;&#09;return;&#10;}&#10;&#10;&#10;</xsl:text>
 	</xsl:template>
 
-	<xsl:template match="xmlidl:property" mode="generate_call_dispatcher">
-		<xsl:text>&#09;</xsl:text>
-		<xsl:choose>
-			<xsl:when test="position() = 1" >
-				<xsl:text>if</xsl:text>
-			</xsl:when>
-			<xsl:otherwise>
-				<xsl:text>else if</xsl:text>
-			</xsl:otherwise>
-		</xsl:choose>
+	<!-- The string literal GetInterfaceName returns for the interface. -->
+	<xsl:template name="interface_name">
+		<xsl:param name="interface" select="." />
+		<xsl:text>&quot;</xsl:text>
+		<xsl:value-of select="$interface/../../@namespace" />
+		<xsl:text>.</xsl:text>
+		<xsl:value-of select="$interface/@name"/>
+		<xsl:text>&quot;</xsl:text>
+	</xsl:template>
+
+	<!--
+		Emits the case for the length of the member's names, unless one of the
+		preceding members has already emitted it.
+	-->
+	<xsl:template match="xmlidl:property | xmlidl:method" mode="generate_method_lookup">
+		<xsl:variable name="length">
+			<xsl:choose>
+				<xsl:when test="self::xmlidl:property">
+					<xsl:value-of select="string-length(@name) + 4" />
+				</xsl:when>
+				<xsl:otherwise>
+					<xsl:value-of select="string-length(@name)" />
+				</xsl:otherwise>
+			</xsl:choose>
+		</xsl:variable>
+
+		<xsl:if test="not( preceding-sibling::xmlidl:property[string-length(@name) + 4 = $length] or
+						preceding-sibling::xmlidl:method[string-length(@name) = $length] )">
+			<xsl:text>&#09;case </xsl:text>
+			<xsl:value-of select="$length" />
+			<xsl:text>:&#10;</xsl:text>
+
+			<xsl:apply-templates select="../xmlidl:property[string-length(@name) + 4 = $length] |
+										../xmlidl:method[string-length(@name) = $length]" mode="compare_method_name" />
+
+			<xsl:text>&#09;&#09;break;&#10;</xsl:text>
+		</xsl:if>
+	</xsl:template>
+
+	<xsl:template match="xmlidl:property" mode="compare_method_name">
+		<xsl:call-template name="compare_method_name">
+			<xsl:with-param name="name" select="concat( 'get_', @name )" />
+		</xsl:call-template>
+		<xsl:if test="count(@readonly)=0 or @readonly='false' or @readonly='no' or @readonly='0'" >
+			<xsl:call-template name="compare_method_name">
+				<xsl:with-param name="name" select="concat( 'set_', @name )" />
+			</xsl:call-template>
+		</xsl:if>
+	</xsl:template>
+
+	<xsl:template match="xmlidl:method" mode="compare_method_name">
+		<xsl:call-template name="compare_method_name">
+			<xsl:with-param name="name" select="@name" />
+		</xsl:call-template>
+	</xsl:template>
+
+	<xsl:template name="compare_method_name">
+		<xsl:param name="name" />
+		<xsl:text>&#09;&#09;if( method == &quot;</xsl:text>
+		<xsl:value-of select="$name" />
+		<xsl:text>&quot; )&#10;</xsl:text>
+		<xsl:text>&#09;&#09;&#09;return Method_</xsl:text>
+		<xsl:value-of select="$name" />
+		<xsl:text>;&#10;</xsl:text>
+	</xsl:template>
 
-		<xsl:text>( rpc_call.method() == &quot;get_</xsl:text>
+	<xsl:template match="xmlidl:property" mode="generate_call_dispatcher">
+		<xsl:text>&#09;case Method_get_</xsl:text>
 		<xsl:value-of select="@name" />
-		<xsl:text>&quot; ) {&#10;</xsl:text>
+		<xsl:text>: {&#10;</xsl:text>
 
 		<xsl:apply-templates select="." mode="get" />
 
-		<xsl:text>&#09;}&#10;</xsl:text>
+		<xsl:text>&#09;&#09;break;&#10;&#09;}&#10;</xsl:text>
 		<!-- 
 			This is a not schema-aware processor, so we cannot rely on datatype of 
 			attributes and elements declared in schema!
 		-->
 		<xsl:if test="count(@readonly)=0 or @readonly='false' or @readonly='no' or @readonly='0'" >
-			<xsl:text>&#09;</xsl:text>
-			<xsl:text>else if( rpc_call.method() == &quot;set_</xsl:text>
+			<xsl:text>&#09;case Method_set_</xsl:text>
 			<xsl:value-of select="@name" />
-			<xsl:text>&quot; ) {&#10;</xsl:text>
+			<xsl:text>: {&#10;</xsl:text>
 
 			<xsl:apply-templates select="." mode="set" />
 
-			<xsl:text>&#09;}&#10;</xsl:text>
+			<xsl:text>&#09;&#09;break;&#10;&#09;}&#10;</xsl:text>
 		</xsl:if>
 	</xsl:template>
 
@@ -121,8 +200,9 @@
 		<xsl:text>&#09;&#09;</xsl:text>
 		<xsl:call-template name="map_type"/><xsl:text> value;&#10;</xsl:text>
 
-		<xsl:call-template name="deserialize_argument" >
-			<xsl:with-param name="name" select="'value'"/>
+		<xsl:call-template name="deserialize_parameters" >
+			<xsl:with-param name="values" select="."/>
+			<xsl:with-param name="value_name" select="'value'"/>
 		</xsl:call-template>
 		
 		<xsl:text>&#09;&#09;impl_->set_</xsl:text>
@@ -131,29 +211,19 @@
 	</xsl:template>
 
 	<xsl:template match="xmlidl:method" mode="generate_call_dispatcher">
-		<xsl:text>&#09;</xsl:text>
-		<xsl:choose>
-			<xsl:when test="position() = 1" >
-				<xsl:text>if</xsl:text>
-			</xsl:when>
-			<xsl:otherwise>
-				<xsl:text>else if</xsl:text>
-			</xsl:otherwise>
-		</xsl:choose>
-
-		<xsl:text>( rpc_call.method() == &quot;</xsl:text>
+		<xsl:text>&#09;case Method_</xsl:text>
 		<xsl:value-of select="@name" />
-		<xsl:text>&quot; ) {&#10;</xsl:text>
+		<xsl:text>: {&#10;</xsl:text>
 
 		<xsl:apply-templates select="." />
 
-		<xsl:text>&#09;}&#10;</xsl:text>
+		<xsl:text>&#09;&#09;break;&#10;&#09;}&#10;</xsl:text>
 	</xsl:template>
 
 	<xsl:template match="xmlidl:method" >
 		<xsl:apply-templates select="xmlidl:arguments" mode="declare_temp_variables" />
 		<xsl:apply-templates select="xmlidl:returns" mode="declare_return_variable"/>
-		<xsl:apply-templates select="xmlidl:arguments" mode="deserialize" />
+		<xsl:call-template name="deserialize_parameters" />
 
 		<xsl:choose>
 			<xsl:when test="count( xmlidl:returns ) != 0">
@@ -186,8 +256,86 @@
 		<xsl:call-template name="declare_return_variable"/>
 	</xsl:template>
 
-	<xsl:template match="xmlidl:argument" mode="deserialize">
-		<xsl:call-template name="deserialize_argument" />
+	<!--
+		The arguments packed by the proxy (see NanoRpc::RpcPackedReader) are
+		unpacked in the order of the signature, the parameters are read by
+		their index.
+
+		if( rpc_call.has_packed_parameters() ) {
+			NanoRpc::RpcPackedReader reader( rpc_call.packed_parameters() );
+			if( !reader.ReadInt( &a ) ||
+				... ) {
+				rpc_result->set_status( NanoRpc::RpcInvalidCallParameter );
+				break;
+			}
+		}
+		else {
+			a = rpc_call.parameters().Get(0).int32_value();
+			...
+		}
+	-->
+	<xsl:template name="deserialize_parameters">
+		<!-- The arguments, or the property with the value to set. -->
+		<xsl:param name="values" select="xmlidl:arguments/xmlidl:argument" />
+		<!-- Names the value instead of its @name, if not empty. -->
+		<xsl:param name="value_name" select="''" />
+		<xsl:if test="count( $values ) != 0">
+			<xsl:text>&#09;&#09;if( rpc_call.has_packed_parameters() ) {&#10;</xsl:text>
+			<xsl:text>&#09;&#09;&#09;NanoRpc::RpcPackedReader reader( rpc_call.packed_parameters() );&#10;</xsl:text>
+			<xsl:text>&#09;&#09;&#09;if( </xsl:text>
+			<xsl:for-each select="$values">
+				<xsl:call-template name="unpack_value">
+					<xsl:with-param name="name" select="concat( $value_name, @name[$value_name = ''] )"/>
+				</xsl:call-template>
+				<xsl:if test="position() != last()">
+					<xsl:text> ||&#10;&#09;&#09;&#09;&#09;</xsl:text>
+				</xsl:if>
+			</xsl:for-each>
+			<xsl:text> ) {&#10;</xsl:text>
+			<xsl:text>&#09;&#09;&#09;&#09;rpc_result->set_status( NanoRpc::RpcInvalidCallParameter );&#10;</xsl:text>
+			<xsl:text>&#09;&#09;&#09;&#09;break;&#10;</xsl:text>
+			<xsl:text>&#09;&#09;&#09;}&#10;</xsl:text>
+			<xsl:text>&#09;&#09;}&#10;&#09;&#09;else {&#10;</xsl:text>
+			<xsl:for-each select="$values">
+				<xsl:call-template name="deserialize_argument">
+					<xsl:with-param name="name" select="concat( $value_name, @name[$value_name = ''] )"/>
+					<xsl:with-param name="indent" select="'&#09;&#09;&#09;'"/>
+				</xsl:call-template>
+			</xsl:for-each>
+			<xsl:text>&#09;&#09;}&#10;</xsl:text>
+		</xsl:if>
+	</xsl:template>
+
+	<xsl:template name="unpack_value">
+		<xsl:param name="type" select="@type" />
+		<xsl:param name="name" select="@name" />
+		<xsl:text>!reader.</xsl:text>
+		<xsl:choose>
+			<xsl:when test="$type='bool'" >
+				<xsl:text>ReadBool</xsl:text>
+			</xsl:when>
+			<xsl:when test="$type='int'" >
+				<xsl:text>ReadInt</xsl:text>
+			</xsl:when>
+			<xsl:when test="$type='long'" >
+				<xsl:text>ReadLong</xsl:text>
+			</xsl:when>
+			<xsl:when test="$type='double'" >
+				<xsl:text>ReadDouble</xsl:text>
+			</xsl:when>
+			<xsl:when test="$type='string'" >
+				<xsl:text>ReadString</xsl:text>
+			</xsl:when>
+			<xsl:when test="count( /xmlidl:idl/xmlidl:enumerations/xmlidl:enum[@name=$type] ) != 0">
+				<xsl:text>ReadEnum</xsl:text>
+			</xsl:when>
+			<xsl:otherwise>
+				<xsl:text>ReadMessage</xsl:text>
+			</xsl:otherwise>
+		</xsl:choose>
+		<xsl:text>( &amp;</xsl:text>
+		<xsl:value-of select="$name"/>
+		<xsl:text> )</xsl:text>
 	</xsl:template>
 
 	<xsl:template name="result_assignment_for_simple_type" >
@@ -251,7 +399,8 @@
 		<xsl:param name="arg_index" select="position() - 1" />
 		<xsl:param name="type" select="@type" />
 		<xsl:param name="name" select="@name" />
-		<xsl:text>&#09;&#09;</xsl:text>
+		<xsl:param name="indent" select="'&#09;&#09;'" />
+		<xsl:value-of select="$indent"/>
 		<xsl:choose>
 			<xsl:when test="$type='bool'" >
 				<xsl:value-of select="$name"/>
@@ -336,9 +485,21 @@
 				<xsl:text>rpc_result->mutable_call_result()->set_int32_value( result );</xsl:text>
 			</xsl:when>
 			<xsl:when test="count( /xmlidl:idl/xmlidl:interfaces/xmlidl:interface[@name=$type] ) != 0" >
-				<xsl:text>&#09;&#09;NanoRpc::RpcObjectId object_id = object_manager_->RegisterInstance( new </xsl:text>
+				<!-- The implementation returned again as this interface is marshalled by the same stub. -->
+				<xsl:variable name="interface_name">
+					<xsl:call-template name="interface_name">
+						<xsl:with-param name="interface" select="/xmlidl:idl/xmlidl:interfaces/xmlidl:interface[@name=$type]" />
+					</xsl:call-template>
+				</xsl:variable>
+				<xsl:text>&#09;&#09;NanoRpc::RpcObjectId object_id = object_manager_->AddInstanceReference( result, </xsl:text>
+				<xsl:value-of select="$interface_name"/>
+				<xsl:text> );&#10;</xsl:text>
+				<xsl:text>&#09;&#09;if( object_id == 0 )&#10;</xsl:text>
+				<xsl:text>&#09;&#09;&#09;object_id = object_manager_->RegisterInstance( new </xsl:text>
 				<xsl:value-of select="$type"/>
-				<xsl:text>_Stub( object_manager_, result ) );&#10;</xsl:text>
+				<xsl:text>_Stub( object_manager_, result ), result, </xsl:text>
+				<xsl:value-of select="$interface_name"/>
+				<xsl:text> );&#10;</xsl:text>
 				<xsl:text>&#09;&#09;rpc_result->mutable_call_result()->set_object_id_value( object_id );&#10;</xsl:text>
 			</xsl:when>
 			<xsl:otherwise>
@@ -0,0 +1,283 @@
+// Measures the object lookups of the object manager against a map guarded by
+// a lock, with the given number of threads looking up the objects while
+// another thread keeps registering and deleting them.
+//
+// Usage: object_manager_benchmark [max_reader_count [milliseconds]]
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "atomic_operations.hpp"
+#include "rpc_lease_wheel.hpp"
+#include "rpc_object_manager.hpp"
+#include "synchronization_primitives.hpp"
+
+using namespace NanoRpc;
+
+namespace {
+
+const int ObjectCount = 1024;
+const int DefaultMaxReaderCount = 8;
+const unsigned int DefaultDuration = 2000;
+
+class NullService : public IRpcService {
+public:
+  void CallMethod(const RpcCall &, RpcResult *) {}
+};
+
+class ObjectTable {
+public:
+  virtual ~ObjectTable() {}
+  virtual const char *GetName() const = 0;
+
+  // Returns true if the object exists; the object is used before returning.
+  virtual bool Find(RpcObjectId object_id) = 0;
+
+  virtual RpcObjectId Register(IRpcService *object) = 0;
+  virtual void Delete(RpcObjectId object_id) = 0;
+};
+
+class ObjectManagerTable : public ObjectTable {
+public:
+  const char *GetName() const { return "object manager"; }
+
+  bool Find(RpcObjectId object_id) {
+    RpcObjectManager::ScopedReader reader(&object_manager_);
+    IRpcService *object = object_manager_.GetInstance(object_id);
+    return object != NULL && object->GetAsyncService() == NULL;
+  }
+
+  RpcObjectId Register(IRpcService *object) {
+    return object_manager_.RegisterInstance(object);
+  }
+
+  void Delete(RpcObjectId object_id) {
+    object_manager_.DeleteObject(object_id);
+  }
+
+private:
+  RpcObjectManager object_manager_;
+};
+
+class LockedMapTable : public ObjectTable {
+public:
+  LockedMapTable() : next_id_(1) {}
+
+  ~LockedMapTable() {
+    for (ObjectMap::iterator it = objects_.begin(); it != objects_.end(); ++it)
+      delete it->second;
+  }
+
+  const char *GetName() const { return "locked map"; }
+
+  bool Find(RpcObjectId object_id) {
+    ScopedLock lock(lock_);
+    ObjectMap::const_iterator it = objects_.find(object_id);
+    return it != objects_.end() && it->second->GetAsyncService() == NULL;
+  }
+
+  RpcObjectId Register(IRpcService *object) {
+    ScopedLock lock(lock_);
+    RpcObjectId object_id = next_id_++;
+    objects_[object_id] = object;
+    return object_id;
+  }
+
+  void Delete(RpcObjectId object_id) {
+    IRpcService *object = NULL;
+    {
+      ScopedLock lock(lock_);
+      ObjectMap::iterator it = objects_.find(object_id);
+      if (it == objects_.end())
+        return;
+      object = it->second;
+      objects_.erase(it);
+    }
+    delete object;
+  }
+
+private:
+  typedef std::map<RpcObjectId, IRpcService *> ObjectMap;
+
+  Lock lock_;
+  ObjectMap objects_;
+  RpcObjectId next_id_;
+};
+
+struct Run;
+
+struct Worker {
+  Run *run;
+  unsigned int seed;
+  unsigned long operation_count;
+
+#if defined(_WIN32)
+  HANDLE thread;
+#else
+  pthread_t thread;
+#endif
+};
+
+struct Run {
+  ObjectTable *table;
+  std::vector<RpcObjectId> object_ids;
+  volatile long is_stopping;
+};
+
+void ReaderProc(Worker *worker) {
+  Run *run = worker->run;
+  unsigned int seed = worker->seed;
+  unsigned long count = 0;
+  while (run->is_stopping == 0) {
+    // xorshift, so the threads do not contend on the generator.
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    run->table->Find(run->object_ids[seed % run->object_ids.size()]);
+    ++count;
+  }
+  worker->operation_count = count;
+}
+
+void WriterProc(Worker *worker) {
+  Run *run = worker->run;
+  unsigned long count = 0;
+  while (run->is_stopping == 0) {
+    run->table->Delete(run->table->Register(new NullService()));
+    ++count;
+  }
+  worker->operation_count = count;
+}
+
+#if defined(_WIN32)
+DWORD WINAPI ReaderThreadProc(void *parameter) {
+  ReaderProc(reinterpret_cast<Worker *>(parameter));
+  return 0;
+}
+
+DWORD WINAPI WriterThreadProc(void *parameter) {
+  WriterProc(reinterpret_cast<Worker *>(parameter));
+  return 0;
+}
+
+bool StartThread(Worker *worker, LPTHREAD_START_ROUTINE thread_proc) {
+  worker->thread = CreateThread(NULL, 0, thread_proc, worker, 0, NULL);
+  return worker->thread != NULL;
+}
+
+void JoinThread(Worker *worker) {
+  WaitForSingleObject(worker->thread, INFINITE);
+  CloseHandle(worker->thread);
+}
+
+void SleepFor(unsigned int milliseconds) { Sleep(milliseconds); }
+#else
+void *ReaderThreadProc(void *parameter) {
+  ReaderProc(reinterpret_cast<Worker *>(parameter));
+  return NULL;
+}
+
+void *WriterThreadProc(void *parameter) {
+  WriterProc(reinterpret_cast<Worker *>(parameter));
+  return NULL;
+}
+
+bool StartThread(Worker *worker, void *(*thread_proc)(void *)) {
+  return pthread_create(&worker->thread, NULL, thread_proc, worker) == 0;
+}
+
+void JoinThread(Worker *worker) { pthread_join(worker->thread, NULL); }
+
+void SleepFor(unsigned int milliseconds) { usleep(milliseconds * 1000); }
+#endif
+
+// Prints the lookups and the writes per second. Returns false if the
+// threads could not be started.
+bool RunBenchmark(ObjectTable *table, int reader_count,
+                  unsigned int duration) {
+  Run run;
+  run.table = table;
+  run.is_stopping = 0;
+  for (int i = 0; i < ObjectCount; ++i)
+    run.object_ids.push_back(table->Register(new NullService()));
+
+  // The last worker is the writer.
+  std::vector<Worker> workers(reader_count + 1);
+  int started_count = 0;
+  unsigned int start_time = RpcLeaseWheel::GetTickCount();
+  for (; started_count <= reader_count; ++started_count) {
+    Worker *worker = &workers[started_count];
+    worker->run = &run;
+    worker->seed = 2463534242u + started_count;
+    worker->operation_count = 0;
+    bool started = started_count < reader_count
+                       ? StartThread(worker, &ReaderThreadProc)
+                       : StartThread(worker, &WriterThreadProc);
+    if (!started)
+      break;
+  }
+
+  if (started_count > reader_count)
+    SleepFor(duration);
+
+  AtomicExchange(&run.is_stopping, 1);
+  for (int i = 0; i < started_count; ++i)
+    JoinThread(&workers[i]);
+  unsigned int elapsed = RpcLeaseWheel::GetTickCount() - start_time;
+
+  for (int i = 0; i < ObjectCount; ++i)
+    table->Delete(run.object_ids[i]);
+
+  if (started_count <= reader_count) {
+    fprintf(stderr, "Cannot start %d threads.\n", reader_count + 1);
+    return false;
+  }
+
+  unsigned long lookup_count = 0;
+  for (int i = 0; i < reader_count; ++i)
+    lookup_count += workers[i].operation_count;
+
+  double seconds = elapsed > 0 ? elapsed / 1000.0 : 0.001;
+  printf("%-16s %3d readers: %12.0f lookups/s %10.0f writes/s\n",
+         table->GetName(), reader_count, lookup_count / seconds,
+         workers[reader_count].operation_count / seconds);
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  int max_reader_count = DefaultMaxReaderCount;
+  unsigned int duration = DefaultDuration;
+  if (argc > 1)
+    max_reader_count = atoi(argv[1]);
+  if (argc > 2)
+    duration = static_cast<unsigned int>(atoi(argv[2]));
+
+  if (max_reader_count <= 0) {
+    fprintf(stderr,
+            "Usage: object_manager_benchmark "
+            "[max_reader_count [milliseconds]]\n");
+    return 1;
+  }
+
+  for (int reader_count = 1; reader_count <= max_reader_count;
+       reader_count *= 2) {
+    ObjectManagerTable object_manager_table;
+    LockedMapTable locked_map_table;
+    if (!RunBenchmark(&object_manager_table, reader_count, duration) ||
+        !RunBenchmark(&locked_map_table, reader_count, duration))
+      return 1;
+  }
+
+  return 0;
+}
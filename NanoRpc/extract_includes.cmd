@@ -1,24 +1,39 @@
 mkdir  "include\nano_rpc"
 
+copy "src\atomic_operations.hpp" "include\nano_rpc"
 copy "src\basictypes.hpp" "include\nano_rpc"
+copy "src\buffer_chain_output_stream.hpp" "include\nano_rpc"
 copy "src\buffer_pool.hpp" "include\nano_rpc"
 copy "src\callback.hpp" "include\nano_rpc"
+copy "src\io_completion_service.hpp" "include\nano_rpc"
+copy "src\message_frame_reader.hpp" "include\nano_rpc"
 copy "src\named_pipe_connector.hpp" "include\nano_rpc"
 copy "src\named_pipe_rpc_channel.hpp" "include\nano_rpc"
 copy "src\nano_rpc.hpp" "include\nano_rpc"
 copy "src\object_pool.hpp" "include\nano_rpc"
+copy "src\pending_call_table.hpp" "include\nano_rpc"
 copy "src\rpc_channel.hpp" "include\nano_rpc"
 copy "src\rpc_client.hpp" "include\nano_rpc"
+copy "src\rpc_completion_token.hpp" "include\nano_rpc"
 copy "src\rpc_controller.hpp" "include\nano_rpc"
+copy "src\rpc_coroutine.hpp" "include\nano_rpc"
 copy "src\rpc_event_service.hpp" "include\nano_rpc"
+copy "src\rpc_future.hpp" "include\nano_rpc"
+copy "src\rpc_lease_wheel.hpp" "include\nano_rpc"
 copy "src\rpc_message_sender.hpp" "include\nano_rpc"
 copy "src\rpc_object_manager.hpp" "include\nano_rpc"
+copy "src\rpc_object_table.hpp" "include\nano_rpc"
+copy "src\rpc_packed_parameters.hpp" "include\nano_rpc"
 copy "src\rpc_server.hpp" "include\nano_rpc"
 copy "src\rpc_service.hpp" "include\nano_rpc"
+copy "src\rpc_service_registry.hpp" "include\nano_rpc"
 copy "src\rpc_stub.hpp" "include\nano_rpc"
 copy "src\RpcMessageTypes.pb.h" "include\nano_rpc"
+copy "src\send_queue.hpp" "include\nano_rpc"
+copy "src\strand.hpp" "include\nano_rpc"
 copy "src\string_conversion.cpp" "include\nano_rpc"
 copy "src\string_conversion.hpp" "include\nano_rpc"
 copy "src\synchronization_primitives.hpp" "include\nano_rpc"
+copy "src\worker_pool.hpp" "include\nano_rpc"
 
 
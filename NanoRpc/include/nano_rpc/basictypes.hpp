@@ -5,6 +5,8 @@
 #if !defined(BASE_BASICTYPES_HPP__04F6B479_BD5F_428C_B8D3_ADA8CBCC21DD_)
 #define BASE_BASICTYPES_HPP__04F6B479_BD5F_428C_B8D3_ADA8CBCC21DD_
 
+#include <stddef.h>  // For size_t.
+
 #if !defined(DISALLOW_COPY_AND_ASSIGN)
 // A macro to disallow the copy constructor and operator= functions
 // This should be used in the private: declarations for a class
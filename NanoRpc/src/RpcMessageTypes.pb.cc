@@ -26,6 +26,15 @@ const ::google::protobuf::internal::GeneratedMessageReflection*
 const ::google::protobuf::Descriptor* RpcCall_descriptor_ = NULL;
 const ::google::protobuf::internal::GeneratedMessageReflection*
   RpcCall_reflection_ = NULL;
+const ::google::protobuf::Descriptor* RpcServiceBinding_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  RpcServiceBinding_reflection_ = NULL;
+const ::google::protobuf::Descriptor* RpcHandshake_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  RpcHandshake_reflection_ = NULL;
+const ::google::protobuf::Descriptor* RpcBatch_descriptor_ = NULL;
+const ::google::protobuf::internal::GeneratedMessageReflection*
+  RpcBatch_reflection_ = NULL;
 const ::google::protobuf::Descriptor* RpcMessage_descriptor_ = NULL;
 const ::google::protobuf::internal::GeneratedMessageReflection*
   RpcMessage_reflection_ = NULL;
@@ -89,12 +98,16 @@ void protobuf_AssignDesc_RpcMessageTypes_2eproto() {
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(RpcResult));
   RpcCall_descriptor_ = file->message_type(2);
-  static const int RpcCall_offsets_[5] = {
+  static const int RpcCall_offsets_[9] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcCall, service_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcCall, method_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcCall, parameters_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcCall, expects_result_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcCall, object_id_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcCall, method_ordinal_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcCall, target_call_id_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcCall, is_pipeline_target_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcCall, packed_parameters_),
   };
   RpcCall_reflection_ =
     new ::google::protobuf::internal::GeneratedMessageReflection(
@@ -107,11 +120,60 @@ void protobuf_AssignDesc_RpcMessageTypes_2eproto() {
       ::google::protobuf::DescriptorPool::generated_pool(),
       ::google::protobuf::MessageFactory::generated_factory(),
       sizeof(RpcCall));
-  RpcMessage_descriptor_ = file->message_type(3);
-  static const int RpcMessage_offsets_[3] = {
+  RpcServiceBinding_descriptor_ = file->message_type(3);
+  static const int RpcServiceBinding_offsets_[2] = {
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcServiceBinding, name_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcServiceBinding, object_id_),
+  };
+  RpcServiceBinding_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      RpcServiceBinding_descriptor_,
+      RpcServiceBinding::default_instance_,
+      RpcServiceBinding_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcServiceBinding, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcServiceBinding, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(RpcServiceBinding));
+  RpcHandshake_descriptor_ = file->message_type(4);
+  static const int RpcHandshake_offsets_[2] = {
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcHandshake, protocol_version_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcHandshake, services_),
+  };
+  RpcHandshake_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      RpcHandshake_descriptor_,
+      RpcHandshake::default_instance_,
+      RpcHandshake_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcHandshake, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcHandshake, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(RpcHandshake));
+  RpcBatch_descriptor_ = file->message_type(5);
+  static const int RpcBatch_offsets_[2] = {
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcBatch, calls_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcBatch, results_),
+  };
+  RpcBatch_reflection_ =
+    new ::google::protobuf::internal::GeneratedMessageReflection(
+      RpcBatch_descriptor_,
+      RpcBatch::default_instance_,
+      RpcBatch_offsets_,
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcBatch, _has_bits_[0]),
+      GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcBatch, _unknown_fields_),
+      -1,
+      ::google::protobuf::DescriptorPool::generated_pool(),
+      ::google::protobuf::MessageFactory::generated_factory(),
+      sizeof(RpcBatch));
+  RpcMessage_descriptor_ = file->message_type(6);
+  static const int RpcMessage_offsets_[4] = {
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcMessage, id_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcMessage, call_),
     GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcMessage, result_),
+    GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(RpcMessage, batch_),
   };
   RpcMessage_reflection_ =
     new ::google::protobuf::internal::GeneratedMessageReflection(
@@ -143,6 +205,12 @@ void protobuf_RegisterTypes(const ::std::string&) {
     RpcResult_descriptor_, &RpcResult::default_instance());
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
     RpcCall_descriptor_, &RpcCall::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    RpcServiceBinding_descriptor_, &RpcServiceBinding::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    RpcHandshake_descriptor_, &RpcHandshake::default_instance());
+  ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
+    RpcBatch_descriptor_, &RpcBatch::default_instance());
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedMessage(
     RpcMessage_descriptor_, &RpcMessage::default_instance());
 }
@@ -156,6 +224,12 @@ void protobuf_ShutdownFile_RpcMessageTypes_2eproto() {
   delete RpcResult_reflection_;
   delete RpcCall::default_instance_;
   delete RpcCall_reflection_;
+  delete RpcServiceBinding::default_instance_;
+  delete RpcServiceBinding_reflection_;
+  delete RpcHandshake::default_instance_;
+  delete RpcHandshake_reflection_;
+  delete RpcBatch::default_instance_;
+  delete RpcBatch_reflection_;
   delete RpcMessage::default_instance_;
   delete RpcMessage_reflection_;
 }
@@ -180,25 +254,40 @@ void protobuf_AddDesc_RpcMessageTypes_2eproto() {
     "object_id_value\030\021 \001(\r\"r\n\tRpcResult\022\"\n\006st"
     "atus\030\001 \001(\0162\022.NanoRpc.RpcStatus\022\025\n\rerror_"
     "message\030\002 \001(\t\022*\n\013call_result\030\003 \001(\0132\025.Nan"
-    "oRpc.RpcParameter\"\200\001\n\007RpcCall\022\017\n\007service"
+    "oRpc.RpcParameter\"\347\001\n\007RpcCall\022\017\n\007service"
     "\030\001 \001(\t\022\016\n\006method\030\002 \001(\t\022)\n\nparameters\030\003 \003"
     "(\0132\025.NanoRpc.RpcParameter\022\026\n\016expects_res"
-    "ult\030\004 \001(\010\022\021\n\tobject_id\030\005 \001(\r\"\\\n\nRpcMessa"
-    "ge\022\n\n\002id\030\001 \001(\005\022\036\n\004call\030\002 \001(\0132\020.NanoRpc.R"
-    "pcCall\022\"\n\006result\030\003 \001(\0132\022.NanoRpc.RpcResu"
-    "lt*\226\001\n\tRpcStatus\022\020\n\014RpcSucceeded\020\000\022\025\n\021Rp"
-    "cChannelFailure\020\001\022\024\n\020RpcUnknownMethod\020\002\022"
-    "\024\n\020RpcProtocolError\020\003\022\027\n\023RpcUnknownInter"
-    "face\020\004\022\033\n\027RpcInvalidCallParameter\020\005", 915);
+    "ult\030\004 \001(\010\022\021\n\tobject_id\030\005 \001(\r\022\026\n\016method_o"
+    "rdinal\030\006 \001(\r\022\026\n\016target_call_id\030\007 \001(\005\022\032\n\022"
+    "is_pipeline_target\030\010 \001(\010\022\031\n\021packed_param"
+    "eters\030\t \001(\014\"4\n\021RpcServiceBinding\022\014\n\004name"
+    "\030\001 \001(\t\022\021\n\tobject_id\030\002 \001(\r\"V\n\014RpcHandshak"
+    "e\022\030\n\020protocol_version\030\001 \001(\r\022,\n\010services\030"
+    "\002 \003(\0132\032.NanoRpc.RpcServiceBinding\"P\n\010Rpc"
+    "Batch\022\037\n\005calls\030\001 \003(\0132\020.NanoRpc.RpcCall\022#"
+    "\n\007results\030\002 \003(\0132\022.NanoRpc.RpcResult\"~\n\nR"
+    "pcMessage\022\n\n\002id\030\001 \001(\005\022\036\n\004call\030\002 \001(\0132\020.Na"
+    "noRpc.RpcCall\022\"\n\006result\030\003 \001(\0132\022.NanoRpc."
+    "RpcResult\022 \n\005batch\030\004 \001(\0132\021.NanoRpc.RpcBa"
+    "tch*\226\001\n\tRpcStatus\022\020\n\014RpcSucceeded\020\000\022\025\n\021R"
+    "pcChannelFailure\020\001\022\024\n\020RpcUnknownMethod\020\002"
+    "\022\024\n\020RpcProtocolError\020\003\022\027\n\023RpcUnknownInte"
+    "rface\020\004\022\033\n\027RpcInvalidCallParameter\020\005", 1276);
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
     "RpcMessageTypes.proto", &protobuf_RegisterTypes);
   RpcParameter::default_instance_ = new RpcParameter();
   RpcResult::default_instance_ = new RpcResult();
   RpcCall::default_instance_ = new RpcCall();
+  RpcServiceBinding::default_instance_ = new RpcServiceBinding();
+  RpcHandshake::default_instance_ = new RpcHandshake();
+  RpcBatch::default_instance_ = new RpcBatch();
   RpcMessage::default_instance_ = new RpcMessage();
   RpcParameter::default_instance_->InitAsDefaultInstance();
   RpcResult::default_instance_->InitAsDefaultInstance();
   RpcCall::default_instance_->InitAsDefaultInstance();
+  RpcServiceBinding::default_instance_->InitAsDefaultInstance();
+  RpcHandshake::default_instance_->InitAsDefaultInstance();
+  RpcBatch::default_instance_->InitAsDefaultInstance();
   RpcMessage::default_instance_->InitAsDefaultInstance();
   ::google::protobuf::internal::OnShutdown(&protobuf_ShutdownFile_RpcMessageTypes_2eproto);
 }
@@ -1420,6 +1509,10 @@ const int RpcCall::kMethodFieldNumber;
 const int RpcCall::kParametersFieldNumber;
 const int RpcCall::kExpectsResultFieldNumber;
 const int RpcCall::kObjectIdFieldNumber;
+const int RpcCall::kMethodOrdinalFieldNumber;
+const int RpcCall::kTargetCallIdFieldNumber;
+const int RpcCall::kIsPipelineTargetFieldNumber;
+const int RpcCall::kPackedParametersFieldNumber;
 #endif  // !_MSC_VER
 
 RpcCall::RpcCall()
@@ -1442,6 +1535,10 @@ void RpcCall::SharedCtor() {
   method_ = const_cast< ::std::string*>(&::google::protobuf::internal::kEmptyString);
   expects_result_ = false;
   object_id_ = 0u;
+  method_ordinal_ = 0u;
+  target_call_id_ = 0;
+  is_pipeline_target_ = false;
+  packed_parameters_ = const_cast< ::std::string*>(&::google::protobuf::internal::kEmptyString);
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
@@ -1456,6 +1553,9 @@ void RpcCall::SharedDtor() {
   if (method_ != &::google::protobuf::internal::kEmptyString) {
     delete method_;
   }
+  if (packed_parameters_ != &::google::protobuf::internal::kEmptyString) {
+    delete packed_parameters_;
+  }
   if (this != default_instance_) {
   }
 }
@@ -1494,6 +1594,16 @@ void RpcCall::Clear() {
     }
     expects_result_ = false;
     object_id_ = 0u;
+    method_ordinal_ = 0u;
+    target_call_id_ = 0;
+    is_pipeline_target_ = false;
+  }
+  if (_has_bits_[8 / 32] & (0xffu << (8 % 32))) {
+    if (has_packed_parameters()) {
+      if (packed_parameters_ != &::google::protobuf::internal::kEmptyString) {
+        packed_parameters_->clear();
+      }
+    }
   }
   parameters_.Clear();
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
@@ -1582,6 +1692,68 @@ bool RpcCall::MergePartialFromCodedStream(
         } else {
           goto handle_uninterpreted;
         }
+        if (input->ExpectTag(48)) goto parse_method_ordinal;
+        break;
+      }
+      
+      // optional uint32 method_ordinal = 6;
+      case 6: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_method_ordinal:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, &method_ordinal_)));
+          set_has_method_ordinal();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(56)) goto parse_target_call_id;
+        break;
+      }
+      
+      // optional int32 target_call_id = 7;
+      case 7: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_target_call_id:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
+                 input, &target_call_id_)));
+          set_has_target_call_id();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(64)) goto parse_is_pipeline_target;
+        break;
+      }
+      
+      // optional bool is_pipeline_target = 8;
+      case 8: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_is_pipeline_target:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   bool, ::google::protobuf::internal::WireFormatLite::TYPE_BOOL>(
+                 input, &is_pipeline_target_)));
+          set_has_is_pipeline_target();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(74)) goto parse_packed_parameters;
+        break;
+      }
+      
+      // optional bytes packed_parameters = 9;
+      case 9: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+         parse_packed_parameters:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadBytes(
+                input, this->mutable_packed_parameters()));
+        } else {
+          goto handle_uninterpreted;
+        }
         if (input->ExpectAtEnd()) return true;
         break;
       }
@@ -1638,6 +1810,27 @@ void RpcCall::SerializeWithCachedSizes(
     ::google::protobuf::internal::WireFormatLite::WriteUInt32(5, this->object_id(), output);
   }
   
+  // optional uint32 method_ordinal = 6;
+  if (has_method_ordinal()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32(6, this->method_ordinal(), output);
+  }
+  
+  // optional int32 target_call_id = 7;
+  if (has_target_call_id()) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt32(7, this->target_call_id(), output);
+  }
+  
+  // optional bool is_pipeline_target = 8;
+  if (has_is_pipeline_target()) {
+    ::google::protobuf::internal::WireFormatLite::WriteBool(8, this->is_pipeline_target(), output);
+  }
+  
+  // optional bytes packed_parameters = 9;
+  if (has_packed_parameters()) {
+    ::google::protobuf::internal::WireFormatLite::WriteBytes(
+      9, this->packed_parameters(), output);
+  }
+  
   if (!unknown_fields().empty()) {
     ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
         unknown_fields(), output);
@@ -1683,6 +1876,28 @@ void RpcCall::SerializeWithCachedSizes(
     target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(5, this->object_id(), target);
   }
   
+  // optional uint32 method_ordinal = 6;
+  if (has_method_ordinal()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(6, this->method_ordinal(), target);
+  }
+  
+  // optional int32 target_call_id = 7;
+  if (has_target_call_id()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(7, this->target_call_id(), target);
+  }
+  
+  // optional bool is_pipeline_target = 8;
+  if (has_is_pipeline_target()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteBoolToArray(8, this->is_pipeline_target(), target);
+  }
+  
+  // optional bytes packed_parameters = 9;
+  if (has_packed_parameters()) {
+    target =
+      ::google::protobuf::internal::WireFormatLite::WriteBytesToArray(
+        9, this->packed_parameters(), target);
+  }
+  
   if (!unknown_fields().empty()) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         unknown_fields(), target);
@@ -1720,6 +1935,34 @@ int RpcCall::ByteSize() const {
           this->object_id());
     }
     
+    // optional uint32 method_ordinal = 6;
+    if (has_method_ordinal()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt32Size(
+          this->method_ordinal());
+    }
+    
+    // optional int32 target_call_id = 7;
+    if (has_target_call_id()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(
+          this->target_call_id());
+    }
+    
+    // optional bool is_pipeline_target = 8;
+    if (has_is_pipeline_target()) {
+      total_size += 1 + 1;
+    }
+    
+  }
+  if (_has_bits_[8 / 32] & (0xffu << (8 % 32))) {
+    // optional bytes packed_parameters = 9;
+    if (has_packed_parameters()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::BytesSize(
+          this->packed_parameters());
+    }
+    
   }
   // repeated .NanoRpc.RpcParameter parameters = 3;
   total_size += 1 * this->parameters_size();
@@ -1768,6 +2011,20 @@ void RpcCall::MergeFrom(const RpcCall& from) {
     if (from.has_object_id()) {
       set_object_id(from.object_id());
     }
+    if (from.has_method_ordinal()) {
+      set_method_ordinal(from.method_ordinal());
+    }
+    if (from.has_target_call_id()) {
+      set_target_call_id(from.target_call_id());
+    }
+    if (from.has_is_pipeline_target()) {
+      set_is_pipeline_target(from.is_pipeline_target());
+    }
+  }
+  if (from._has_bits_[8 / 32] & (0xffu << (8 % 32))) {
+    if (from.has_packed_parameters()) {
+      set_packed_parameters(from.packed_parameters());
+    }
   }
   mutable_unknown_fields()->MergeFrom(from.unknown_fields());
 }
@@ -1796,6 +2053,10 @@ void RpcCall::Swap(RpcCall* other) {
     parameters_.Swap(&other->parameters_);
     std::swap(expects_result_, other->expects_result_);
     std::swap(object_id_, other->object_id_);
+    std::swap(method_ordinal_, other->method_ordinal_);
+    std::swap(target_call_id_, other->target_call_id_);
+    std::swap(is_pipeline_target_, other->is_pipeline_target_);
+    std::swap(packed_parameters_, other->packed_parameters_);
     std::swap(_has_bits_[0], other->_has_bits_[0]);
     _unknown_fields_.Swap(&other->_unknown_fields_);
     std::swap(_cached_size_, other->_cached_size_);
@@ -1814,122 +2075,107 @@ void RpcCall::Swap(RpcCall* other) {
 // ===================================================================
 
 #ifndef _MSC_VER
-const int RpcMessage::kIdFieldNumber;
-const int RpcMessage::kCallFieldNumber;
-const int RpcMessage::kResultFieldNumber;
+const int RpcServiceBinding::kNameFieldNumber;
+const int RpcServiceBinding::kObjectIdFieldNumber;
 #endif  // !_MSC_VER
 
-RpcMessage::RpcMessage()
+RpcServiceBinding::RpcServiceBinding()
   : ::google::protobuf::Message() {
   SharedCtor();
 }
 
-void RpcMessage::InitAsDefaultInstance() {
-  call_ = const_cast< ::NanoRpc::RpcCall*>(&::NanoRpc::RpcCall::default_instance());
-  result_ = const_cast< ::NanoRpc::RpcResult*>(&::NanoRpc::RpcResult::default_instance());
+void RpcServiceBinding::InitAsDefaultInstance() {
 }
 
-RpcMessage::RpcMessage(const RpcMessage& from)
+RpcServiceBinding::RpcServiceBinding(const RpcServiceBinding& from)
   : ::google::protobuf::Message() {
   SharedCtor();
   MergeFrom(from);
 }
 
-void RpcMessage::SharedCtor() {
+void RpcServiceBinding::SharedCtor() {
   _cached_size_ = 0;
-  id_ = 0;
-  call_ = NULL;
-  result_ = NULL;
+  name_ = const_cast< ::std::string*>(&::google::protobuf::internal::kEmptyString);
+  object_id_ = 0u;
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
 }
 
-RpcMessage::~RpcMessage() {
+RpcServiceBinding::~RpcServiceBinding() {
   SharedDtor();
 }
 
-void RpcMessage::SharedDtor() {
+void RpcServiceBinding::SharedDtor() {
+  if (name_ != &::google::protobuf::internal::kEmptyString) {
+    delete name_;
+  }
   if (this != default_instance_) {
-    delete call_;
-    delete result_;
   }
 }
 
-void RpcMessage::SetCachedSize(int size) const {
+void RpcServiceBinding::SetCachedSize(int size) const {
   GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
   _cached_size_ = size;
   GOOGLE_SAFE_CONCURRENT_WRITES_END();
 }
-const ::google::protobuf::Descriptor* RpcMessage::descriptor() {
+const ::google::protobuf::Descriptor* RpcServiceBinding::descriptor() {
   protobuf_AssignDescriptorsOnce();
-  return RpcMessage_descriptor_;
+  return RpcServiceBinding_descriptor_;
 }
 
-const RpcMessage& RpcMessage::default_instance() {
+const RpcServiceBinding& RpcServiceBinding::default_instance() {
   if (default_instance_ == NULL) protobuf_AddDesc_RpcMessageTypes_2eproto();  return *default_instance_;
 }
 
-RpcMessage* RpcMessage::default_instance_ = NULL;
+RpcServiceBinding* RpcServiceBinding::default_instance_ = NULL;
 
-RpcMessage* RpcMessage::New() const {
-  return new RpcMessage;
+RpcServiceBinding* RpcServiceBinding::New() const {
+  return new RpcServiceBinding;
 }
 
-void RpcMessage::Clear() {
+void RpcServiceBinding::Clear() {
   if (_has_bits_[0 / 32] & (0xffu << (0 % 32))) {
-    id_ = 0;
-    if (has_call()) {
-      if (call_ != NULL) call_->::NanoRpc::RpcCall::Clear();
-    }
-    if (has_result()) {
-      if (result_ != NULL) result_->::NanoRpc::RpcResult::Clear();
+    if (has_name()) {
+      if (name_ != &::google::protobuf::internal::kEmptyString) {
+        name_->clear();
+      }
     }
+    object_id_ = 0u;
   }
   ::memset(_has_bits_, 0, sizeof(_has_bits_));
   mutable_unknown_fields()->Clear();
 }
 
-bool RpcMessage::MergePartialFromCodedStream(
+bool RpcServiceBinding::MergePartialFromCodedStream(
     ::google::protobuf::io::CodedInputStream* input) {
 #define DO_(EXPRESSION) if (!(EXPRESSION)) return false
   ::google::protobuf::uint32 tag;
   while ((tag = input->ReadTag()) != 0) {
     switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
-      // optional int32 id = 1;
+      // optional string name = 1;
       case 1: {
-        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
-            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
-          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
-                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
-                 input, &id_)));
-          set_has_id();
-        } else {
-          goto handle_uninterpreted;
-        }
-        if (input->ExpectTag(18)) goto parse_call;
-        break;
-      }
-      
-      // optional .NanoRpc.RpcCall call = 2;
-      case 2: {
         if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
             ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
-         parse_call:
-          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
-               input, mutable_call()));
+          DO_(::google::protobuf::internal::WireFormatLite::ReadString(
+                input, this->mutable_name()));
+          ::google::protobuf::internal::WireFormat::VerifyUTF8String(
+            this->name().data(), this->name().length(),
+            ::google::protobuf::internal::WireFormat::PARSE);
         } else {
           goto handle_uninterpreted;
         }
-        if (input->ExpectTag(26)) goto parse_result;
+        if (input->ExpectTag(16)) goto parse_object_id;
         break;
       }
       
-      // optional .NanoRpc.RpcResult result = 3;
-      case 3: {
+      // optional uint32 object_id = 2;
+      case 2: {
         if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
-            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
-         parse_result:
-          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
-               input, mutable_result()));
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+         parse_object_id:
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, &object_id_)));
+          set_has_object_id();
         } else {
           goto handle_uninterpreted;
         }
@@ -1953,23 +2199,20 @@ bool RpcMessage::MergePartialFromCodedStream(
 #undef DO_
 }
 
-void RpcMessage::SerializeWithCachedSizes(
+void RpcServiceBinding::SerializeWithCachedSizes(
     ::google::protobuf::io::CodedOutputStream* output) const {
-  // optional int32 id = 1;
-  if (has_id()) {
-    ::google::protobuf::internal::WireFormatLite::WriteInt32(1, this->id(), output);
-  }
-  
-  // optional .NanoRpc.RpcCall call = 2;
-  if (has_call()) {
-    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
-      2, this->call(), output);
+  // optional string name = 1;
+  if (has_name()) {
+    ::google::protobuf::internal::WireFormat::VerifyUTF8String(
+      this->name().data(), this->name().length(),
+      ::google::protobuf::internal::WireFormat::SERIALIZE);
+    ::google::protobuf::internal::WireFormatLite::WriteString(
+      1, this->name(), output);
   }
   
-  // optional .NanoRpc.RpcResult result = 3;
-  if (has_result()) {
-    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
-      3, this->result(), output);
+  // optional uint32 object_id = 2;
+  if (has_object_id()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32(2, this->object_id(), output);
   }
   
   if (!unknown_fields().empty()) {
@@ -1978,25 +2221,21 @@ void RpcMessage::SerializeWithCachedSizes(
   }
 }
 
-::google::protobuf::uint8* RpcMessage::SerializeWithCachedSizesToArray(
+::google::protobuf::uint8* RpcServiceBinding::SerializeWithCachedSizesToArray(
     ::google::protobuf::uint8* target) const {
-  // optional int32 id = 1;
-  if (has_id()) {
-    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(1, this->id(), target);
-  }
-  
-  // optional .NanoRpc.RpcCall call = 2;
-  if (has_call()) {
-    target = ::google::protobuf::internal::WireFormatLite::
-      WriteMessageNoVirtualToArray(
-        2, this->call(), target);
+  // optional string name = 1;
+  if (has_name()) {
+    ::google::protobuf::internal::WireFormat::VerifyUTF8String(
+      this->name().data(), this->name().length(),
+      ::google::protobuf::internal::WireFormat::SERIALIZE);
+    target =
+      ::google::protobuf::internal::WireFormatLite::WriteStringToArray(
+        1, this->name(), target);
   }
   
-  // optional .NanoRpc.RpcResult result = 3;
-  if (has_result()) {
-    target = ::google::protobuf::internal::WireFormatLite::
-      WriteMessageNoVirtualToArray(
-        3, this->result(), target);
+  // optional uint32 object_id = 2;
+  if (has_object_id()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(2, this->object_id(), target);
   }
   
   if (!unknown_fields().empty()) {
@@ -2006,29 +2245,22 @@ void RpcMessage::SerializeWithCachedSizes(
   return target;
 }
 
-int RpcMessage::ByteSize() const {
+int RpcServiceBinding::ByteSize() const {
   int total_size = 0;
   
   if (_has_bits_[0 / 32] & (0xffu << (0 % 32))) {
-    // optional int32 id = 1;
-    if (has_id()) {
+    // optional string name = 1;
+    if (has_name()) {
       total_size += 1 +
-        ::google::protobuf::internal::WireFormatLite::Int32Size(
-          this->id());
-    }
-    
-    // optional .NanoRpc.RpcCall call = 2;
-    if (has_call()) {
-      total_size += 1 +
-        ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
-          this->call());
+        ::google::protobuf::internal::WireFormatLite::StringSize(
+          this->name());
     }
     
-    // optional .NanoRpc.RpcResult result = 3;
-    if (has_result()) {
+    // optional uint32 object_id = 2;
+    if (has_object_id()) {
       total_size += 1 +
-        ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
-          this->result());
+        ::google::protobuf::internal::WireFormatLite::UInt32Size(
+          this->object_id());
     }
     
   }
@@ -2043,10 +2275,10 @@ int RpcMessage::ByteSize() const {
   return total_size;
 }
 
-void RpcMessage::MergeFrom(const ::google::protobuf::Message& from) {
+void RpcServiceBinding::MergeFrom(const ::google::protobuf::Message& from) {
   GOOGLE_CHECK_NE(&from, this);
-  const RpcMessage* source =
-    ::google::protobuf::internal::dynamic_cast_if_available<const RpcMessage*>(
+  const RpcServiceBinding* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const RpcServiceBinding*>(
       &from);
   if (source == NULL) {
     ::google::protobuf::internal::ReflectionOps::Merge(from, this);
@@ -2055,17 +2287,843 @@ void RpcMessage::MergeFrom(const ::google::protobuf::Message& from) {
   }
 }
 
-void RpcMessage::MergeFrom(const RpcMessage& from) {
+void RpcServiceBinding::MergeFrom(const RpcServiceBinding& from) {
   GOOGLE_CHECK_NE(&from, this);
   if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
-    if (from.has_id()) {
-      set_id(from.id());
+    if (from.has_name()) {
+      set_name(from.name());
     }
-    if (from.has_call()) {
-      mutable_call()->::NanoRpc::RpcCall::MergeFrom(from.call());
+    if (from.has_object_id()) {
+      set_object_id(from.object_id());
     }
-    if (from.has_result()) {
-      mutable_result()->::NanoRpc::RpcResult::MergeFrom(from.result());
+  }
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void RpcServiceBinding::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void RpcServiceBinding::CopyFrom(const RpcServiceBinding& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool RpcServiceBinding::IsInitialized() const {
+  
+  return true;
+}
+
+void RpcServiceBinding::Swap(RpcServiceBinding* other) {
+  if (other != this) {
+    std::swap(name_, other->name_);
+    std::swap(object_id_, other->object_id_);
+    std::swap(_has_bits_[0], other->_has_bits_[0]);
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata RpcServiceBinding::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = RpcServiceBinding_descriptor_;
+  metadata.reflection = RpcServiceBinding_reflection_;
+  return metadata;
+}
+
+
+// ===================================================================
+
+#ifndef _MSC_VER
+const int RpcHandshake::kProtocolVersionFieldNumber;
+const int RpcHandshake::kServicesFieldNumber;
+#endif  // !_MSC_VER
+
+RpcHandshake::RpcHandshake()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+}
+
+void RpcHandshake::InitAsDefaultInstance() {
+}
+
+RpcHandshake::RpcHandshake(const RpcHandshake& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+}
+
+void RpcHandshake::SharedCtor() {
+  _cached_size_ = 0;
+  protocol_version_ = 0u;
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+RpcHandshake::~RpcHandshake() {
+  SharedDtor();
+}
+
+void RpcHandshake::SharedDtor() {
+  if (this != default_instance_) {
+  }
+}
+
+void RpcHandshake::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* RpcHandshake::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return RpcHandshake_descriptor_;
+}
+
+const RpcHandshake& RpcHandshake::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_RpcMessageTypes_2eproto();  return *default_instance_;
+}
+
+RpcHandshake* RpcHandshake::default_instance_ = NULL;
+
+RpcHandshake* RpcHandshake::New() const {
+  return new RpcHandshake;
+}
+
+void RpcHandshake::Clear() {
+  if (_has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    protocol_version_ = 0u;
+  }
+  services_.Clear();
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool RpcHandshake::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) return false
+  ::google::protobuf::uint32 tag;
+  while ((tag = input->ReadTag()) != 0) {
+    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // optional uint32 protocol_version = 1;
+      case 1: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, &protocol_version_)));
+          set_has_protocol_version();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(18)) goto parse_services;
+        break;
+      }
+      
+      // repeated .NanoRpc.RpcServiceBinding services = 2;
+      case 2: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+         parse_services:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
+                input, add_services()));
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(18)) goto parse_services;
+        if (input->ExpectAtEnd()) return true;
+        break;
+      }
+      
+      default: {
+      handle_uninterpreted:
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          return true;
+        }
+        DO_(::google::protobuf::internal::WireFormat::SkipField(
+              input, tag, mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+  return true;
+#undef DO_
+}
+
+void RpcHandshake::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // optional uint32 protocol_version = 1;
+  if (has_protocol_version()) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32(1, this->protocol_version(), output);
+  }
+  
+  // repeated .NanoRpc.RpcServiceBinding services = 2;
+  for (int i = 0; i < this->services_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
+      2, this->services(i), output);
+  }
+  
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+}
+
+::google::protobuf::uint8* RpcHandshake::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // optional uint32 protocol_version = 1;
+  if (has_protocol_version()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(1, this->protocol_version(), target);
+  }
+  
+  // repeated .NanoRpc.RpcServiceBinding services = 2;
+  for (int i = 0; i < this->services_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteMessageNoVirtualToArray(
+        2, this->services(i), target);
+  }
+  
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  return target;
+}
+
+int RpcHandshake::ByteSize() const {
+  int total_size = 0;
+  
+  if (_has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    // optional uint32 protocol_version = 1;
+    if (has_protocol_version()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::UInt32Size(
+          this->protocol_version());
+    }
+    
+  }
+  // repeated .NanoRpc.RpcServiceBinding services = 2;
+  total_size += 1 * this->services_size();
+  for (int i = 0; i < this->services_size(); i++) {
+    total_size +=
+      ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
+        this->services(i));
+  }
+  
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void RpcHandshake::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const RpcHandshake* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const RpcHandshake*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void RpcHandshake::MergeFrom(const RpcHandshake& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  services_.MergeFrom(from.services_);
+  if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    if (from.has_protocol_version()) {
+      set_protocol_version(from.protocol_version());
+    }
+  }
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void RpcHandshake::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void RpcHandshake::CopyFrom(const RpcHandshake& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool RpcHandshake::IsInitialized() const {
+  
+  return true;
+}
+
+void RpcHandshake::Swap(RpcHandshake* other) {
+  if (other != this) {
+    std::swap(protocol_version_, other->protocol_version_);
+    services_.Swap(&other->services_);
+    std::swap(_has_bits_[0], other->_has_bits_[0]);
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata RpcHandshake::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = RpcHandshake_descriptor_;
+  metadata.reflection = RpcHandshake_reflection_;
+  return metadata;
+}
+
+
+// ===================================================================
+
+#ifndef _MSC_VER
+const int RpcBatch::kCallsFieldNumber;
+const int RpcBatch::kResultsFieldNumber;
+#endif  // !_MSC_VER
+
+RpcBatch::RpcBatch()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+}
+
+void RpcBatch::InitAsDefaultInstance() {
+}
+
+RpcBatch::RpcBatch(const RpcBatch& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+}
+
+void RpcBatch::SharedCtor() {
+  _cached_size_ = 0;
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+RpcBatch::~RpcBatch() {
+  SharedDtor();
+}
+
+void RpcBatch::SharedDtor() {
+  if (this != default_instance_) {
+  }
+}
+
+void RpcBatch::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* RpcBatch::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return RpcBatch_descriptor_;
+}
+
+const RpcBatch& RpcBatch::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_RpcMessageTypes_2eproto();  return *default_instance_;
+}
+
+RpcBatch* RpcBatch::default_instance_ = NULL;
+
+RpcBatch* RpcBatch::New() const {
+  return new RpcBatch;
+}
+
+void RpcBatch::Clear() {
+  calls_.Clear();
+  results_.Clear();
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool RpcBatch::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) return false
+  ::google::protobuf::uint32 tag;
+  while ((tag = input->ReadTag()) != 0) {
+    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // repeated .NanoRpc.RpcCall calls = 1;
+      case 1: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+         parse_calls:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
+                input, add_calls()));
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(10)) goto parse_calls;
+        if (input->ExpectTag(18)) goto parse_results;
+        break;
+      }
+      
+      // repeated .NanoRpc.RpcResult results = 2;
+      case 2: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+         parse_results:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
+                input, add_results()));
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(18)) goto parse_results;
+        if (input->ExpectAtEnd()) return true;
+        break;
+      }
+      
+      default: {
+      handle_uninterpreted:
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          return true;
+        }
+        DO_(::google::protobuf::internal::WireFormat::SkipField(
+              input, tag, mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+  return true;
+#undef DO_
+}
+
+void RpcBatch::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // repeated .NanoRpc.RpcCall calls = 1;
+  for (int i = 0; i < this->calls_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
+      1, this->calls(i), output);
+  }
+  
+  // repeated .NanoRpc.RpcResult results = 2;
+  for (int i = 0; i < this->results_size(); i++) {
+    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
+      2, this->results(i), output);
+  }
+  
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+}
+
+::google::protobuf::uint8* RpcBatch::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // repeated .NanoRpc.RpcCall calls = 1;
+  for (int i = 0; i < this->calls_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteMessageNoVirtualToArray(
+        1, this->calls(i), target);
+  }
+  
+  // repeated .NanoRpc.RpcResult results = 2;
+  for (int i = 0; i < this->results_size(); i++) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteMessageNoVirtualToArray(
+        2, this->results(i), target);
+  }
+  
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  return target;
+}
+
+int RpcBatch::ByteSize() const {
+  int total_size = 0;
+  
+  // repeated .NanoRpc.RpcCall calls = 1;
+  total_size += 1 * this->calls_size();
+  for (int i = 0; i < this->calls_size(); i++) {
+    total_size +=
+      ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
+        this->calls(i));
+  }
+  
+  // repeated .NanoRpc.RpcResult results = 2;
+  total_size += 1 * this->results_size();
+  for (int i = 0; i < this->results_size(); i++) {
+    total_size +=
+      ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
+        this->results(i));
+  }
+  
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void RpcBatch::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const RpcBatch* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const RpcBatch*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void RpcBatch::MergeFrom(const RpcBatch& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  calls_.MergeFrom(from.calls_);
+  results_.MergeFrom(from.results_);
+  mutable_unknown_fields()->MergeFrom(from.unknown_fields());
+}
+
+void RpcBatch::CopyFrom(const ::google::protobuf::Message& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void RpcBatch::CopyFrom(const RpcBatch& from) {
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool RpcBatch::IsInitialized() const {
+  
+  return true;
+}
+
+void RpcBatch::Swap(RpcBatch* other) {
+  if (other != this) {
+    calls_.Swap(&other->calls_);
+    results_.Swap(&other->results_);
+    std::swap(_has_bits_[0], other->_has_bits_[0]);
+    _unknown_fields_.Swap(&other->_unknown_fields_);
+    std::swap(_cached_size_, other->_cached_size_);
+  }
+}
+
+::google::protobuf::Metadata RpcBatch::GetMetadata() const {
+  protobuf_AssignDescriptorsOnce();
+  ::google::protobuf::Metadata metadata;
+  metadata.descriptor = RpcBatch_descriptor_;
+  metadata.reflection = RpcBatch_reflection_;
+  return metadata;
+}
+
+
+// ===================================================================
+
+#ifndef _MSC_VER
+const int RpcMessage::kIdFieldNumber;
+const int RpcMessage::kCallFieldNumber;
+const int RpcMessage::kResultFieldNumber;
+const int RpcMessage::kBatchFieldNumber;
+#endif  // !_MSC_VER
+
+RpcMessage::RpcMessage()
+  : ::google::protobuf::Message() {
+  SharedCtor();
+}
+
+void RpcMessage::InitAsDefaultInstance() {
+  call_ = const_cast< ::NanoRpc::RpcCall*>(&::NanoRpc::RpcCall::default_instance());
+  result_ = const_cast< ::NanoRpc::RpcResult*>(&::NanoRpc::RpcResult::default_instance());
+  batch_ = const_cast< ::NanoRpc::RpcBatch*>(&::NanoRpc::RpcBatch::default_instance());
+}
+
+RpcMessage::RpcMessage(const RpcMessage& from)
+  : ::google::protobuf::Message() {
+  SharedCtor();
+  MergeFrom(from);
+}
+
+void RpcMessage::SharedCtor() {
+  _cached_size_ = 0;
+  id_ = 0;
+  call_ = NULL;
+  result_ = NULL;
+  batch_ = NULL;
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+}
+
+RpcMessage::~RpcMessage() {
+  SharedDtor();
+}
+
+void RpcMessage::SharedDtor() {
+  if (this != default_instance_) {
+    delete call_;
+    delete result_;
+    delete batch_;
+  }
+}
+
+void RpcMessage::SetCachedSize(int size) const {
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+}
+const ::google::protobuf::Descriptor* RpcMessage::descriptor() {
+  protobuf_AssignDescriptorsOnce();
+  return RpcMessage_descriptor_;
+}
+
+const RpcMessage& RpcMessage::default_instance() {
+  if (default_instance_ == NULL) protobuf_AddDesc_RpcMessageTypes_2eproto();  return *default_instance_;
+}
+
+RpcMessage* RpcMessage::default_instance_ = NULL;
+
+RpcMessage* RpcMessage::New() const {
+  return new RpcMessage;
+}
+
+void RpcMessage::Clear() {
+  if (_has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    id_ = 0;
+    if (has_call()) {
+      if (call_ != NULL) call_->::NanoRpc::RpcCall::Clear();
+    }
+    if (has_result()) {
+      if (result_ != NULL) result_->::NanoRpc::RpcResult::Clear();
+    }
+    if (has_batch()) {
+      if (batch_ != NULL) batch_->::NanoRpc::RpcBatch::Clear();
+    }
+  }
+  ::memset(_has_bits_, 0, sizeof(_has_bits_));
+  mutable_unknown_fields()->Clear();
+}
+
+bool RpcMessage::MergePartialFromCodedStream(
+    ::google::protobuf::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!(EXPRESSION)) return false
+  ::google::protobuf::uint32 tag;
+  while ((tag = input->ReadTag()) != 0) {
+    switch (::google::protobuf::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // optional int32 id = 1;
+      case 1: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_VARINT) {
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::int32, ::google::protobuf::internal::WireFormatLite::TYPE_INT32>(
+                 input, &id_)));
+          set_has_id();
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(18)) goto parse_call;
+        break;
+      }
+      
+      // optional .NanoRpc.RpcCall call = 2;
+      case 2: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+         parse_call:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
+               input, mutable_call()));
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(26)) goto parse_result;
+        break;
+      }
+      
+      // optional .NanoRpc.RpcResult result = 3;
+      case 3: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+         parse_result:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
+               input, mutable_result()));
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectTag(34)) goto parse_batch;
+        break;
+      }
+      
+      // optional .NanoRpc.RpcBatch batch = 4;
+      case 4: {
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+         parse_batch:
+          DO_(::google::protobuf::internal::WireFormatLite::ReadMessageNoVirtual(
+               input, mutable_batch()));
+        } else {
+          goto handle_uninterpreted;
+        }
+        if (input->ExpectAtEnd()) return true;
+        break;
+      }
+      
+      default: {
+      handle_uninterpreted:
+        if (::google::protobuf::internal::WireFormatLite::GetTagWireType(tag) ==
+            ::google::protobuf::internal::WireFormatLite::WIRETYPE_END_GROUP) {
+          return true;
+        }
+        DO_(::google::protobuf::internal::WireFormat::SkipField(
+              input, tag, mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+  return true;
+#undef DO_
+}
+
+void RpcMessage::SerializeWithCachedSizes(
+    ::google::protobuf::io::CodedOutputStream* output) const {
+  // optional int32 id = 1;
+  if (has_id()) {
+    ::google::protobuf::internal::WireFormatLite::WriteInt32(1, this->id(), output);
+  }
+  
+  // optional .NanoRpc.RpcCall call = 2;
+  if (has_call()) {
+    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
+      2, this->call(), output);
+  }
+  
+  // optional .NanoRpc.RpcResult result = 3;
+  if (has_result()) {
+    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
+      3, this->result(), output);
+  }
+  
+  // optional .NanoRpc.RpcBatch batch = 4;
+  if (has_batch()) {
+    ::google::protobuf::internal::WireFormatLite::WriteMessageMaybeToArray(
+      4, this->batch(), output);
+  }
+  
+  if (!unknown_fields().empty()) {
+    ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
+        unknown_fields(), output);
+  }
+}
+
+::google::protobuf::uint8* RpcMessage::SerializeWithCachedSizesToArray(
+    ::google::protobuf::uint8* target) const {
+  // optional int32 id = 1;
+  if (has_id()) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteInt32ToArray(1, this->id(), target);
+  }
+  
+  // optional .NanoRpc.RpcCall call = 2;
+  if (has_call()) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteMessageNoVirtualToArray(
+        2, this->call(), target);
+  }
+  
+  // optional .NanoRpc.RpcResult result = 3;
+  if (has_result()) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteMessageNoVirtualToArray(
+        3, this->result(), target);
+  }
+  
+  // optional .NanoRpc.RpcBatch batch = 4;
+  if (has_batch()) {
+    target = ::google::protobuf::internal::WireFormatLite::
+      WriteMessageNoVirtualToArray(
+        4, this->batch(), target);
+  }
+  
+  if (!unknown_fields().empty()) {
+    target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
+        unknown_fields(), target);
+  }
+  return target;
+}
+
+int RpcMessage::ByteSize() const {
+  int total_size = 0;
+  
+  if (_has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    // optional int32 id = 1;
+    if (has_id()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::Int32Size(
+          this->id());
+    }
+    
+    // optional .NanoRpc.RpcCall call = 2;
+    if (has_call()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
+          this->call());
+    }
+    
+    // optional .NanoRpc.RpcResult result = 3;
+    if (has_result()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
+          this->result());
+    }
+    
+    // optional .NanoRpc.RpcBatch batch = 4;
+    if (has_batch()) {
+      total_size += 1 +
+        ::google::protobuf::internal::WireFormatLite::MessageSizeNoVirtual(
+          this->batch());
+    }
+    
+  }
+  if (!unknown_fields().empty()) {
+    total_size +=
+      ::google::protobuf::internal::WireFormat::ComputeUnknownFieldsSize(
+        unknown_fields());
+  }
+  GOOGLE_SAFE_CONCURRENT_WRITES_BEGIN();
+  _cached_size_ = total_size;
+  GOOGLE_SAFE_CONCURRENT_WRITES_END();
+  return total_size;
+}
+
+void RpcMessage::MergeFrom(const ::google::protobuf::Message& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  const RpcMessage* source =
+    ::google::protobuf::internal::dynamic_cast_if_available<const RpcMessage*>(
+      &from);
+  if (source == NULL) {
+    ::google::protobuf::internal::ReflectionOps::Merge(from, this);
+  } else {
+    MergeFrom(*source);
+  }
+}
+
+void RpcMessage::MergeFrom(const RpcMessage& from) {
+  GOOGLE_CHECK_NE(&from, this);
+  if (from._has_bits_[0 / 32] & (0xffu << (0 % 32))) {
+    if (from.has_id()) {
+      set_id(from.id());
+    }
+    if (from.has_call()) {
+      mutable_call()->::NanoRpc::RpcCall::MergeFrom(from.call());
+    }
+    if (from.has_result()) {
+      mutable_result()->::NanoRpc::RpcResult::MergeFrom(from.result());
+    }
+    if (from.has_batch()) {
+      mutable_batch()->::NanoRpc::RpcBatch::MergeFrom(from.batch());
     }
   }
   mutable_unknown_fields()->MergeFrom(from.unknown_fields());
@@ -2093,6 +3151,7 @@ void RpcMessage::Swap(RpcMessage* other) {
     std::swap(id_, other->id_);
     std::swap(call_, other->call_);
     std::swap(result_, other->result_);
+    std::swap(batch_, other->batch_);
     std::swap(_has_bits_[0], other->_has_bits_[0]);
     _unknown_fields_.Swap(&other->_unknown_fields_);
     std::swap(_cached_size_, other->_cached_size_);
@@ -35,6 +35,9 @@ void protobuf_ShutdownFile_RpcMessageTypes_2eproto();
 class RpcParameter;
 class RpcResult;
 class RpcCall;
+class RpcServiceBinding;
+class RpcHandshake;
+class RpcBatch;
 class RpcMessage;
 
 enum RpcStatus {
@@ -521,6 +524,38 @@ class RpcCall : public ::google::protobuf::Message {
   inline ::google::protobuf::uint32 object_id() const;
   inline void set_object_id(::google::protobuf::uint32 value);
   
+  // optional uint32 method_ordinal = 6;
+  inline bool has_method_ordinal() const;
+  inline void clear_method_ordinal();
+  static const int kMethodOrdinalFieldNumber = 6;
+  inline ::google::protobuf::uint32 method_ordinal() const;
+  inline void set_method_ordinal(::google::protobuf::uint32 value);
+  
+  // optional int32 target_call_id = 7;
+  inline bool has_target_call_id() const;
+  inline void clear_target_call_id();
+  static const int kTargetCallIdFieldNumber = 7;
+  inline ::google::protobuf::int32 target_call_id() const;
+  inline void set_target_call_id(::google::protobuf::int32 value);
+  
+  // optional bool is_pipeline_target = 8;
+  inline bool has_is_pipeline_target() const;
+  inline void clear_is_pipeline_target();
+  static const int kIsPipelineTargetFieldNumber = 8;
+  inline bool is_pipeline_target() const;
+  inline void set_is_pipeline_target(bool value);
+  
+  // optional bytes packed_parameters = 9;
+  inline bool has_packed_parameters() const;
+  inline void clear_packed_parameters();
+  static const int kPackedParametersFieldNumber = 9;
+  inline const ::std::string& packed_parameters() const;
+  inline void set_packed_parameters(const ::std::string& value);
+  inline void set_packed_parameters(const char* value);
+  inline void set_packed_parameters(const void* value, size_t size);
+  inline ::std::string* mutable_packed_parameters();
+  inline ::std::string* release_packed_parameters();
+  
   // @@protoc_insertion_point(class_scope:NanoRpc.RpcCall)
  private:
   inline void set_has_service();
@@ -531,17 +566,29 @@ class RpcCall : public ::google::protobuf::Message {
   inline void clear_has_expects_result();
   inline void set_has_object_id();
   inline void clear_has_object_id();
+  inline void set_has_method_ordinal();
+  inline void clear_has_method_ordinal();
+  inline void set_has_target_call_id();
+  inline void clear_has_target_call_id();
+  inline void set_has_is_pipeline_target();
+  inline void clear_has_is_pipeline_target();
+  inline void set_has_packed_parameters();
+  inline void clear_has_packed_parameters();
   
   ::google::protobuf::UnknownFieldSet _unknown_fields_;
   
   ::std::string* service_;
   ::std::string* method_;
   ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcParameter > parameters_;
-  bool expects_result_;
   ::google::protobuf::uint32 object_id_;
+  ::google::protobuf::uint32 method_ordinal_;
+  bool expects_result_;
+  bool is_pipeline_target_;
+  ::google::protobuf::int32 target_call_id_;
+  ::std::string* packed_parameters_;
   
   mutable int _cached_size_;
-  ::google::protobuf::uint32 _has_bits_[(5 + 31) / 32];
+  ::google::protobuf::uint32 _has_bits_[(9 + 31) / 32];
   
   friend void  protobuf_AddDesc_RpcMessageTypes_2eproto();
   friend void protobuf_AssignDesc_RpcMessageTypes_2eproto();
@@ -552,6 +599,295 @@ class RpcCall : public ::google::protobuf::Message {
 };
 // -------------------------------------------------------------------
 
+class RpcServiceBinding : public ::google::protobuf::Message {
+ public:
+  RpcServiceBinding();
+  virtual ~RpcServiceBinding();
+  
+  RpcServiceBinding(const RpcServiceBinding& from);
+  
+  inline RpcServiceBinding& operator=(const RpcServiceBinding& from) {
+    CopyFrom(from);
+    return *this;
+  }
+  
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
+  
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
+  
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const RpcServiceBinding& default_instance();
+  
+  void Swap(RpcServiceBinding* other);
+  
+  // implements Message ----------------------------------------------
+  
+  RpcServiceBinding* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const RpcServiceBinding& from);
+  void MergeFrom(const RpcServiceBinding& from);
+  void Clear();
+  bool IsInitialized() const;
+  
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+  
+  ::google::protobuf::Metadata GetMetadata() const;
+  
+  // nested types ----------------------------------------------------
+  
+  // accessors -------------------------------------------------------
+  
+  // optional string name = 1;
+  inline bool has_name() const;
+  inline void clear_name();
+  static const int kNameFieldNumber = 1;
+  inline const ::std::string& name() const;
+  inline void set_name(const ::std::string& value);
+  inline void set_name(const char* value);
+  inline void set_name(const char* value, size_t size);
+  inline ::std::string* mutable_name();
+  inline ::std::string* release_name();
+  
+  // optional uint32 object_id = 2;
+  inline bool has_object_id() const;
+  inline void clear_object_id();
+  static const int kObjectIdFieldNumber = 2;
+  inline ::google::protobuf::uint32 object_id() const;
+  inline void set_object_id(::google::protobuf::uint32 value);
+  
+  // @@protoc_insertion_point(class_scope:NanoRpc.RpcServiceBinding)
+ private:
+  inline void set_has_name();
+  inline void clear_has_name();
+  inline void set_has_object_id();
+  inline void clear_has_object_id();
+  
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
+  
+  ::std::string* name_;
+  ::google::protobuf::uint32 object_id_;
+  
+  mutable int _cached_size_;
+  ::google::protobuf::uint32 _has_bits_[(2 + 31) / 32];
+  
+  friend void  protobuf_AddDesc_RpcMessageTypes_2eproto();
+  friend void protobuf_AssignDesc_RpcMessageTypes_2eproto();
+  friend void protobuf_ShutdownFile_RpcMessageTypes_2eproto();
+  
+  void InitAsDefaultInstance();
+  static RpcServiceBinding* default_instance_;
+};
+// -------------------------------------------------------------------
+
+class RpcHandshake : public ::google::protobuf::Message {
+ public:
+  RpcHandshake();
+  virtual ~RpcHandshake();
+  
+  RpcHandshake(const RpcHandshake& from);
+  
+  inline RpcHandshake& operator=(const RpcHandshake& from) {
+    CopyFrom(from);
+    return *this;
+  }
+  
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
+  
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
+  
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const RpcHandshake& default_instance();
+  
+  void Swap(RpcHandshake* other);
+  
+  // implements Message ----------------------------------------------
+  
+  RpcHandshake* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const RpcHandshake& from);
+  void MergeFrom(const RpcHandshake& from);
+  void Clear();
+  bool IsInitialized() const;
+  
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+  
+  ::google::protobuf::Metadata GetMetadata() const;
+  
+  // nested types ----------------------------------------------------
+  
+  // accessors -------------------------------------------------------
+  
+  // optional uint32 protocol_version = 1;
+  inline bool has_protocol_version() const;
+  inline void clear_protocol_version();
+  static const int kProtocolVersionFieldNumber = 1;
+  inline ::google::protobuf::uint32 protocol_version() const;
+  inline void set_protocol_version(::google::protobuf::uint32 value);
+  
+  // repeated .NanoRpc.RpcServiceBinding services = 2;
+  inline int services_size() const;
+  inline void clear_services();
+  static const int kServicesFieldNumber = 2;
+  inline const ::NanoRpc::RpcServiceBinding& services(int index) const;
+  inline ::NanoRpc::RpcServiceBinding* mutable_services(int index);
+  inline ::NanoRpc::RpcServiceBinding* add_services();
+  inline const ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcServiceBinding >&
+      services() const;
+  inline ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcServiceBinding >*
+      mutable_services();
+  
+  // @@protoc_insertion_point(class_scope:NanoRpc.RpcHandshake)
+ private:
+  inline void set_has_protocol_version();
+  inline void clear_has_protocol_version();
+  
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
+  
+  ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcServiceBinding > services_;
+  ::google::protobuf::uint32 protocol_version_;
+  
+  mutable int _cached_size_;
+  ::google::protobuf::uint32 _has_bits_[(2 + 31) / 32];
+  
+  friend void  protobuf_AddDesc_RpcMessageTypes_2eproto();
+  friend void protobuf_AssignDesc_RpcMessageTypes_2eproto();
+  friend void protobuf_ShutdownFile_RpcMessageTypes_2eproto();
+  
+  void InitAsDefaultInstance();
+  static RpcHandshake* default_instance_;
+};
+// -------------------------------------------------------------------
+
+class RpcBatch : public ::google::protobuf::Message {
+ public:
+  RpcBatch();
+  virtual ~RpcBatch();
+  
+  RpcBatch(const RpcBatch& from);
+  
+  inline RpcBatch& operator=(const RpcBatch& from) {
+    CopyFrom(from);
+    return *this;
+  }
+  
+  inline const ::google::protobuf::UnknownFieldSet& unknown_fields() const {
+    return _unknown_fields_;
+  }
+  
+  inline ::google::protobuf::UnknownFieldSet* mutable_unknown_fields() {
+    return &_unknown_fields_;
+  }
+  
+  static const ::google::protobuf::Descriptor* descriptor();
+  static const RpcBatch& default_instance();
+  
+  void Swap(RpcBatch* other);
+  
+  // implements Message ----------------------------------------------
+  
+  RpcBatch* New() const;
+  void CopyFrom(const ::google::protobuf::Message& from);
+  void MergeFrom(const ::google::protobuf::Message& from);
+  void CopyFrom(const RpcBatch& from);
+  void MergeFrom(const RpcBatch& from);
+  void Clear();
+  bool IsInitialized() const;
+  
+  int ByteSize() const;
+  bool MergePartialFromCodedStream(
+      ::google::protobuf::io::CodedInputStream* input);
+  void SerializeWithCachedSizes(
+      ::google::protobuf::io::CodedOutputStream* output) const;
+  ::google::protobuf::uint8* SerializeWithCachedSizesToArray(::google::protobuf::uint8* output) const;
+  int GetCachedSize() const { return _cached_size_; }
+  private:
+  void SharedCtor();
+  void SharedDtor();
+  void SetCachedSize(int size) const;
+  public:
+  
+  ::google::protobuf::Metadata GetMetadata() const;
+  
+  // nested types ----------------------------------------------------
+  
+  // accessors -------------------------------------------------------
+  
+  // repeated .NanoRpc.RpcCall calls = 1;
+  inline int calls_size() const;
+  inline void clear_calls();
+  static const int kCallsFieldNumber = 1;
+  inline const ::NanoRpc::RpcCall& calls(int index) const;
+  inline ::NanoRpc::RpcCall* mutable_calls(int index);
+  inline ::NanoRpc::RpcCall* add_calls();
+  inline const ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcCall >&
+      calls() const;
+  inline ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcCall >*
+      mutable_calls();
+  
+  // repeated .NanoRpc.RpcResult results = 2;
+  inline int results_size() const;
+  inline void clear_results();
+  static const int kResultsFieldNumber = 2;
+  inline const ::NanoRpc::RpcResult& results(int index) const;
+  inline ::NanoRpc::RpcResult* mutable_results(int index);
+  inline ::NanoRpc::RpcResult* add_results();
+  inline const ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcResult >&
+      results() const;
+  inline ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcResult >*
+      mutable_results();
+  
+  // @@protoc_insertion_point(class_scope:NanoRpc.RpcBatch)
+ private:
+  
+  ::google::protobuf::UnknownFieldSet _unknown_fields_;
+  
+  ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcCall > calls_;
+  ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcResult > results_;
+  
+  mutable int _cached_size_;
+  ::google::protobuf::uint32 _has_bits_[(2 + 31) / 32];
+  
+  friend void  protobuf_AddDesc_RpcMessageTypes_2eproto();
+  friend void protobuf_AssignDesc_RpcMessageTypes_2eproto();
+  friend void protobuf_ShutdownFile_RpcMessageTypes_2eproto();
+  
+  void InitAsDefaultInstance();
+  static RpcBatch* default_instance_;
+};
+// -------------------------------------------------------------------
+
 class RpcMessage : public ::google::protobuf::Message {
  public:
   RpcMessage();
@@ -629,6 +965,14 @@ class RpcMessage : public ::google::protobuf::Message {
   inline ::NanoRpc::RpcResult* mutable_result();
   inline ::NanoRpc::RpcResult* release_result();
   
+  // optional .NanoRpc.RpcBatch batch = 4;
+  inline bool has_batch() const;
+  inline void clear_batch();
+  static const int kBatchFieldNumber = 4;
+  inline const ::NanoRpc::RpcBatch& batch() const;
+  inline ::NanoRpc::RpcBatch* mutable_batch();
+  inline ::NanoRpc::RpcBatch* release_batch();
+  
   // @@protoc_insertion_point(class_scope:NanoRpc.RpcMessage)
  private:
   inline void set_has_id();
@@ -637,15 +981,18 @@ class RpcMessage : public ::google::protobuf::Message {
   inline void clear_has_call();
   inline void set_has_result();
   inline void clear_has_result();
+  inline void set_has_batch();
+  inline void clear_has_batch();
   
   ::google::protobuf::UnknownFieldSet _unknown_fields_;
   
   ::NanoRpc::RpcCall* call_;
   ::NanoRpc::RpcResult* result_;
+  ::NanoRpc::RpcBatch* batch_;
   ::google::protobuf::int32 id_;
   
   mutable int _cached_size_;
-  ::google::protobuf::uint32 _has_bits_[(3 + 31) / 32];
+  ::google::protobuf::uint32 _has_bits_[(4 + 31) / 32];
   
   friend void  protobuf_AddDesc_RpcMessageTypes_2eproto();
   friend void protobuf_AssignDesc_RpcMessageTypes_2eproto();
@@ -1410,6 +1757,319 @@ inline void RpcCall::set_object_id(::google::protobuf::uint32 value) {
   object_id_ = value;
 }
 
+// optional uint32 method_ordinal = 6;
+inline bool RpcCall::has_method_ordinal() const {
+  return (_has_bits_[0] & 0x00000020u) != 0;
+}
+inline void RpcCall::set_has_method_ordinal() {
+  _has_bits_[0] |= 0x00000020u;
+}
+inline void RpcCall::clear_has_method_ordinal() {
+  _has_bits_[0] &= ~0x00000020u;
+}
+inline void RpcCall::clear_method_ordinal() {
+  method_ordinal_ = 0u;
+  clear_has_method_ordinal();
+}
+inline ::google::protobuf::uint32 RpcCall::method_ordinal() const {
+  return method_ordinal_;
+}
+inline void RpcCall::set_method_ordinal(::google::protobuf::uint32 value) {
+  set_has_method_ordinal();
+  method_ordinal_ = value;
+}
+
+// optional int32 target_call_id = 7;
+inline bool RpcCall::has_target_call_id() const {
+  return (_has_bits_[0] & 0x00000040u) != 0;
+}
+inline void RpcCall::set_has_target_call_id() {
+  _has_bits_[0] |= 0x00000040u;
+}
+inline void RpcCall::clear_has_target_call_id() {
+  _has_bits_[0] &= ~0x00000040u;
+}
+inline void RpcCall::clear_target_call_id() {
+  target_call_id_ = 0;
+  clear_has_target_call_id();
+}
+inline ::google::protobuf::int32 RpcCall::target_call_id() const {
+  return target_call_id_;
+}
+inline void RpcCall::set_target_call_id(::google::protobuf::int32 value) {
+  set_has_target_call_id();
+  target_call_id_ = value;
+}
+
+// optional bool is_pipeline_target = 8;
+inline bool RpcCall::has_is_pipeline_target() const {
+  return (_has_bits_[0] & 0x00000080u) != 0;
+}
+inline void RpcCall::set_has_is_pipeline_target() {
+  _has_bits_[0] |= 0x00000080u;
+}
+inline void RpcCall::clear_has_is_pipeline_target() {
+  _has_bits_[0] &= ~0x00000080u;
+}
+inline void RpcCall::clear_is_pipeline_target() {
+  is_pipeline_target_ = false;
+  clear_has_is_pipeline_target();
+}
+inline bool RpcCall::is_pipeline_target() const {
+  return is_pipeline_target_;
+}
+inline void RpcCall::set_is_pipeline_target(bool value) {
+  set_has_is_pipeline_target();
+  is_pipeline_target_ = value;
+}
+
+// optional bytes packed_parameters = 9;
+inline bool RpcCall::has_packed_parameters() const {
+  return (_has_bits_[0] & 0x00000100u) != 0;
+}
+inline void RpcCall::set_has_packed_parameters() {
+  _has_bits_[0] |= 0x00000100u;
+}
+inline void RpcCall::clear_has_packed_parameters() {
+  _has_bits_[0] &= ~0x00000100u;
+}
+inline void RpcCall::clear_packed_parameters() {
+  if (packed_parameters_ != &::google::protobuf::internal::kEmptyString) {
+    packed_parameters_->clear();
+  }
+  clear_has_packed_parameters();
+}
+inline const ::std::string& RpcCall::packed_parameters() const {
+  return *packed_parameters_;
+}
+inline void RpcCall::set_packed_parameters(const ::std::string& value) {
+  set_has_packed_parameters();
+  if (packed_parameters_ == &::google::protobuf::internal::kEmptyString) {
+    packed_parameters_ = new ::std::string;
+  }
+  packed_parameters_->assign(value);
+}
+inline void RpcCall::set_packed_parameters(const char* value) {
+  set_has_packed_parameters();
+  if (packed_parameters_ == &::google::protobuf::internal::kEmptyString) {
+    packed_parameters_ = new ::std::string;
+  }
+  packed_parameters_->assign(value);
+}
+inline void RpcCall::set_packed_parameters(const void* value, size_t size) {
+  set_has_packed_parameters();
+  if (packed_parameters_ == &::google::protobuf::internal::kEmptyString) {
+    packed_parameters_ = new ::std::string;
+  }
+  packed_parameters_->assign(reinterpret_cast<const char*>(value), size);
+}
+inline ::std::string* RpcCall::mutable_packed_parameters() {
+  set_has_packed_parameters();
+  if (packed_parameters_ == &::google::protobuf::internal::kEmptyString) {
+    packed_parameters_ = new ::std::string;
+  }
+  return packed_parameters_;
+}
+inline ::std::string* RpcCall::release_packed_parameters() {
+  clear_has_packed_parameters();
+  if (packed_parameters_ == &::google::protobuf::internal::kEmptyString) {
+    return NULL;
+  } else {
+    ::std::string* temp = packed_parameters_;
+    packed_parameters_ = const_cast< ::std::string*>(&::google::protobuf::internal::kEmptyString);
+    return temp;
+  }
+}
+
+// -------------------------------------------------------------------
+
+// RpcServiceBinding
+
+// optional string name = 1;
+inline bool RpcServiceBinding::has_name() const {
+  return (_has_bits_[0] & 0x00000001u) != 0;
+}
+inline void RpcServiceBinding::set_has_name() {
+  _has_bits_[0] |= 0x00000001u;
+}
+inline void RpcServiceBinding::clear_has_name() {
+  _has_bits_[0] &= ~0x00000001u;
+}
+inline void RpcServiceBinding::clear_name() {
+  if (name_ != &::google::protobuf::internal::kEmptyString) {
+    name_->clear();
+  }
+  clear_has_name();
+}
+inline const ::std::string& RpcServiceBinding::name() const {
+  return *name_;
+}
+inline void RpcServiceBinding::set_name(const ::std::string& value) {
+  set_has_name();
+  if (name_ == &::google::protobuf::internal::kEmptyString) {
+    name_ = new ::std::string;
+  }
+  name_->assign(value);
+}
+inline void RpcServiceBinding::set_name(const char* value) {
+  set_has_name();
+  if (name_ == &::google::protobuf::internal::kEmptyString) {
+    name_ = new ::std::string;
+  }
+  name_->assign(value);
+}
+inline void RpcServiceBinding::set_name(const char* value, size_t size) {
+  set_has_name();
+  if (name_ == &::google::protobuf::internal::kEmptyString) {
+    name_ = new ::std::string;
+  }
+  name_->assign(reinterpret_cast<const char*>(value), size);
+}
+inline ::std::string* RpcServiceBinding::mutable_name() {
+  set_has_name();
+  if (name_ == &::google::protobuf::internal::kEmptyString) {
+    name_ = new ::std::string;
+  }
+  return name_;
+}
+inline ::std::string* RpcServiceBinding::release_name() {
+  clear_has_name();
+  if (name_ == &::google::protobuf::internal::kEmptyString) {
+    return NULL;
+  } else {
+    ::std::string* temp = name_;
+    name_ = const_cast< ::std::string*>(&::google::protobuf::internal::kEmptyString);
+    return temp;
+  }
+}
+
+// optional uint32 object_id = 2;
+inline bool RpcServiceBinding::has_object_id() const {
+  return (_has_bits_[0] & 0x00000002u) != 0;
+}
+inline void RpcServiceBinding::set_has_object_id() {
+  _has_bits_[0] |= 0x00000002u;
+}
+inline void RpcServiceBinding::clear_has_object_id() {
+  _has_bits_[0] &= ~0x00000002u;
+}
+inline void RpcServiceBinding::clear_object_id() {
+  object_id_ = 0u;
+  clear_has_object_id();
+}
+inline ::google::protobuf::uint32 RpcServiceBinding::object_id() const {
+  return object_id_;
+}
+inline void RpcServiceBinding::set_object_id(::google::protobuf::uint32 value) {
+  set_has_object_id();
+  object_id_ = value;
+}
+
+// -------------------------------------------------------------------
+
+// RpcHandshake
+
+// optional uint32 protocol_version = 1;
+inline bool RpcHandshake::has_protocol_version() const {
+  return (_has_bits_[0] & 0x00000001u) != 0;
+}
+inline void RpcHandshake::set_has_protocol_version() {
+  _has_bits_[0] |= 0x00000001u;
+}
+inline void RpcHandshake::clear_has_protocol_version() {
+  _has_bits_[0] &= ~0x00000001u;
+}
+inline void RpcHandshake::clear_protocol_version() {
+  protocol_version_ = 0u;
+  clear_has_protocol_version();
+}
+inline ::google::protobuf::uint32 RpcHandshake::protocol_version() const {
+  return protocol_version_;
+}
+inline void RpcHandshake::set_protocol_version(::google::protobuf::uint32 value) {
+  set_has_protocol_version();
+  protocol_version_ = value;
+}
+
+// repeated .NanoRpc.RpcServiceBinding services = 2;
+inline int RpcHandshake::services_size() const {
+  return services_.size();
+}
+inline void RpcHandshake::clear_services() {
+  services_.Clear();
+}
+inline const ::NanoRpc::RpcServiceBinding& RpcHandshake::services(int index) const {
+  return services_.Get(index);
+}
+inline ::NanoRpc::RpcServiceBinding* RpcHandshake::mutable_services(int index) {
+  return services_.Mutable(index);
+}
+inline ::NanoRpc::RpcServiceBinding* RpcHandshake::add_services() {
+  return services_.Add();
+}
+inline const ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcServiceBinding >&
+RpcHandshake::services() const {
+  return services_;
+}
+inline ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcServiceBinding >*
+RpcHandshake::mutable_services() {
+  return &services_;
+}
+
+// -------------------------------------------------------------------
+
+// RpcBatch
+
+// repeated .NanoRpc.RpcCall calls = 1;
+inline int RpcBatch::calls_size() const {
+  return calls_.size();
+}
+inline void RpcBatch::clear_calls() {
+  calls_.Clear();
+}
+inline const ::NanoRpc::RpcCall& RpcBatch::calls(int index) const {
+  return calls_.Get(index);
+}
+inline ::NanoRpc::RpcCall* RpcBatch::mutable_calls(int index) {
+  return calls_.Mutable(index);
+}
+inline ::NanoRpc::RpcCall* RpcBatch::add_calls() {
+  return calls_.Add();
+}
+inline const ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcCall >&
+RpcBatch::calls() const {
+  return calls_;
+}
+inline ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcCall >*
+RpcBatch::mutable_calls() {
+  return &calls_;
+}
+
+// repeated .NanoRpc.RpcResult results = 2;
+inline int RpcBatch::results_size() const {
+  return results_.size();
+}
+inline void RpcBatch::clear_results() {
+  results_.Clear();
+}
+inline const ::NanoRpc::RpcResult& RpcBatch::results(int index) const {
+  return results_.Get(index);
+}
+inline ::NanoRpc::RpcResult* RpcBatch::mutable_results(int index) {
+  return results_.Mutable(index);
+}
+inline ::NanoRpc::RpcResult* RpcBatch::add_results() {
+  return results_.Add();
+}
+inline const ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcResult >&
+RpcBatch::results() const {
+  return results_;
+}
+inline ::google::protobuf::RepeatedPtrField< ::NanoRpc::RpcResult >*
+RpcBatch::mutable_results() {
+  return &results_;
+}
+
 // -------------------------------------------------------------------
 
 // RpcMessage
@@ -1494,6 +2154,35 @@ inline ::NanoRpc::RpcResult* RpcMessage::release_result() {
   return temp;
 }
 
+// optional .NanoRpc.RpcBatch batch = 4;
+inline bool RpcMessage::has_batch() const {
+  return (_has_bits_[0] & 0x00000008u) != 0;
+}
+inline void RpcMessage::set_has_batch() {
+  _has_bits_[0] |= 0x00000008u;
+}
+inline void RpcMessage::clear_has_batch() {
+  _has_bits_[0] &= ~0x00000008u;
+}
+inline void RpcMessage::clear_batch() {
+  if (batch_ != NULL) batch_->::NanoRpc::RpcBatch::Clear();
+  clear_has_batch();
+}
+inline const ::NanoRpc::RpcBatch& RpcMessage::batch() const {
+  return batch_ != NULL ? *batch_ : *default_instance_->batch_;
+}
+inline ::NanoRpc::RpcBatch* RpcMessage::mutable_batch() {
+  set_has_batch();
+  if (batch_ == NULL) batch_ = new ::NanoRpc::RpcBatch;
+  return batch_;
+}
+inline ::NanoRpc::RpcBatch* RpcMessage::release_batch() {
+  clear_has_batch();
+  ::NanoRpc::RpcBatch* temp = batch_;
+  batch_ = NULL;
+  return temp;
+}
+
 
 // @@protoc_insertion_point(namespace_scope)
 
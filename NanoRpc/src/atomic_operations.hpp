@@ -0,0 +1,95 @@
+#if !defined(NANO_RPC_ATOMIC_OPERATIONS_HPP__)
+#define NANO_RPC_ATOMIC_OPERATIONS_HPP__
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace NanoRpc {
+
+// Thin wrappers over the platform interlocked operations, so the lock-free
+// code that is shared by Windows and Linux builds is written once.
+// All operations are full memory barriers. The argument order follows
+// the Interlocked* functions.
+
+#if defined(_WIN32)
+
+inline long AtomicIncrement(volatile long *value) {
+  return InterlockedIncrement(value);
+}
+
+inline long AtomicDecrement(volatile long *value) {
+  return InterlockedDecrement(value);
+}
+
+// Returns the initial value.
+inline long AtomicExchangeAdd(volatile long *value, long addend) {
+  return InterlockedExchangeAdd(value, addend);
+}
+
+// Returns the initial value.
+inline long AtomicExchange(volatile long *target, long value) {
+  return InterlockedExchange(target, value);
+}
+
+// Returns the initial value.
+inline long AtomicCompareExchange(volatile long *target, long exchange,
+                                  long comparand) {
+  return InterlockedCompareExchange(target, exchange, comparand);
+}
+
+template <class T>
+inline T *AtomicExchangePointer(T *volatile *target, T *value) {
+  return reinterpret_cast<T *>(InterlockedExchangePointer(
+      reinterpret_cast<PVOID volatile *>(target), value));
+}
+
+template <class T>
+inline T *AtomicCompareExchangePointer(T *volatile *target, T *exchange,
+                                       T *comparand) {
+  return reinterpret_cast<T *>(InterlockedCompareExchangePointer(
+      reinterpret_cast<PVOID volatile *>(target), exchange, comparand));
+}
+
+#else  // !_WIN32
+
+inline long AtomicIncrement(volatile long *value) {
+  return __sync_add_and_fetch(value, 1);
+}
+
+inline long AtomicDecrement(volatile long *value) {
+  return __sync_sub_and_fetch(value, 1);
+}
+
+inline long AtomicExchangeAdd(volatile long *value, long addend) {
+  return __sync_fetch_and_add(value, addend);
+}
+
+inline long AtomicExchange(volatile long *target, long value) {
+  // __sync_lock_test_and_set is only an acquire barrier.
+  __sync_synchronize();
+  return __sync_lock_test_and_set(target, value);
+}
+
+inline long AtomicCompareExchange(volatile long *target, long exchange,
+                                  long comparand) {
+  return __sync_val_compare_and_swap(target, comparand, exchange);
+}
+
+template <class T>
+inline T *AtomicExchangePointer(T *volatile *target, T *value) {
+  __sync_synchronize();
+  return __sync_lock_test_and_set(target, value);
+}
+
+template <class T>
+inline T *AtomicCompareExchangePointer(T *volatile *target, T *exchange,
+                                       T *comparand) {
+  return __sync_val_compare_and_swap(target, comparand, exchange);
+}
+
+#endif  // _WIN32
+
+}  // namespace
+
+#endif  // NANO_RPC_ATOMIC_OPERATIONS_HPP__
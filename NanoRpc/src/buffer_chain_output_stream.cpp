@@ -0,0 +1,103 @@
+#include "buffer_chain_output_stream.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include <stdint.h>
+
+#include <google/protobuf/io/coded_stream.h>
+
+namespace NanoRpc {
+
+BufferChainOutputStream::BufferChainOutputStream(BufferPool *buffer_pool,
+                                                 int chunk_size)
+    : buffer_pool_(buffer_pool), chunk_size_(chunk_size),
+      last_chunk_capacity_(0), expected_bytes_(0), byte_count_(0) {
+  assert(buffer_pool_ != NULL);
+  assert(chunk_size_ > 0);
+}
+
+BufferChainOutputStream::~BufferChainOutputStream() {
+  for (size_t i = 0; i < chunks_.size(); ++i)
+    buffer_pool_->Deallocate(chunks_[i].buffer);
+}
+
+void BufferChainOutputStream::WriteFrame(
+    const google::protobuf::MessageLite &message) {
+  int message_size = message.ByteSize();
+  int32_t prefix = message_size;
+  int frame_size = message_size + sizeof(prefix);
+
+  expected_bytes_ += frame_size;
+
+  // Fast path, the whole frame fits into the chunk.
+  if (frame_size <= chunk_size_) {
+    void *data;
+    int size;
+    Next(&data, &size);
+    if (size >= frame_size) {
+      char *target = reinterpret_cast<char *>(data);
+      memcpy(target, &prefix, sizeof(prefix));
+      message.SerializeWithCachedSizesToArray(
+          reinterpret_cast<google::protobuf::uint8 *>(target +
+                                                      sizeof(prefix)));
+      BackUp(size - frame_size);
+      return;
+    }
+    BackUp(size);
+  }
+
+  // TODO: For sake of compatibility use protobuf IO to serialize the message
+  // size.
+  google::protobuf::io::CodedOutputStream output(this);
+  output.WriteRaw(&prefix, sizeof(prefix));
+  message.SerializeWithCachedSizes(&output);
+}
+
+void BufferChainOutputStream::Detach() { chunks_.clear(); }
+
+bool BufferChainOutputStream::Next(void **data, int *size) {
+  assert(data != NULL);
+  assert(size != NULL);
+
+  // Hand out the rest of the last chunk, if something was backed up.
+  if (!chunks_.empty() && chunks_.back().size < last_chunk_capacity_) {
+    Chunk &chunk = chunks_.back();
+    *data = chunk.buffer + chunk.size;
+    *size = last_chunk_capacity_ - chunk.size;
+    byte_count_ += *size;
+    chunk.size = last_chunk_capacity_;
+    return true;
+  }
+
+  int remaining = expected_bytes_ - static_cast<int>(byte_count_);
+  int capacity = remaining > 0 ? std::min(remaining, chunk_size_)
+                               : chunk_size_;
+
+  Chunk chunk = { buffer_pool_->Allocate(capacity), capacity };
+  chunks_.push_back(chunk);
+  last_chunk_capacity_ = capacity;
+
+  *data = chunk.buffer;
+  *size = capacity;
+  byte_count_ += capacity;
+  return true;
+}
+
+void BufferChainOutputStream::BackUp(int count) {
+  assert(!chunks_.empty());
+  assert(count >= 0 && count <= chunks_.back().size);
+
+  chunks_.back().size -= count;
+  byte_count_ -= count;
+
+  // Do not keep empty chunk at the end of the chain.
+  if (chunks_.back().size == 0) {
+    buffer_pool_->Deallocate(chunks_.back().buffer);
+    chunks_.pop_back();
+    last_chunk_capacity_ = chunks_.empty() ? 0 : chunks_.back().size;
+  }
+}
+
+} // namespace
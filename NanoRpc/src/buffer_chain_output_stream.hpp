@@ -0,0 +1,70 @@
+#if !defined(NANO_RPC_BUFFER_CHAIN_OUTPUT_STREAM_HPP__)
+#define NANO_RPC_BUFFER_CHAIN_OUTPUT_STREAM_HPP__
+
+#include <vector>
+
+#include <google/protobuf/message_lite.h>
+#include <google/protobuf/io/zero_copy_stream.h>
+
+#include "basictypes.hpp"
+#include "buffer_pool.hpp"
+
+namespace NanoRpc {
+
+// Output stream that writes into a chain of chunks allocated from the buffer
+// pool, so a big message can be serialized without allocating a contiguous
+// buffer for all of it. The chunks are meant to be written out with a gather
+// write (or one write per chunk).
+//
+// The stream owns the chunks until Detach is called; after that the caller
+// is responsible to return them to the pool.
+class BufferChainOutputStream
+    : public google::protobuf::io::ZeroCopyOutputStream {
+public:
+  struct Chunk {
+    char *buffer;
+    int size;  // Number of bytes written into the chunk.
+  };
+
+  static const int DefaultChunkSize = 64 * 1024;
+
+  explicit BufferChainOutputStream(BufferPool *buffer_pool,
+                                   int chunk_size = DefaultChunkSize);
+  ~BufferChainOutputStream();
+
+  // Writes the message with its 4-byte length prefix. The message size is
+  // computed once and chunks are sized to fit the frame, so a message
+  // smaller than the chunk size ends up in a single chunk.
+  void WriteFrame(const google::protobuf::MessageLite &message);
+
+  size_t GetChunkCount() const { return chunks_.size(); }
+  const Chunk &GetChunk(size_t index) const { return chunks_[index]; }
+
+  // Gives up ownership of the chunks.
+  void Detach();
+
+  // ZeroCopyOutputStream implementation.
+  virtual bool Next(void **data, int *size);
+  virtual void BackUp(int count);
+  virtual google::protobuf::int64 ByteCount() const { return byte_count_; }
+
+private:
+  BufferPool *buffer_pool_;
+  int chunk_size_;
+
+  std::vector<Chunk> chunks_;
+
+  // Capacity of the last chunk.
+  int last_chunk_capacity_;
+
+  // Number of bytes the caller announced it is going to write. Used to size
+  // the chunks.
+  int expected_bytes_;
+  google::protobuf::int64 byte_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferChainOutputStream);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_BUFFER_CHAIN_OUTPUT_STREAM_HPP__
@@ -1,5 +1,7 @@
 #include "buffer_pool.hpp"
 
+#include <stdexcept>
+
 namespace NanoRpc {
 
 namespace {
@@ -122,14 +124,16 @@ int BufferPool::GetBufferSize(const char *buffer) const {
   PointerToDescriptorMap::const_iterator iter = all_buffers_.find(buffer);
   assert(iter != all_buffers_.end());
   if (iter == all_buffers_.end())
-    throw std::exception("BufferPool::GetBufferSize: buffer does not belong to "
-                         "this pool or buffer pointer is invalid.");
+    throw std::invalid_argument(
+        "BufferPool::GetBufferSize: buffer does not belong to this pool or "
+        "buffer pointer is invalid.");
 
   // Check if someone attempts to fool us by providing buffer that is free but
   // still in the pool.
   assert(iter->second->used);
   if (!iter->second->used)
-    throw std::exception("BufferPool::GetBufferSize: buffer is not allocated.");
+    throw std::invalid_argument(
+        "BufferPool::GetBufferSize: buffer is not allocated.");
 
   return iter->second->size;
 }
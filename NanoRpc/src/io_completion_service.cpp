@@ -0,0 +1,156 @@
+#include "io_completion_service.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+#include <windows.h>
+
+#include "atomic_operations.hpp"
+
+namespace NanoRpc {
+
+namespace {
+
+IoCompletionService *volatile default_service = NULL;
+
+} // namespace
+
+IoCompletionService::IoCompletionService() : completion_port_(NULL) {}
+
+IoCompletionService::~IoCompletionService() { Stop(); }
+
+IoCompletionService *IoCompletionService::GetDefault() {
+  IoCompletionService *service = default_service;
+  if (service != NULL)
+    return service;
+
+  // Threads racing here may start a service each, only one of them wins.
+  service = new IoCompletionService();
+  if (!service->Start()) {
+    delete service;
+    return NULL;
+  }
+
+  IoCompletionService *current =
+      AtomicCompareExchangePointer(&default_service, service,
+                                   static_cast<IoCompletionService *>(NULL));
+  if (current != NULL) {
+    delete service;
+    return current;
+  }
+
+  return service;
+}
+
+bool IoCompletionService::Start(int thread_count) {
+  assert(completion_port_ == NULL);
+
+  if (thread_count <= 0) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    thread_count = std::max(1, static_cast<int>(info.dwNumberOfProcessors));
+  }
+
+  completion_port_ =
+      CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, thread_count);
+  if (completion_port_ == NULL)
+    return false;
+
+  for (int i = 0; i < thread_count; ++i) {
+    DWORD thread_id;
+    HANDLE thread = CreateThread(NULL, 0, &CompletionThreadProcThunk, this, 0,
+                                 &thread_id);
+    if (thread == NULL) {
+      Stop();
+      return false;
+    }
+
+    threads_.push_back(thread);
+    thread_ids_.push_back(thread_id);
+  }
+
+  return true;
+}
+
+void IoCompletionService::Stop() {
+  if (completion_port_ == NULL)
+    return;
+
+  assert(!IsServiceThread());
+
+  // Packet with neither key nor overlapped structure stops one thread.
+  for (size_t i = 0; i < threads_.size(); ++i)
+    PostQueuedCompletionStatus(completion_port_, 0, 0, NULL);
+
+  for (size_t i = 0; i < threads_.size(); ++i) {
+    if (WaitForSingleObject(threads_[i], 2000) == WAIT_TIMEOUT) {
+      // TODO: Spit debugger message instead
+      std::cout << "warning: The I/O completion thread seems to hung.\n";
+    }
+    CloseHandle(threads_[i]);
+  }
+
+  threads_.clear();
+  thread_ids_.clear();
+
+  CloseHandle(completion_port_);
+  completion_port_ = NULL;
+}
+
+bool IoCompletionService::IsServiceThread() const {
+  DWORD thread_id = GetCurrentThreadId();
+  return std::find(thread_ids_.begin(), thread_ids_.end(), thread_id) !=
+         thread_ids_.end();
+}
+
+bool IoCompletionService::Associate(HANDLE handle, IHandler *handler) {
+  assert(completion_port_ != NULL);
+  assert(handler != NULL);
+
+  return CreateIoCompletionPort(handle, completion_port_,
+                                reinterpret_cast<ULONG_PTR>(handler),
+                                0) != NULL;
+}
+
+bool IoCompletionService::Post(IHandler *handler, OVERLAPPED *overlapped) {
+  assert(completion_port_ != NULL);
+  assert(handler != NULL);
+
+  return PostQueuedCompletionStatus(completion_port_, 0,
+                                    reinterpret_cast<ULONG_PTR>(handler),
+                                    overlapped) != FALSE;
+}
+
+int IoCompletionService::CompletionThreadProc() {
+  while (true) {
+    DWORD bytes_transferred;
+    ULONG_PTR key = 0;
+    OVERLAPPED *overlapped = NULL;
+    DWORD error = ERROR_SUCCESS;
+    if (GetQueuedCompletionStatus(completion_port_, &bytes_transferred, &key,
+                                  &overlapped, INFINITE) == FALSE) {
+      error = GetLastError();
+
+      // If overlapped is NULL then GetQueuedCompletionStatus failed because of
+      // invalid parameter or completion_port_ handle was closed.
+      if (overlapped == NULL) {
+        std::cout << "error: GetQueuedCompletionStatus failed: " << error
+                  << "\n";
+        break;
+      }
+    }
+
+    if (key == 0) {
+      assert(overlapped == NULL);
+      break;
+    }
+
+    reinterpret_cast<IHandler *>(key)
+        ->OperationCompleted(overlapped, bytes_transferred, error);
+  }
+
+  return 0;
+}
+
+} // namespace
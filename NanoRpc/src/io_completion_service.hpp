@@ -0,0 +1,82 @@
+#if !defined(NANO_RPC_IO_COMPLETION_SERVICE_HPP__)
+#define NANO_RPC_IO_COMPLETION_SERVICE_HPP__
+
+#include <vector>
+
+#include <windows.h>
+
+#include "basictypes.hpp"
+
+namespace NanoRpc {
+
+// I/O completion port serviced by a fixed set of threads and shared by all
+// channels in the process.
+//
+// A channel associates its handle with the port, passing itself as the
+// handler. Completions of the overlapped operations started on the handle
+// are then delivered to the handler on whichever service thread dequeues
+// them, so completions of the same channel may run concurrently and the
+// handler has to synchronize its state itself.
+//
+// Packets posted with Post are delivered the same way and are used to run
+// something on the service threads, e.g. to flush the send queue.
+class IoCompletionService {
+public:
+  class IHandler {
+  public:
+    virtual ~IHandler() {}
+
+    // Called on a service thread. The error is ERROR_SUCCESS if the
+    // operation succeeded, otherwise the Windows error code. For posted
+    // packets the overlapped is whatever was passed to Post.
+    virtual void OperationCompleted(OVERLAPPED *overlapped,
+                                    DWORD bytes_transferred, DWORD error) = 0;
+  };
+
+  IoCompletionService();
+  ~IoCompletionService();
+
+  // Returns the process-wide service, started on the first use with one
+  // thread per processor. It is never stopped.
+  static IoCompletionService *GetDefault();
+
+  // Zero thread count means one thread per processor.
+  bool Start(int thread_count = 0);
+
+  // All handles associated with the service must be closed and their
+  // operations drained before it is stopped.
+  void Stop();
+
+  bool IsRunning() const { return completion_port_ != NULL; }
+
+  int get_thread_count() const { return static_cast<int>(threads_.size()); }
+
+  // Returns true if called from one of the service threads.
+  bool IsServiceThread() const;
+
+  // The handle must be opened for overlapped I/O. A handle can be
+  // associated with the port only once and stays associated until closed.
+  bool Associate(HANDLE handle, IHandler *handler);
+
+  bool Post(IHandler *handler, OVERLAPPED *overlapped);
+
+private:
+  static DWORD WINAPI CompletionThreadProcThunk(void *parameter) {
+    IoCompletionService *service =
+        reinterpret_cast<IoCompletionService *>(parameter);
+    return service->CompletionThreadProc();
+  }
+
+  int CompletionThreadProc();
+
+  HANDLE completion_port_;
+
+  std::vector<HANDLE> threads_;
+  std::vector<DWORD> thread_ids_;
+
+  DISALLOW_COPY_AND_ASSIGN(IoCompletionService);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_IO_COMPLETION_SERVICE_HPP__
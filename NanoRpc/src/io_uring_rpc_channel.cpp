@@ -0,0 +1,321 @@
+// All I/O of the channel goes through the shared IoUringService. At most one
+// read and one write are in flight at any time; the write queue keeps the
+// messages in order and the read is re-armed from the completion handler.
+//
+// The channel counts outstanding operations plus one reference for the
+// connection itself. Disconnecting shuts the socket down, which completes
+// whatever is in flight, and the socket is closed once the last reference
+// is gone.
+
+#include "io_uring_rpc_channel.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "rpc_controller.hpp"
+
+namespace NanoRpc {
+
+IoUringRpcChannel::IoUringRpcChannel(RpcController *controller,
+                                     IoUringService *service, int socket)
+    : RpcChannel(controller), service_(service), socket_(socket),
+      operation_references_(0), drained_event_(true, false),
+      is_surprise_disconnect_(false), is_write_in_flight_(false),
+      frame_reader_(&buffer_pool_), disconnected_callback_(NULL),
+      is_connected_(NotConnected) {
+  assert(service_ != NULL);
+  read_operation_.handler = this;
+  write_operation_.handler = this;
+}
+
+IoUringRpcChannel::~IoUringRpcChannel() {
+  Close();
+  Detach();
+  assert(operation_references_ == 0);
+}
+
+bool IoUringRpcChannel::Start() {
+  if (__sync_val_compare_and_swap(&is_connected_, NotConnected, Connected) !=
+      NotConnected)
+    return true;
+
+  // The ring waits for the socket readiness itself, non-blocking socket
+  // would just fail the operations with EAGAIN.
+  int flags = fcntl(socket_, F_GETFL, 0);
+  if (flags == -1 || fcntl(socket_, F_SETFL, flags & ~O_NONBLOCK) == -1) {
+    __sync_lock_test_and_set(&is_connected_, NotConnected);
+    return false;
+  }
+
+  // Fails for non-TCP sockets, which is fine.
+  int no_delay = 1;
+  setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+  operation_references_ = 1;
+  if (!SubmitRead()) {
+    operation_references_ = 0;
+    __sync_lock_test_and_set(&is_connected_, NotConnected);
+    return false;
+  }
+
+  return true;
+}
+
+void IoUringRpcChannel::Close() {
+  if (__sync_val_compare_and_swap(&is_connected_, NotConnected,
+                                  Disconnected) == NotConnected) {
+    close(socket_);
+    socket_ = -1;
+    return;
+  }
+
+  Disconnect(false);
+
+  // On the service thread the teardown completes when the current
+  // operation returns.
+  if (!service_->IsServiceThread())
+    drained_event_.Wait();
+}
+
+void IoUringRpcChannel::Send(const RpcMessage &message) {
+  if (is_connected_ != Connected)
+    return; // TODO: false;
+
+  int message_size = message.ByteSize();
+  int frame_size = message_size + sizeof(int32_t);
+
+  int buffer_index;
+  char *buffer = service_->AllocateBuffer(frame_size, &buffer_index);
+
+  int32_t prefix = message_size;
+  memcpy(buffer, &prefix, sizeof(prefix));
+  message.SerializeWithCachedSizesToArray(
+      reinterpret_cast<google::protobuf::uint8 *>(buffer + sizeof(prefix)));
+
+  bool submitted;
+  {
+    ScopedLock lock(write_lock_);
+
+    if (is_connected_ != Connected) {
+      service_->DeallocateBuffer(buffer, buffer_index);
+      return; // TODO: false;
+    }
+
+    PendingWrite write = { buffer, buffer_index, frame_size };
+    pending_writes_.push_back(write);
+    submitted = SubmitNextWrite();
+  }
+
+  if (!submitted) {
+    std::cout << "error: Failed to submit write\n";
+    std::cout.flush();
+    Disconnect(true);
+  }
+}
+
+void IoUringRpcChannel::OperationCompleted(IoUringOperation *operation,
+                                           int result) {
+  if (operation == &read_operation_)
+    ReadCompleted(result);
+  else
+    WriteCompleted(result);
+}
+
+bool IoUringRpcChannel::SubmitRead() {
+  // The data is read right behind what the frame reader holds, so the
+  // complete messages are parsed in place.
+  int size;
+  read_operation_.buffer = frame_reader_.PrepareRead(&size);
+  read_operation_.buffer_index = -1;
+  read_operation_.size = size;
+  read_operation_.offset = 0;
+
+  AddOperationReference();
+  if (!service_->SubmitRead(socket_, &read_operation_)) {
+    read_operation_.buffer = NULL;
+    ReleaseOperationReference();
+    return false;
+  }
+
+  return true;
+}
+
+bool IoUringRpcChannel::SubmitNextWrite() {
+  if (is_write_in_flight_ || pending_writes_.empty())
+    return true;
+
+  if (write_operation_.buffer == NULL) {
+    const PendingWrite &write = pending_writes_.front();
+    write_operation_.buffer = write.buffer;
+    write_operation_.buffer_index = write.buffer_index;
+    write_operation_.size = write.size;
+    write_operation_.offset = 0;
+  }
+
+  // The connection reference is held while we are under the write lock, so
+  // this never drops the last reference.
+  AddOperationReference();
+  if (!service_->SubmitWrite(socket_, &write_operation_)) {
+    ReleaseOperationReference();
+    return false;
+  }
+
+  is_write_in_flight_ = true;
+  return true;
+}
+
+void IoUringRpcChannel::ReadCompleted(int result) {
+  bool succeeded = false;
+  if (result == 0) {
+    if (is_connected_ == Connected)
+      std::cout << "Socket closed by peer\n";
+  } else if (result < 0) {
+    if (is_connected_ == Connected)
+      std::cout << "error: Read failed with errno == " << -result << "\n";
+  } else if (is_connected_ == Connected) {
+    succeeded = ProcessReceivedData(result);
+  }
+
+  read_operation_.buffer = NULL;
+
+  if (succeeded && is_connected_ == Connected)
+    succeeded = SubmitRead();
+
+  if (!succeeded)
+    Disconnect(true);
+
+  ReleaseOperationReference();
+}
+
+void IoUringRpcChannel::WriteCompleted(int result) {
+  bool succeeded = result > 0;
+  {
+    ScopedLock lock(write_lock_);
+    is_write_in_flight_ = false;
+
+    if (succeeded) {
+      write_operation_.offset += result;
+      if (write_operation_.offset == write_operation_.size) {
+        const PendingWrite &write = pending_writes_.front();
+        service_->DeallocateBuffer(write.buffer, write.buffer_index);
+        pending_writes_.pop_front();
+        write_operation_.buffer = NULL;
+      }
+
+      if (is_connected_ == Connected)
+        succeeded = SubmitNextWrite();
+    }
+  }
+
+  if (!succeeded) {
+    if (is_connected_ == Connected) {
+      std::cout << "error: Socket broken while attempting to write\n";
+      std::cout.flush();
+    }
+    Disconnect(true);
+  }
+
+  ReleaseOperationReference();
+}
+
+bool IoUringRpcChannel::ProcessReceivedData(int size) {
+  frame_reader_.CommitRead(size);
+
+  const char *data;
+  int message_size;
+  MessageFrameReader::Result result = MessageFrameReader::NeedMoreData;
+  while (is_connected_ == Connected &&
+         (result = frame_reader_.ReadNextMessage(&data, &message_size)) ==
+             MessageFrameReader::MessageAvailable) {
+    if (!DispatchMessage(data, message_size))
+      return false;
+  }
+
+  if (result == MessageFrameReader::InvalidFrame) {
+    std::cout << "error: Received malformed message\n";
+    return false;
+  }
+
+  return true;
+}
+
+bool IoUringRpcChannel::DispatchMessage(const char *data, int size) {
+  RpcMessage message;
+  if (!message.ParseFromArray(data, size)) {
+    std::cout << "error: Failed to parse incoming message\n";
+    return false;
+  }
+
+  // The server dispatches the call on its worker pool.
+  // TODO: Without the worker pool the handler runs on the service thread, so
+  // a native client that makes a synchronous call while handling an event
+  // would lock up. With the shared service that would also stall all other
+  // channels.
+  Receive(message);
+  return true;
+}
+
+void IoUringRpcChannel::Disconnect(bool surprise) {
+  {
+    // Senders check the state under the same lock.
+    ScopedLock lock(write_lock_);
+    if (__sync_val_compare_and_swap(&is_connected_, Connected,
+                                    Disconnected) != Connected)
+      return;
+    is_surprise_disconnect_ = surprise;
+  }
+
+  ReceiveChannelFailure();
+
+  // Completes the operations that are in flight.
+  shutdown(socket_, SHUT_RDWR);
+
+  ReleaseOperationReference();
+}
+
+void IoUringRpcChannel::AddOperationReference() {
+  __sync_add_and_fetch(&operation_references_, 1);
+}
+
+void IoUringRpcChannel::ReleaseOperationReference() {
+  if (__sync_sub_and_fetch(&operation_references_, 1) == 0)
+    FinishClose();
+}
+
+void IoUringRpcChannel::FinishClose() {
+  {
+    ScopedLock lock(write_lock_);
+    while (!pending_writes_.empty()) {
+      const PendingWrite &write = pending_writes_.front();
+      service_->DeallocateBuffer(write.buffer, write.buffer_index);
+      pending_writes_.pop_front();
+    }
+    write_operation_.buffer = NULL;
+  }
+
+  frame_reader_.Reset();
+
+  int socket = socket_;
+  CallbackBase<int> *callback =
+      is_surprise_disconnect_ ? disconnected_callback_ : NULL;
+
+  close(socket_);
+  socket_ = -1;
+
+  // The channel may be destroyed by the thread waiting in Close as soon as
+  // the event is set, so nothing past this point touches the members.
+  drained_event_.Set();
+
+  if (callback != NULL)
+    callback->Invoke(socket);
+}
+
+} // namespace
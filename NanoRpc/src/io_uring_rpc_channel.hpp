@@ -0,0 +1,115 @@
+#if !defined(NANO_RPC_IO_URING_RPC_CHANNEL_HPP__)
+#define NANO_RPC_IO_URING_RPC_CHANNEL_HPP__
+
+#include <deque>
+
+#include <stdint.h>
+
+#include "RpcMessageTypes.pb.h"
+
+#include "rpc_channel.hpp"
+#include "basictypes.hpp"
+#include "buffer_pool.hpp"
+#include "callback.hpp"
+#include "io_uring_service.hpp"
+#include "message_frame_reader.hpp"
+#include "synchronization_primitives.hpp"
+
+namespace NanoRpc {
+
+// Channel that runs over a connected stream socket serviced by the shared
+// IoUringService instead of a per-channel epoll loop.
+//
+// Each read asks for as much data as fits into the frame reader's buffer
+// and extracts all complete messages from it, so a burst of small messages
+// costs a single read instead of a prefix read and a body read for each.
+// Framing is the same as in SocketRpcChannel, see MessageFrameReader. The
+// writes use the registered buffers.
+//
+// The channel must not be destroyed on the service thread other than from
+// the disconnected callback.
+//
+// This implementation is only available on Linux.
+class IoUringRpcChannel : public RpcChannel, public IoUringOperation::IHandler {
+public:
+  IoUringRpcChannel(RpcController *controller, IoUringService *service,
+                    int socket);
+  ~IoUringRpcChannel();
+
+  virtual bool Start();
+  virtual void Close();
+
+  // Important: The socket passed in the disconnected callback is closed.
+  void set_disconnected_callback(CallbackBase<int> *callback) {
+    disconnected_callback_ = callback;
+  }
+  CallbackBase<int> *get_disconnected_callback() {
+    return disconnected_callback_;
+  }
+
+protected:
+  virtual void Send(const RpcMessage &message);
+
+  virtual void OperationCompleted(IoUringOperation *operation, int result);
+
+private:
+  enum ChannelState { NotConnected = 0, Connected = 1, Disconnected = 2 };
+
+  struct PendingWrite {
+    char *buffer;
+    int buffer_index;
+    int size;
+  };
+
+  bool SubmitRead();
+
+  // Must be called with write_lock_ held.
+  bool SubmitNextWrite();
+
+  void ReadCompleted(int result);
+  void WriteCompleted(int result);
+
+  // Accounts the bytes read into the frame reader and dispatches the
+  // complete messages. Returns false if the data does not form valid
+  // messages.
+  bool ProcessReceivedData(int size);
+  bool DispatchMessage(const char *data, int size);
+
+  // Switches the channel to disconnected state and starts tearing down the
+  // connection. The teardown completes once all operations are drained.
+  void Disconnect(bool surprise);
+
+  void AddOperationReference();
+  void ReleaseOperationReference();
+
+  // Called once there are no outstanding operations left.
+  void FinishClose();
+
+  IoUringService *service_;
+  int socket_;
+
+  // Number of submitted operations plus one for the connection itself.
+  volatile int operation_references_;
+  Event drained_event_;
+  bool is_surprise_disconnect_;
+
+  IoUringOperation read_operation_;
+
+  Lock write_lock_;
+  IoUringOperation write_operation_;
+  std::deque<PendingWrite> pending_writes_;
+  bool is_write_in_flight_;
+
+  BufferPool buffer_pool_;
+  MessageFrameReader frame_reader_;
+
+  CallbackBase<int> *disconnected_callback_;
+
+  volatile int is_connected_;
+
+  DISALLOW_COPY_AND_ASSIGN(IoUringRpcChannel);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_IO_URING_RPC_CHANNEL_HPP__
@@ -0,0 +1,402 @@
+#include "io_uring_service.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace NanoRpc {
+
+namespace {
+
+int IoUringSetup(unsigned entries, io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete,
+                 unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit,
+                                  min_complete, flags, NULL, 0));
+}
+
+int IoUringRegister(int ring_fd, unsigned opcode, void *arg,
+                    unsigned nr_args) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+} // namespace
+
+IoUringService::IoUringService()
+    : ring_fd_(-1), sq_ring_(NULL), sq_ring_size_(0), sq_head_(NULL),
+      sq_tail_(NULL), sq_ring_mask_(NULL), sq_array_(NULL), sqes_(NULL),
+      sqes_size_(0), sq_entries_(0), cq_ring_(NULL), cq_ring_size_(0),
+      cq_head_(NULL), cq_tail_(NULL), cq_ring_mask_(NULL), cqes_(NULL),
+      is_running_(0), registered_buffer_size_(0) {}
+
+IoUringService::~IoUringService() { Stop(); }
+
+bool IoUringService::Start(int queue_depth, int buffer_count,
+                           int buffer_size) {
+  assert(queue_depth > 0);
+
+  if (is_running_)
+    return true;
+
+  if (!SetupRing(queue_depth))
+    return false;
+
+  // Failure to register buffers (e.g. because of RLIMIT_MEMLOCK) is not
+  // fatal, the service falls back to plain reads and writes.
+  if (buffer_count > 0 && buffer_size > 0)
+    RegisterBuffers(buffer_count, buffer_size);
+
+  __sync_lock_test_and_set(&is_running_, 1);
+
+  if (pthread_create(&completion_thread_, NULL, &CompletionThreadProcThunk,
+                     this) != 0) {
+    __sync_lock_test_and_set(&is_running_, 0);
+    UnregisterBuffers();
+    DestroyRing();
+    return false;
+  }
+
+  return true;
+}
+
+void IoUringService::Stop() {
+  if (!is_running_)
+    return;
+
+  assert(!IsServiceThread());
+
+  {
+    // Operation without a handler tells the completion thread to exit.
+    ScopedLock lock(submit_lock_);
+    io_uring_sqe *sqe = GetSubmissionEntry();
+    assert(sqe != NULL);
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = 0;
+    __atomic_store_n(sq_tail_, *sq_tail_ + 1, __ATOMIC_RELEASE);
+    FlushSubmissions();
+  }
+
+  pthread_join(completion_thread_, NULL);
+  __sync_lock_test_and_set(&is_running_, 0);
+
+  UnregisterBuffers();
+  DestroyRing();
+}
+
+bool IoUringService::IsServiceThread() const {
+  return is_running_ && pthread_equal(pthread_self(), completion_thread_);
+}
+
+char *IoUringService::AllocateBuffer(int min_size, int *buffer_index) {
+  assert(buffer_index != NULL);
+
+  if (min_size <= registered_buffer_size_) {
+    ScopedLock lock(buffer_lock_);
+    if (!free_buffer_indices_.empty()) {
+      *buffer_index = free_buffer_indices_.back();
+      free_buffer_indices_.pop_back();
+      return registered_buffers_[*buffer_index];
+    }
+  }
+
+  *buffer_index = -1;
+  return buffer_pool_.Allocate(min_size);
+}
+
+void IoUringService::DeallocateBuffer(char *buffer, int buffer_index) {
+  if (buffer_index >= 0) {
+    assert(registered_buffers_[buffer_index] == buffer);
+    ScopedLock lock(buffer_lock_);
+    free_buffer_indices_.push_back(buffer_index);
+  } else {
+    buffer_pool_.Deallocate(buffer);
+  }
+}
+
+bool IoUringService::SubmitRead(int fd, IoUringOperation *operation) {
+  return Submit(operation->buffer_index >= 0 ? IORING_OP_READ_FIXED
+                                             : IORING_OP_READV,
+                fd, operation);
+}
+
+bool IoUringService::SubmitWrite(int fd, IoUringOperation *operation) {
+  return Submit(operation->buffer_index >= 0 ? IORING_OP_WRITE_FIXED
+                                             : IORING_OP_WRITEV,
+                fd, operation);
+}
+
+bool IoUringService::Submit(int opcode, int fd, IoUringOperation *operation) {
+  assert(operation != NULL);
+  assert(operation->handler != NULL);
+  assert(operation->offset < operation->size);
+
+  if (!is_running_)
+    return false;
+
+  ScopedLock lock(submit_lock_);
+
+  io_uring_sqe *sqe = GetSubmissionEntry();
+  if (sqe == NULL)
+    return false;
+
+  sqe->opcode = static_cast<uint8_t>(opcode);
+  sqe->fd = fd;
+  sqe->user_data = reinterpret_cast<uintptr_t>(operation);
+
+  char *data = operation->buffer + operation->offset;
+  unsigned length = operation->size - operation->offset;
+
+  if (opcode == IORING_OP_READ_FIXED || opcode == IORING_OP_WRITE_FIXED) {
+    sqe->addr = reinterpret_cast<uintptr_t>(data);
+    sqe->len = length;
+    sqe->buf_index = static_cast<uint16_t>(operation->buffer_index);
+  } else {
+    // The vectored variants are the only plain ones that every io_uring
+    // capable kernel supports. The vector lives in the operation, which
+    // stays valid until the completion.
+    operation->vector.iov_base = data;
+    operation->vector.iov_len = length;
+    sqe->addr = reinterpret_cast<uintptr_t>(&operation->vector);
+    sqe->len = 1;
+  }
+
+  __atomic_store_n(sq_tail_, *sq_tail_ + 1, __ATOMIC_RELEASE);
+
+  // The completion thread submits everything queued while it processed
+  // the batch with a single system call before it goes to wait.
+  if (IsServiceThread())
+    return true;
+
+  return FlushSubmissions();
+}
+
+io_uring_sqe *IoUringService::GetSubmissionEntry() {
+  unsigned tail = *sq_tail_;
+  if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+    FlushSubmissions();
+    if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+      std::cout << "error: io_uring submission queue is full\n";
+      return NULL;
+    }
+  }
+
+  unsigned index = tail & *sq_ring_mask_;
+  io_uring_sqe *sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sq_array_[index] = index;
+  return sqe;
+}
+
+unsigned IoUringService::GetUnsubmittedCount() {
+  return *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+}
+
+bool IoUringService::FlushSubmissions() {
+  unsigned to_submit;
+  while ((to_submit = GetUnsubmittedCount()) > 0) {
+    int submitted = IoUringEnter(ring_fd_, to_submit, 0, 0);
+    if (submitted < 0) {
+      if (errno == EINTR)
+        continue;
+
+      // The completion queue is full, the entries stay queued until the
+      // completion thread reaps it and submits them.
+      if (errno == EAGAIN || errno == EBUSY)
+        return true;
+
+      return false;
+    }
+
+    // The entries went with another thread's call.
+    if (submitted == 0)
+      break;
+  }
+
+  return true;
+}
+
+int IoUringService::CompletionThreadProc() {
+  bool stop = false;
+  while (!stop) {
+    // The kernel submits no more than there is in the ring, so the entries
+    // another thread submits meanwhile are not submitted twice, and those
+    // left over stay counted by the ring itself.
+    unsigned to_submit;
+    {
+      ScopedLock lock(submit_lock_);
+      to_submit = GetUnsubmittedCount();
+    }
+
+    int result =
+        IoUringEnter(ring_fd_, to_submit, 1, IORING_ENTER_GETEVENTS);
+
+    if (result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      std::cout << "error: io_uring_enter failed with error " << errno
+                << "\n";
+      break;
+    }
+
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+      io_uring_cqe *cqe = &cqes_[head & *cq_ring_mask_];
+      IoUringOperation *operation =
+          reinterpret_cast<IoUringOperation *>(cqe->user_data);
+      int result = cqe->res;
+
+      // Release the slot before calling the handler, it may submit more.
+      ++head;
+      __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+      if (operation == NULL)
+        stop = true;
+      else
+        operation->handler->OperationCompleted(operation, result);
+
+      if (head == tail)
+        tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    }
+  }
+
+  return 0;
+}
+
+bool IoUringService::SetupRing(int queue_depth) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+
+  ring_fd_ = IoUringSetup(queue_depth, &params);
+  if (ring_fd_ < 0) {
+    ring_fd_ = -1;
+    return false;
+  }
+
+  sq_entries_ = params.sq_entries;
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    if (cq_ring_size_ > sq_ring_size_)
+      sq_ring_size_ = cq_ring_size_;
+    cq_ring_size_ = sq_ring_size_;
+  }
+
+  sq_ring_ = mmap(NULL, sq_ring_size_, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = NULL;
+    DestroyRing();
+    return false;
+  }
+
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(NULL, cq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = NULL;
+      DestroyRing();
+      return false;
+    }
+  }
+
+  void *sqes = mmap(NULL, sqes_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    DestroyRing();
+    return false;
+  }
+  sqes_ = reinterpret_cast<io_uring_sqe *>(sqes);
+
+  char *sq = reinterpret_cast<char *>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_ring_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+  char *cq = reinterpret_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_ring_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+  return true;
+}
+
+void IoUringService::DestroyRing() {
+  if (sqes_ != NULL)
+    munmap(sqes_, sqes_size_);
+  if (cq_ring_ != NULL && cq_ring_ != sq_ring_)
+    munmap(cq_ring_, cq_ring_size_);
+  if (sq_ring_ != NULL)
+    munmap(sq_ring_, sq_ring_size_);
+  if (ring_fd_ != -1)
+    close(ring_fd_);
+
+  sqes_ = NULL;
+  cq_ring_ = NULL;
+  sq_ring_ = NULL;
+  ring_fd_ = -1;
+}
+
+bool IoUringService::RegisterBuffers(int buffer_count, int buffer_size) {
+  assert(registered_buffers_.empty());
+
+  // Keep the registered buffers from being trimmed by the pool.
+  buffer_pool_.set_pool_size(buffer_pool_.get_pool_size() + buffer_count);
+
+  std::vector<iovec> vectors(buffer_count);
+  for (int i = 0; i < buffer_count; ++i) {
+    char *buffer = buffer_pool_.Allocate(buffer_size);
+    registered_buffers_.push_back(buffer);
+    vectors[i].iov_base = buffer;
+    vectors[i].iov_len = buffer_size;
+  }
+
+  if (IoUringRegister(ring_fd_, IORING_REGISTER_BUFFERS, &vectors[0],
+                      buffer_count) != 0) {
+    for (size_t i = 0; i < registered_buffers_.size(); ++i)
+      buffer_pool_.Deallocate(registered_buffers_[i]);
+    registered_buffers_.clear();
+    return false;
+  }
+
+  for (int i = buffer_count - 1; i >= 0; --i)
+    free_buffer_indices_.push_back(i);
+  registered_buffer_size_ = buffer_size;
+  return true;
+}
+
+void IoUringService::UnregisterBuffers() {
+  if (registered_buffers_.empty())
+    return;
+
+  // All channels must be closed by now.
+  assert(free_buffer_indices_.size() == registered_buffers_.size());
+
+  IoUringRegister(ring_fd_, IORING_UNREGISTER_BUFFERS, NULL, 0);
+
+  for (size_t i = 0; i < registered_buffers_.size(); ++i)
+    buffer_pool_.Deallocate(registered_buffers_[i]);
+  registered_buffers_.clear();
+  free_buffer_indices_.clear();
+  registered_buffer_size_ = 0;
+}
+
+} // namespace
@@ -0,0 +1,163 @@
+#if !defined(NANO_RPC_IO_URING_SERVICE_HPP__)
+#define NANO_RPC_IO_URING_SERVICE_HPP__
+
+#include <vector>
+
+#include <pthread.h>
+#include <sys/uio.h>
+
+#include "basictypes.hpp"
+#include "buffer_pool.hpp"
+#include "synchronization_primitives.hpp"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace NanoRpc {
+
+// Read or write submitted to the ring.
+//
+// The buffer is obtained from IoUringService::AllocateBuffer. If the buffer
+// is one of the registered buffers, buffer_index refers to it and the
+// operation is submitted as fixed buffer read or write, otherwise it is -1.
+// The operation transfers bytes [offset, size) of the buffer.
+struct IoUringOperation {
+  class IHandler {
+  public:
+    virtual ~IHandler() {}
+
+    // Called on the service thread. The result is the number of bytes
+    // transferred or negated errno value.
+    virtual void OperationCompleted(IoUringOperation *operation,
+                                    int result) = 0;
+  };
+
+  IoUringOperation()
+      : handler(NULL), buffer(NULL), buffer_index(-1), size(0), offset(0) {}
+
+  IHandler *handler;
+  char *buffer;
+  int buffer_index;
+  int size;
+  int offset;
+
+  // Used by the service for operations on non-registered buffers.
+  iovec vector;
+};
+
+// Single io_uring instance shared by many connections.
+//
+// The service owns the submission and completion rings and a thread that
+// reaps completions in batches. Operations submitted from the completion
+// handlers (which is where reads are re-armed) are not submitted
+// individually; they are queued and handed to the kernel with a single
+// io_uring_enter once the whole batch of completions is processed.
+// Operations submitted from other threads are submitted immediately.
+//
+// A fixed set of buffers is allocated from the buffer pool and registered
+// with the kernel, so reads and writes into them skip the per-operation
+// page pinning. When all registered buffers are in use, or the requested
+// size exceeds the registered buffer size, plain pooled buffers are used.
+//
+// This implementation is only available on Linux 5.1 and later.
+class IoUringService {
+public:
+  static const int DefaultQueueDepth = 256;
+  static const int DefaultBufferCount = 64;
+  static const int DefaultBufferSize = 64 * 1024;
+
+  IoUringService();
+  ~IoUringService();
+
+  // Returns false if io_uring is not supported by the kernel or setup
+  // failed otherwise.
+  bool Start(int queue_depth = DefaultQueueDepth,
+             int buffer_count = DefaultBufferCount,
+             int buffer_size = DefaultBufferSize);
+
+  // All channels that use the service must be closed before it is stopped.
+  void Stop();
+
+  bool IsRunning() const { return is_running_ != 0; }
+
+  // Returns true if called from the completion thread.
+  bool IsServiceThread() const;
+
+  int get_registered_buffer_size() const { return registered_buffer_size_; }
+
+  // Allocates buffer at least of the specified size. Prefers registered
+  // buffers, in which case buffer index is set to the buffer slot,
+  // otherwise it is set to -1.
+  char *AllocateBuffer(int min_size, int *buffer_index);
+  void DeallocateBuffer(char *buffer, int buffer_index);
+
+  // Both return false if the service is not running or the ring is broken.
+  bool SubmitRead(int fd, IoUringOperation *operation);
+  bool SubmitWrite(int fd, IoUringOperation *operation);
+
+private:
+  static void *CompletionThreadProcThunk(void *parameter) {
+    IoUringService *service = reinterpret_cast<IoUringService *>(parameter);
+    service->CompletionThreadProc();
+    return NULL;
+  }
+
+  int CompletionThreadProc();
+
+  bool SetupRing(int queue_depth);
+  void DestroyRing();
+
+  bool RegisterBuffers(int buffer_count, int buffer_size);
+  void UnregisterBuffers();
+
+  // Prepares submission queue entry. Must be called with submit_lock_ held.
+  io_uring_sqe *GetSubmissionEntry();
+
+  bool Submit(int opcode, int fd, IoUringOperation *operation);
+
+  // Returns the number of the entries queued but not yet consumed by the
+  // kernel. Must be called with submit_lock_ held.
+  unsigned GetUnsubmittedCount();
+
+  // Hands queued entries to the kernel. Must be called with submit_lock_
+  // held.
+  bool FlushSubmissions();
+
+  int ring_fd_;
+
+  // Submission ring, shared with the kernel.
+  void *sq_ring_;
+  size_t sq_ring_size_;
+  unsigned *sq_head_;
+  unsigned *sq_tail_;
+  unsigned *sq_ring_mask_;
+  unsigned *sq_array_;
+  io_uring_sqe *sqes_;
+  size_t sqes_size_;
+  unsigned sq_entries_;
+
+  // Completion ring, shared with the kernel.
+  void *cq_ring_;
+  size_t cq_ring_size_;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned *cq_ring_mask_;
+  io_uring_cqe *cqes_;
+
+  Lock submit_lock_;
+
+  pthread_t completion_thread_;
+  volatile int is_running_;
+
+  BufferPool buffer_pool_;
+  std::vector<char *> registered_buffers_;
+  std::vector<int> free_buffer_indices_;
+  int registered_buffer_size_;
+  Lock buffer_lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(IoUringService);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_IO_URING_SERVICE_HPP__
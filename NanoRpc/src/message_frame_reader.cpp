@@ -0,0 +1,120 @@
+#include "message_frame_reader.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#include <stdint.h>
+
+namespace NanoRpc {
+
+namespace {
+
+const int PrefixSize = 4;
+
+// The remainder of the buffer is compacted before the read, if there is
+// less free space than this at the end.
+const int MinReadSize = 4 * 1024;
+
+} // namespace
+
+MessageFrameReader::MessageFrameReader(BufferPool *buffer_pool,
+                                       int buffer_size)
+    : buffer_pool_(buffer_pool), buffer_size_(buffer_size), buffer_(NULL),
+      capacity_(0), data_begin_(0), data_end_(0) {
+  assert(buffer_pool_ != NULL);
+  assert(buffer_size_ > MinReadSize);
+}
+
+MessageFrameReader::~MessageFrameReader() { Reset(); }
+
+char *MessageFrameReader::PrepareRead(int *size) {
+  assert(size != NULL);
+
+  int buffered = GetBufferedBytes();
+  if (buffered == 0)
+    data_begin_ = data_end_ = 0;
+
+  // If the prefix of the pending message is known, make sure the whole
+  // message fits.
+  int required = buffer_size_;
+  if (buffered >= PrefixSize) {
+    // TODO: For sake of compatibility use protobuf IO to serialize the
+    // message size.
+    int32_t message_size;
+    memcpy(&message_size, buffer_ + data_begin_, sizeof(message_size));
+    if (message_size > 0 && message_size <= MaxMessageSize &&
+        message_size + PrefixSize > required)
+      required = message_size + PrefixSize;
+  }
+
+  if (capacity_ < required) {
+    Reallocate(required);
+  } else if (capacity_ > buffer_size_ && buffered == 0) {
+    // Do not hold on to a large buffer once the big message is through.
+    Reallocate(buffer_size_);
+  } else if (capacity_ - data_end_ < MinReadSize ||
+             capacity_ - data_begin_ < required) {
+    memmove(buffer_, buffer_ + data_begin_, buffered);
+    data_begin_ = 0;
+    data_end_ = buffered;
+  }
+
+  *size = capacity_ - data_end_;
+  return buffer_ + data_end_;
+}
+
+void MessageFrameReader::CommitRead(int bytes_read) {
+  assert(bytes_read >= 0);
+  assert(data_end_ + bytes_read <= capacity_);
+  data_end_ += bytes_read;
+}
+
+MessageFrameReader::Result
+MessageFrameReader::ReadNextMessage(const char **message, int *message_size) {
+  assert(message != NULL);
+  assert(message_size != NULL);
+
+  int buffered = GetBufferedBytes();
+  if (buffered < PrefixSize)
+    return NeedMoreData;
+
+  int32_t size;
+  memcpy(&size, buffer_ + data_begin_, sizeof(size));
+  if (size <= 0 || size > MaxMessageSize)
+    return InvalidFrame;
+
+  if (buffered < PrefixSize + size)
+    return NeedMoreData;
+
+  *message = buffer_ + data_begin_ + PrefixSize;
+  *message_size = size;
+  data_begin_ += PrefixSize + size;
+  return MessageAvailable;
+}
+
+void MessageFrameReader::Reset() {
+  if (buffer_ != NULL)
+    buffer_pool_->Deallocate(buffer_);
+  buffer_ = NULL;
+  capacity_ = 0;
+  data_begin_ = 0;
+  data_end_ = 0;
+}
+
+void MessageFrameReader::Reallocate(int capacity) {
+  int buffered = GetBufferedBytes();
+  assert(capacity >= buffered);
+
+  char *buffer = buffer_pool_->Allocate(capacity);
+  if (buffer_ != NULL) {
+    memcpy(buffer, buffer_ + data_begin_, buffered);
+    buffer_pool_->Deallocate(buffer_);
+  }
+
+  buffer_ = buffer;
+  capacity_ = capacity;
+  data_begin_ = 0;
+  data_end_ = buffered;
+}
+
+} // namespace
@@ -0,0 +1,73 @@
+#if !defined(NANO_RPC_MESSAGE_FRAME_READER_HPP__)
+#define NANO_RPC_MESSAGE_FRAME_READER_HPP__
+
+#include "basictypes.hpp"
+#include "buffer_pool.hpp"
+
+namespace NanoRpc {
+
+// Splits the incoming byte stream into messages framed with the 4-byte
+// length prefix.
+//
+// The stream is read directly into a rolling buffer that normally fits many
+// small messages, so a single read may deliver several of them. Complete
+// messages are returned in place; only a partially received message is
+// moved to the beginning of the buffer before the next read. The buffer
+// grows temporarily if a message does not fit into it.
+//
+// Usage:
+//   int size;
+//   char *target = reader.PrepareRead(&size);
+//   ... read up to size bytes into target ...
+//   reader.CommitRead(bytes_read);
+//   while (reader.ReadNextMessage(&message, &message_size) ==
+//          MessageFrameReader::MessageAvailable) { ... }
+//
+// This class is not thread safe.
+class MessageFrameReader {
+public:
+  static const int DefaultBufferSize = 64 * 1024;
+
+  // Upper bound for the incoming message size. Anything bigger is treated as
+  // a protocol error rather than an allocation request.
+  static const int MaxMessageSize = 64 * 1024 * 1024;
+
+  enum Result { NeedMoreData, MessageAvailable, InvalidFrame };
+
+  explicit MessageFrameReader(BufferPool *buffer_pool,
+                              int buffer_size = DefaultBufferSize);
+  ~MessageFrameReader();
+
+  // Returns the space where the next read should store the data.
+  // Invalidates messages returned by ReadNextMessage.
+  char *PrepareRead(int *size);
+
+  // Accounts the bytes stored by the read.
+  void CommitRead(int bytes_read);
+
+  // Returns the next complete message, if there is any. The message data
+  // stays valid until the next call to PrepareRead.
+  Result ReadNextMessage(const char **message, int *message_size);
+
+  // Drops all buffered data and releases the buffer.
+  void Reset();
+
+private:
+  int GetBufferedBytes() const { return data_end_ - data_begin_; }
+
+  void Reallocate(int capacity);
+
+  BufferPool *buffer_pool_;
+  int buffer_size_;
+
+  char *buffer_;
+  int capacity_;
+  int data_begin_;
+  int data_end_;
+
+  DISALLOW_COPY_AND_ASSIGN(MessageFrameReader);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_MESSAGE_FRAME_READER_HPP__
@@ -1,5 +1,10 @@
 // This implementation uses exclusively asynchronous I/O for the reason of
 // properly handling surprise disconnect condition.
+//
+// All I/O goes through the shared IoCompletionService. Completions of the
+// same channel may be delivered to several service threads at once, so the
+// channel keeps at most one read in flight and issues the writes under
+// io_lock_, which keeps the messages in order in both directions.
 
 #include "named_pipe_rpc_channel.hpp"
 
@@ -12,333 +17,393 @@
 namespace NanoRpc {
 
 NamedPipeRpcChannel::NamedPipeRpcChannel(RpcController *controller,
-                                         HANDLE pipe_handle)
-    : RpcChannel(controller), pipe_(pipe_handle), completion_port_(NULL),
-      completion_thread_id_(0), completion_thread_(NULL),
-      disconnected_callback_(NULL), is_connected_(NotConnected) {}
+                                         HANDLE pipe_handle,
+                                         IoCompletionService *service)
+    : RpcChannel(controller),
+      service_(service != NULL ? service : IoCompletionService::GetDefault()),
+      pipe_(pipe_handle), operation_references_(0),
+      drained_event_(true, false), is_surprise_disconnect_(false),
+      send_queue_(&buffer_pool_), flush_timer_(NULL), is_flush_scheduled_(0),
+      frame_reader_(&buffer_pool_), disconnected_callback_(NULL),
+      is_connected_(NotConnected) {
+  start_overlapped_.operation_ = OverlappedOperation::Start;
+  flush_overlapped_.operation_ = OverlappedOperation::Flush;
+}
 
-NamedPipeRpcChannel::~NamedPipeRpcChannel() { Close(); }
+NamedPipeRpcChannel::~NamedPipeRpcChannel() {
+  Close();
+  Detach();
+  assert(operation_references_ == 0);
+}
 
 bool NamedPipeRpcChannel::Start() {
-  if (InterlockedCompareExchange(&is_connected_, Connected, NotConnected) ==
-      NotConnected) {
-    completion_port_ = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0);
-    if (completion_port_ == NULL) {
-      InterlockedExchange(&is_connected_, NotConnected);
-      return false;
-    }
-
-    completion_thread_ =
-        CreateThread(NULL, 0, &IoCompletionThreadProcThunk, this,
-                     CREATE_SUSPENDED, &completion_thread_id_);
-    if (completion_thread_ == NULL) {
-      CloseHandle(completion_port_);
-      InterlockedExchange(&is_connected_, NotConnected);
-      return false;
-    }
+  if (InterlockedCompareExchange(&is_connected_, Connected, NotConnected) !=
+      NotConnected)
+    return true;
 
-    if (CreateIoCompletionPort(pipe_, completion_port_, (ULONG_PTR)pipe_, 0) ==
-        NULL) {
-      CloseHandle(completion_port_);
-      InterlockedExchange(&is_connected_, NotConnected);
-      return false;
-    }
+  if (service_ == NULL || !service_->Associate(pipe_, this)) {
+    InterlockedExchange(&is_connected_, NotConnected);
+    return false;
+  }
 
-    if (ResumeThread(completion_thread_) == (DWORD) - 1) {
-      // This is fatal condition. We cannot restart it again, because the pipe
-      // is already associated with
-      // completion port, so, we cannot retry it.
-      InterlockedExchange(&is_connected_, Disconnected);
-      return false;
-    }
+  operation_references_ = 1;
+  drained_event_.Reset();
+
+  // We should not attempt to start asynchronous read here because the thread
+  // that called Start may exit and then overlapped operation would fail.
+  // This is the case when connector callback is called and we create channel
+  // directly from the callback. So the first read is started from the service
+  // thread.
+  bool posted;
+  {
+    ScopedLock lock(io_lock_);
+    posted = PostOperation(&start_overlapped_);
+  }
 
-    // We should not attempt to start asynchronous read here because the thread
-    // that
-    // called Start may exit and then overlapped operation would fail.
-    // This is the case when connector callback is called and we create channel
-    // directly from the callback.
-    // StartRead( sizeof( __int32 ), OverlappedOperation::ReadPrefix );
+  if (!posted) {
+    // This is fatal condition. We cannot restart it again, because the pipe
+    // is already associated with completion port, so, we cannot retry it.
+    Disconnect(false);
+    return false;
   }
 
   return true;
 }
 
 void NamedPipeRpcChannel::Close() {
-  LONG was = InterlockedExchange(&is_connected_, Disconnected);
-  if (was != Disconnected) {
-    DWORD flags = 0;
-    if (GetNamedPipeInfo(pipe_, &flags, NULL, NULL, NULL) != FALSE) {
-      if (flags & PIPE_SERVER_END)
-        DisconnectNamedPipe(pipe_);
-    }
-    CloseConnection();
+  if (InterlockedCompareExchange(&is_connected_, Disconnected, NotConnected) ==
+      NotConnected) {
+    CloseHandle(pipe_);
+    pipe_ = NULL;
+    return;
   }
+
+  Disconnect(false);
+
+  // On the service thread the teardown completes when the current
+  // operation returns.
+  if (!service_->IsServiceThread())
+    drained_event_.Wait();
 }
 
 void NamedPipeRpcChannel::Send(const RpcMessage &message) {
   if (is_connected_ != Connected)
     return; // TODO: false;
 
-  Overlapped *overlapped =
-      AllocateOverlappedState(message.ByteSize() + sizeof(__int32));
-
-  *(__int32 *)overlapped->buffer = message.ByteSize();
-  if (!message.SerializeToArray(overlapped->buffer + sizeof(__int32),
-                                message.ByteSize()))
-    assert(false); // TODO: return proper error to the upper level in release
+  // The message is written by a service thread together with whatever else
+  // gets queued meanwhile. The queue is checked after every completion of
+  // the channel, so only the first message of a burst posts the flush.
+  if (send_queue_.Push(message)) {
+    ScopedLock lock(io_lock_);
+    if (is_connected_ == Connected) {
+      // Completion packet without overlapped structure requests the flush.
+      PostOperation(NULL);
+    }
+  }
+}
 
-  overlapped->operation_ = OverlappedOperation::Write;
-  if (WriteFile(pipe_, overlapped->buffer, message.ByteSize() + sizeof(__int32),
-                NULL, overlapped) == FALSE) {
-    // TODO: Handle ERROR_OPERATION_ABORTED when CancelIOEx implementation added
-    // to disconnect.
-    // This would not be a surprise disconnect though.
+void NamedPipeRpcChannel::OperationCompleted(OVERLAPPED *overlapped,
+                                             DWORD bytes_transferred,
+                                             DWORD error) {
+  Overlapped *operation = static_cast<Overlapped *>(overlapped);
+  if (operation != NULL) {
+    switch (operation->operation_) {
+    case OverlappedOperation::Read:
+      ReadOperationCompleted(operation, bytes_transferred, error);
+      break;
+
+    case OverlappedOperation::Write:
+      WriteOperationCompleted(operation, bytes_transferred, error);
+      break;
+
+    case OverlappedOperation::Start:
+      StartRead();
+      break;
+
+    case OverlappedOperation::Flush: {
+      bool flushed;
+      {
+        ScopedLock lock(io_lock_);
+        DeleteTimerQueueTimer(NULL, flush_timer_, NULL);
+        flush_timer_ = NULL;
+        is_flush_scheduled_ = 0;
+        flushed = FlushSendQueue();
+      }
+      if (!flushed)
+        Disconnect(true);
+      break;
+    }
 
-    if (GetLastError() == ERROR_BROKEN_PIPE) {
-      FreeOverlappedState(overlapped);
-      std::cout << "error: Pipe broken while attempting to write\n";
-      std::cout.flush();
-      HandleSurpriseDisconnect();
-      // TODO: return false;
-    } else if (GetLastError() != ERROR_IO_PENDING) {
-      FreeOverlappedState(overlapped);
-      std::cout << "error: GetLastError() == " << GetLastError() << "\n";
-      std::cout.flush();
-      // TODO: return false;
+    default:
+      assert(false); // Unknown operation
+      break;
     }
   }
+
+  // Writes queued by the completion handlers or other threads.
+  if (is_connected_ == Connected && !FlushSendQueueIfDue())
+    Disconnect(true);
+
+  ReleaseOperationReference();
+}
+
+void NamedPipeRpcChannel::FlushTimerCallback() {
+  // The timer holds the operation reference, the packet takes it over.
+  if (service_->Post(this, &flush_overlapped_))
+    return;
+
+  // Nobody deletes the timer then. The reference may be the last one, and
+  // FinishClose expects the timer gone.
+  {
+    ScopedLock lock(io_lock_);
+    DeleteTimerQueueTimer(NULL, flush_timer_, NULL);
+    flush_timer_ = NULL;
+    is_flush_scheduled_ = 0;
+  }
+  ReleaseOperationReference();
+}
+
+bool NamedPipeRpcChannel::FlushSendQueueIfDue() {
+  if (send_queue_.IsEmpty())
+    return true;
+
+  ScopedLock lock(io_lock_);
+
+  DWORD flush_delay = send_queue_.get_flush_delay();
+  if (flush_delay == 0 || send_queue_.IsFull())
+    return FlushSendQueue();
+
+  // Wait for more messages, the timer flushes whatever is queued by then.
+  if (is_connected_ != Connected || is_flush_scheduled_ != 0)
+    return true;
+
+  AddOperationReference();
+  if (CreateTimerQueueTimer(&flush_timer_, NULL, &FlushTimerCallbackThunk,
+                            this, flush_delay, 0,
+                            WT_EXECUTEONLYONCE) == FALSE) {
+    std::cout << "warning: Failed to create flush timer: " << GetLastError()
+              << "\n";
+    flush_timer_ = NULL;
+    ReleaseOperationReference();
+    return FlushSendQueue();
+  }
+
+  is_flush_scheduled_ = 1;
+  return true;
 }
 
-void
-NamedPipeRpcChannel::StartRead(int expected_size,
-                               OverlappedOperation::Type requested_operation) {
+bool NamedPipeRpcChannel::FlushSendQueue() {
   if (is_connected_ != Connected)
-    return; // TODO: false;
+    return true;
+
+  SendQueue::Item *items = send_queue_.TakeAll();
 
-  Overlapped *overlapped = AllocateOverlappedState(expected_size);
-  overlapped->operation_ = requested_operation;
+  char *buffer;
+  int size;
+  while (send_queue_.GetNextWrite(&items, &buffer, &size)) {
+    // The overlapped state takes ownership of the buffer.
+    Overlapped *overlapped = overlapped_pool_.Allocate();
+    overlapped->buffer = buffer;
+    overlapped->operation_ = OverlappedOperation::Write;
 
-  if (ReadFile(pipe_, overlapped->buffer, expected_size, NULL, overlapped) ==
-      FALSE) {
-    // TODO: Handle ERROR_OPERATION_ABORTED when CancelIOEx implementation added
-    // to disconnect.
-    // This would not be a surprise disconnect though.
+    AddOperationReference();
+    if (WriteFile(pipe_, buffer, size, NULL, overlapped) == FALSE &&
+        GetLastError() != ERROR_IO_PENDING) {
+      DWORD error = GetLastError();
 
-    if (GetLastError() == ERROR_BROKEN_PIPE) {
+      // The caller holds a reference, so this is never the last one.
       FreeOverlappedState(overlapped);
-      std::cout << "error: Pipe broken while attempting to read\n";
+      ReleaseOperationReference();
+      send_queue_.FreeItems(items);
+
+      if (error == ERROR_BROKEN_PIPE)
+        std::cout << "error: Pipe broken while attempting to write\n";
+      else
+        std::cout << "error: GetLastError() == " << error << "\n";
       std::cout.flush();
-      HandleSurpriseDisconnect();
-    } else if (GetLastError() != ERROR_IO_PENDING) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void NamedPipeRpcChannel::StartRead() {
+  DWORD error = ERROR_SUCCESS;
+  {
+    ScopedLock lock(io_lock_);
+    if (is_connected_ != Connected)
+      return; // TODO: false;
+
+    int size;
+    char *buffer = frame_reader_.PrepareRead(&size);
+
+    // The buffer belongs to the frame reader, so it is not attached to the
+    // overlapped state.
+    Overlapped *overlapped = overlapped_pool_.Allocate();
+    overlapped->operation_ = OverlappedOperation::Read;
+
+    AddOperationReference();
+    if (ReadFile(pipe_, buffer, size, NULL, overlapped) == FALSE &&
+        GetLastError() != ERROR_IO_PENDING) {
+      error = GetLastError();
       FreeOverlappedState(overlapped);
-      std::cout << "error: GetLastError() == " << GetLastError() << "\n";
-      std::cout.flush();
+      ReleaseOperationReference();
     }
   }
+
+  if (error != ERROR_SUCCESS) {
+    if (error == ERROR_BROKEN_PIPE)
+      std::cout << "error: Pipe broken while attempting to read\n";
+    else
+      std::cout << "error: GetLastError() == " << error << "\n";
+    std::cout.flush();
+    Disconnect(true);
+  }
 }
 
 void NamedPipeRpcChannel::ReadOperationCompleted(Overlapped *overlapped,
-                                                 DWORD bytes_read) {
-  // std::cout << "Read operation " << overlapped->operation_ << " completed\n";
-  // std::cout.flush();
-
-  if (overlapped->operation_ == OverlappedOperation::ReadPrefix) {
-    assert(bytes_read == sizeof(__int32));
-    // TODO: For sake of compatibility use protobuf IO to serialize the message
-    // size.
-    int expected_message_size = *(__int32 *)overlapped->buffer;
-
-    // Free resource as soon as we finished dealing with it.
-    FreeOverlappedState(overlapped);
-    StartRead(expected_message_size, OverlappedOperation::ReadMessage);
-  } else if (overlapped->operation_ == OverlappedOperation::ReadMessage) {
-    RpcMessage message;
-    if (!message.ParseFromArray(overlapped->buffer, bytes_read))
-      assert(false); // TODO: Handle error in release
-
-    // Free resource as soon as we finished dealing with it.
-    FreeOverlappedState(overlapped);
-
-    // Start next read before we process the message, so we don't have to wait
-    // for Receive to handle current message.
-    // TODO: Thie only problem with this is that we still blocking the
-    // IoCompletionThreadProc.
-    // So we get a lockup if client (native) receives event and attempts to make
-    // a synchronous call.
-    // This precisely problem does not occur in the .NET channel, because thread
-    // pool is used to handle I/O.
-    StartRead(sizeof(__int32), OverlappedOperation::ReadPrefix);
-
-    // TODO: Note that we pass local instance here,
-    // so make sure we do not invoke any asyncronous operation downstream
-    // with this message without copying it first.
-    // Starting another read before Receive finished may also improve
-    // performance in case
-    // the client is multithreaded and uses the same channel for all threads.
-    Receive(message);
-  } else {
-    assert(false); // Unexpected operation
+                                                 DWORD bytes_read,
+                                                 DWORD error) {
+  assert(overlapped->operation_ == OverlappedOperation::Read);
+  FreeOverlappedState(overlapped);
+
+  if (error != ERROR_SUCCESS) {
+    // ERROR_OPERATION_ABORTED is expected after the channel disconnected.
+    if (is_connected_ == Connected) {
+      if (error == ERROR_BROKEN_PIPE)
+        std::cout << "Pipe broken\n";
+      else
+        std::cout << "Overlapped operation failed: " << error << "\n";
+    }
+    Disconnect(true);
+    return;
+  }
+
+  frame_reader_.CommitRead(bytes_read);
+
+  // The read may deliver several messages and a part of the next one.
+  // Parse all complete ones before the next read reuses the buffer.
+  size_t message_count = 0;
+  const char *data;
+  int size;
+  MessageFrameReader::Result result;
+  while ((result = frame_reader_.ReadNextMessage(&data, &size)) ==
+         MessageFrameReader::MessageAvailable) {
+    if (message_count == received_messages_.size())
+      received_messages_.push_back(RpcMessage());
+    if (!received_messages_[message_count].ParseFromArray(data, size)) {
+      result = MessageFrameReader::InvalidFrame;
+      break;
+    }
+    ++message_count;
+  }
+
+  if (result == MessageFrameReader::InvalidFrame) {
+    std::cout << "error: Received malformed message\n";
+    std::cout.flush();
+    Disconnect(true);
+    return;
   }
+
+  // The next read is started only after the messages are processed. Its
+  // completion could otherwise be delivered to another service thread and
+  // processed ahead of (and over) the messages of this read.
+  // The server hands the calls over to its worker pool, so this does not
+  // hold the next read for long.
+  // TODO: Without the worker pool the calls still block the service thread.
+  // So we get a lockup if client (native) receives event and attempts to make
+  // a synchronous call.
+  for (size_t i = 0; i < message_count && is_connected_ == Connected; ++i)
+    Receive(received_messages_[i]);
+
+  StartRead();
 }
 
 void NamedPipeRpcChannel::WriteOperationCompleted(Overlapped *overlapped,
-                                                  DWORD bytes_written) {
-  // std::cout << "Write operation " << overlapped->operation_ << "
-  // completed\n";
-  // std::cout.flush();
+                                                  DWORD bytes_written,
+                                                  DWORD error) {
+  assert(overlapped->operation_ == OverlappedOperation::Write);
   FreeOverlappedState(overlapped);
+
+  if (error != ERROR_SUCCESS && is_connected_ == Connected) {
+    if (error == ERROR_BROKEN_PIPE)
+      std::cout << "error: Pipe broken while attempting to write\n";
+    else
+      std::cout << "Overlapped operation failed: " << error << "\n";
+    std::cout.flush();
+    Disconnect(true);
+  }
 }
 
-int NamedPipeRpcChannel::IoCompletionThreadProc() {
-  // See note in Start
-  StartRead(sizeof(__int32), OverlappedOperation::ReadPrefix);
-
-  while (is_connected_ == Connected) {
-    DWORD bytes_transferred;
-    ULONG_PTR key;
-    Overlapped *overlapped = NULL;
-    if (GetQueuedCompletionStatus(completion_port_, &bytes_transferred, &key,
-                                  (OVERLAPPED **)&overlapped,
-                                  INFINITE) == FALSE) {
-      std::cout << "Overlapped operation failed: " << GetLastError() << "\n";
-
-      // If overlapped is NULL then GetQueuedCompletionStatus failed because of
-      // invalid
-      // parameter or completion_port_ handle was closed.
-      // This would also happen if timeout parameter is not INFINITE (which is
-      // not the case here).
-      if (overlapped != NULL)
-        FreeOverlappedState(overlapped);
-
-      // TODO: We possibly need to handle ERROR_OPERATION_ABORTED when
-      // CancelIOEx implementation added to disconnect.
-      // This would not be a surprise disconnect though.
-      if (GetLastError() == ERROR_BROKEN_PIPE) {
-        std::cout << "Pipe broken\n";
-        HandleSurpriseDisconnect();
-        break;
-      }
-    } else {
-      switch (overlapped->operation_) {
-      case OverlappedOperation::ReadPrefix:
-      case OverlappedOperation::ReadMessage:
-        ReadOperationCompleted(overlapped, bytes_transferred);
-        break;
-
-      case OverlappedOperation::Write:
-        WriteOperationCompleted(overlapped, bytes_transferred);
-        break;
-
-      default:
-        assert(false); // Unknown operation
-        break;
-      }
-    }
+bool NamedPipeRpcChannel::PostOperation(Overlapped *overlapped) {
+  AddOperationReference();
+  if (!service_->Post(this, overlapped)) {
+    std::cout << "error: Failed to post completion packet: " << GetLastError()
+              << "\n";
+    ReleaseOperationReference();
+    return false;
   }
 
-  return 0;
+  return true;
 }
 
-HANDLE NamedPipeRpcChannel::CloseConnection() {
-  assert(completion_port_ != NULL);
-  assert(pipe_ != NULL);
-  assert(completion_thread_ != NULL);
-
-  // At this point we need to drain all pending operations from the
-  // I/O completion port queue and ensure none new are queued.
-  // We spin here until we see that all overlapped objects returned to the pool.
-
-  int last_free_object_count = overlapped_pool_.GetFreeObjectsCount();
-  int attempts = 0;
-
-  while (overlapped_pool_.GetTotalObjectsCount() -
-             overlapped_pool_.GetFreeObjectsCount() >
-         0) {
-    DWORD bytes_transferred;
-    ULONG_PTR key;
-    Overlapped *overlapped = NULL;
-
-    if (GetQueuedCompletionStatus(completion_port_, &bytes_transferred, &key,
-                                  (OVERLAPPED **)&overlapped, 0) == FALSE) {
-      if (overlapped != NULL) {
-        FreeOverlappedState(overlapped);
-      } else {
-        // If the previous call failed, we wait a bit, then we check if any
-        // objects
-        // were freed since the last failure. If some objects were freed,
-        // then we reset number of attempts and still keep trying.
-        // If no object were freed, then we so few more attempts before bailing
-        // out.
-        Sleep(500);
-
-        if (last_free_object_count < overlapped_pool_.GetFreeObjectsCount()) {
-          attempts = 10;
-          last_free_object_count = overlapped_pool_.GetFreeObjectsCount();
-        } else {
-          if (--attempts == 0) {
-            int used = overlapped_pool_.GetTotalObjectsCount() -
-                       overlapped_pool_.GetFreeObjectsCount();
-            std::cout << "warning: Failed to release overlapped buffers. "
-                      << used << " buffers are still appears to be used.\n";
-            break;
-          }
-        }
-      }
-    }
+void NamedPipeRpcChannel::Disconnect(bool surprise) {
+  {
+    // Operations are issued under the same lock, so none is started once
+    // the state changes.
+    ScopedLock lock(io_lock_);
+    if (InterlockedCompareExchange(&is_connected_, Disconnected, Connected) !=
+        Connected)
+      return;
+    is_surprise_disconnect_ = surprise;
   }
 
-  // If HandleSurpriseDisconnect was called from the I/O completion thread,
-  // then it will finish after the callback is called.
-  // Otherwise, it would finish too, but we want to check if our assumptions
-  // are correct.
-  if (GetCurrentThreadId() != completion_thread_id_) {
-    DWORD wait_result = WaitForSingleObject(completion_thread_, 2000);
-    if (wait_result == WAIT_TIMEOUT) {
-      // TODO: Spit debugger message instead
-      std::cout << "warning: The I/O completion thread seems to hung.\n";
+  ReceiveChannelFailure();
+
+  if (!surprise) {
+    DWORD flags = 0;
+    if (GetNamedPipeInfo(pipe_, &flags, NULL, NULL, NULL) != FALSE) {
+      if (flags & PIPE_SERVER_END)
+        DisconnectNamedPipe(pipe_);
     }
-    assert(wait_result == WAIT_TIMEOUT);
   }
 
-  HANDLE pipe = pipe_;
+  // Completes the operations that are in flight.
+  CancelIoEx(pipe_, NULL);
 
-  CloseHandle(completion_thread_);
-  completion_thread_id_ = 0;
-  completion_thread_ = NULL;
-
-  CloseHandle(pipe_);
-  CloseHandle(completion_port_);
-  completion_port_ = NULL;
-  pipe_ = NULL;
-
-  return pipe;
+  ReleaseOperationReference();
 }
 
-void NamedPipeRpcChannel::HandleSurpriseDisconnect() {
-  // We can get here from multiple points, but only one should be allowed to do
-  // the work.
-  if (InterlockedCompareExchange(&is_connected_, Disconnected, Connected) ==
-      Connected) {
-    HANDLE pipe = CloseConnection();
-    InvokeDisconnectedCallback(pipe);
-  }
+void NamedPipeRpcChannel::AddOperationReference() {
+  InterlockedIncrement(&operation_references_);
 }
 
-void NamedPipeRpcChannel::InvokeDisconnectedCallback(HANDLE pipe) {
-  if (disconnected_callback_ != NULL)
-    disconnected_callback_->Invoke(pipe);
+void NamedPipeRpcChannel::ReleaseOperationReference() {
+  if (InterlockedDecrement(&operation_references_) == 0)
+    FinishClose();
 }
 
-Overlapped *NamedPipeRpcChannel::AllocateOverlappedState(int size) {
-  assert(size > 0);
+void NamedPipeRpcChannel::FinishClose() {
+  assert(flush_timer_ == NULL);
 
-  Overlapped *overlapped = overlapped_pool_.Allocate();
-  overlapped->buffer = buffer_pool_.Allocate(size);
+  // Drop whatever was not written.
+  send_queue_.Clear();
+  frame_reader_.Reset();
 
-  assert(overlapped != NULL);
-  assert(overlapped->buffer != NULL);
+  HANDLE pipe = pipe_;
+  CallbackBase<HANDLE> *callback =
+      is_surprise_disconnect_ ? disconnected_callback_ : NULL;
+
+  CloseHandle(pipe_);
+  pipe_ = NULL;
+
+  // The channel may be destroyed by the thread waiting in Close as soon as
+  // the event is set, so nothing past this point touches the members.
+  drained_event_.Set();
 
-  return overlapped;
+  if (callback != NULL)
+    callback->Invoke(pipe);
 }
 
 void NamedPipeRpcChannel::FreeOverlappedState(Overlapped *overlapped) {
@@ -1,6 +1,8 @@
 #if !defined(NANO_RPC_NAMED_PIPE_RPC_CHANNEL_HPP__)
 #define NANO_RPC_NAMED_PIPE_RPC_CHANNEL_HPP__
 
+#include <deque>
+
 #include <windows.h>
 
 #include "RpcMessageTypes.pb.h"
@@ -9,12 +11,16 @@
 #include "buffer_pool.hpp"
 #include "object_pool.hpp"
 #include "callback.hpp"
+#include "io_completion_service.hpp"
+#include "message_frame_reader.hpp"
+#include "send_queue.hpp"
+#include "synchronization_primitives.hpp"
 
 namespace NanoRpc {
 
 class OverlappedOperation {
 public:
-  enum Type { Undefined, ReadPrefix, ReadMessage, Write };
+  enum Type { Undefined, Read, Write, Start, Flush };
 };
 
 class Overlapped : public OVERLAPPED {
@@ -42,9 +48,25 @@ private:
   Overlapped &operator=(const Overlapped &);
 };
 
-class NamedPipeRpcChannel : public RpcChannel {
+// Channel over a named pipe opened for overlapped I/O.
+//
+// The I/O is serviced by an IoCompletionService, by default the process-wide
+// one, so the channel does not own any thread. Completions of the channel may
+// run on several service threads at once; only one read is in flight at any
+// time and writes are issued under io_lock_.
+//
+// The channel counts outstanding operations plus one reference for the
+// connection itself. Disconnecting cancels whatever is in flight and the
+// pipe is closed once the last reference is gone.
+//
+// The channel must not be destroyed on the service thread other than from
+// the disconnected callback.
+class NamedPipeRpcChannel : public RpcChannel,
+                            public IoCompletionService::IHandler {
 public:
-  NamedPipeRpcChannel(RpcController *controller, HANDLE pipe_handle);
+  // If no service is specified, IoCompletionService::GetDefault is used.
+  NamedPipeRpcChannel(RpcController *controller, HANDLE pipe_handle,
+                      IoCompletionService *service = NULL);
   ~NamedPipeRpcChannel();
 
   virtual bool Start();
@@ -59,42 +81,96 @@ public:
     return disconnected_callback_;
   }
 
+  // Outgoing messages are queued and written by the I/O completion threads,
+  // see SendQueue for the meaning of the limits.
+  void set_max_write_size(int max_write_size) {
+    send_queue_.set_max_write_size(max_write_size);
+  }
+  void set_flush_delay(unsigned int flush_delay) {
+    send_queue_.set_flush_delay(flush_delay);
+  }
+  void GetSendStatistics(SendQueue::Statistics *statistics) const {
+    send_queue_.GetStatistics(statistics);
+  }
+
 protected:
   virtual void Send(const RpcMessage &message);
 
+  virtual void OperationCompleted(OVERLAPPED *overlapped,
+                                  DWORD bytes_transferred, DWORD error);
+
 private:
   enum ChannelState { NotConnected = 0, Connected = 1, Disconnected = 2 };
 
-  int IoCompletionThreadProc();
-
-  static DWORD WINAPI IoCompletionThreadProcThunk(void *parameter) {
-    NamedPipeRpcChannel *channel =
-        reinterpret_cast<NamedPipeRpcChannel *>(parameter);
-    return channel->IoCompletionThreadProc();
+  static void CALLBACK FlushTimerCallbackThunk(void *parameter,
+                                               BOOLEAN timer_fired) {
+    reinterpret_cast<NamedPipeRpcChannel *>(parameter)->FlushTimerCallback();
   }
 
-  void StartRead(int size, OverlappedOperation::Type requested_operation);
+  void FlushTimerCallback();
+
+  void StartRead();
 
-  void ReadOperationCompleted(Overlapped *overlapped, DWORD bytes_read);
-  void WriteOperationCompleted(Overlapped *overlapped, DWORD bytes_written);
+  // Writes out the send queue, unless the flush is delayed, in which case
+  // the flush timer is started. FlushSendQueue must be called with io_lock_
+  // held.
+  // Both return false if the pipe is broken.
+  bool FlushSendQueueIfDue();
+  bool FlushSendQueue();
 
-  HANDLE CloseConnection();
+  void ReadOperationCompleted(Overlapped *overlapped, DWORD bytes_read,
+                              DWORD error);
+  void WriteOperationCompleted(Overlapped *overlapped, DWORD bytes_written,
+                               DWORD error);
 
-  void HandleSurpriseDisconnect();
+  // Posts the packet to the service, holding an operation reference until
+  // it is delivered.
+  bool PostOperation(Overlapped *overlapped);
 
-  void InvokeDisconnectedCallback(HANDLE pipe);
+  // Switches the channel to disconnected state and cancels the operations
+  // in flight. The teardown completes once all operations are drained.
+  void Disconnect(bool surprise);
+
+  void AddOperationReference();
+  void ReleaseOperationReference();
+
+  // Called once there are no outstanding operations left.
+  void FinishClose();
 
-  Overlapped *AllocateOverlappedState(int size);
   void FreeOverlappedState(Overlapped *overlapped);
 
+  IoCompletionService *service_;
   HANDLE pipe_;
-  HANDLE completion_port_;
-  DWORD completion_thread_id_;
-  HANDLE completion_thread_;
+
+  // Number of outstanding operations plus one for the connection itself.
+  volatile LONG operation_references_;
+  Event drained_event_;
+  bool is_surprise_disconnect_;
+
+  // Guards issuing of the reads and writes against the disconnect, and
+  // serializes the send queue consumers.
+  Lock io_lock_;
+
+  // Packets posted to start the first read and to flush the send queue
+  // once the flush delay expires.
+  Overlapped start_overlapped_;
+  Overlapped flush_overlapped_;
 
   BufferPool buffer_pool_;
   ObjectPool<Overlapped, Overlapped::Initializer> overlapped_pool_;
 
+  SendQueue send_queue_;
+  HANDLE flush_timer_;
+  volatile LONG is_flush_scheduled_;
+
+  // The pipe is read directly into the frame reader buffer. Only one read is
+  // in flight at any time.
+  MessageFrameReader frame_reader_;
+
+  // Messages parsed from the last read. Kept between reads, so the message
+  // objects are reused.
+  std::deque<RpcMessage> received_messages_;
+
   CallbackBase<HANDLE> *disconnected_callback_;
 
   volatile __declspec(align(32)) LONG is_connected_;  // TODO: Disconnected
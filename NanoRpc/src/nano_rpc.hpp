@@ -9,6 +9,7 @@
 #include "rpc_service.hpp"
 #include "rpc_stub.hpp"
 #include "rpc_object_manager.hpp"
+#include "rpc_packed_parameters.hpp"
 #include "string_conversion.hpp"
 
 #endif  // NANO_RPC_NANO_RPC_HPP__
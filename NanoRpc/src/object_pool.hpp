@@ -2,8 +2,13 @@
 #define NANO_RPC_OBJECT_POOL_HPP__
 
 #include <cassert>
+#if defined(_MSC_VER)
 #include <hash_set>
 #include <hash_map>
+#else
+#include <unordered_map>
+#include <unordered_set>
+#endif
 
 #include "basictypes.hpp"
 #include "synchronization_primitives.hpp"
@@ -34,15 +39,20 @@ class ObjectPool {
     bool used;
   };
 
+#if defined(_MSC_VER)
   typedef stdext::hash_map<const T *, Descriptor *> PointerToDescriptorMap;
   typedef stdext::hash_set<Descriptor *> DescriptorSet;
+#else
+  typedef std::unordered_map<const T *, Descriptor *> PointerToDescriptorMap;
+  typedef std::unordered_set<Descriptor *> DescriptorSet;
+#endif
 
 public:
   ObjectPool() {}
 
   ~ObjectPool() {
     ScopedLock lock(lock_);
-    for (PointerToDescriptorMap::iterator iter = all_objects_.begin();
+    for (typename PointerToDescriptorMap::iterator iter = all_objects_.begin();
          iter != all_objects_.end();
          iter++) {
       Descriptor *descriptor = iter->second;
@@ -63,10 +73,10 @@ public:
     if (free_objects_.size() == 0) {
       descriptor = new Descriptor();
       descriptor->data = new T();
-      all_objects_.insert(
-          PointerToDescriptorMap::value_type(descriptor->data, descriptor));
+      all_objects_.insert(typename PointerToDescriptorMap::value_type(
+          descriptor->data, descriptor));
     } else {
-      DescriptorSet::iterator first = free_objects_.begin();
+      typename DescriptorSet::iterator first = free_objects_.begin();
       descriptor = *first;
       free_objects_.erase(first);
 
@@ -84,7 +94,8 @@ public:
     ScopedLock lock(lock_);
 
     // Check that object belongs to the pool
-    PointerToDescriptorMap::const_iterator iter = all_objects_.find(object);
+    typename PointerToDescriptorMap::const_iterator iter =
+        all_objects_.find(object);
     assert(iter != all_objects_.end());
     if (iter == all_objects_.end())
       return;
@@ -0,0 +1,126 @@
+#include "pending_call_table.hpp"
+
+#include <cassert>
+
+#include "atomic_operations.hpp"
+
+namespace NanoRpc {
+
+void PendingCall::CompleteBatch(const RpcBatch & /* batch */) {
+  RpcResult result;
+  result.set_status(RpcProtocolError);
+  result.set_error_message("Unexpected batch result");
+  Complete(result);
+}
+
+PendingCallTable::PendingCallTable(size_t capacity)
+    : max_probe_count_(1), overflow_count_(0) {
+  size_t size = 1;
+  while (size < capacity)
+    size <<= 1;
+
+  slots_.resize(size);
+  mask_ = size - 1;
+}
+
+void PendingCallTable::Insert(long id, PendingCall *call) {
+  assert(id != 0);
+  assert(call != NULL);
+
+  if (InsertIntoSlot(id, call))
+    return;
+
+  ScopedLock lock(overflow_lock_);
+  overflow_calls_[id] = call;
+  AtomicIncrement(&overflow_count_);
+}
+
+bool PendingCallTable::InsertIntoSlot(long id, PendingCall *call) {
+  size_t start = static_cast<unsigned long>(id) & mask_;
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    Slot *slot = &slots_[(start + i) & mask_];
+    if (slot->call != NULL)
+      continue;
+    if (AtomicCompareExchangePointer(&slot->call, call,
+                                     static_cast<PendingCall *>(NULL)) != NULL)
+      continue;
+
+    // The lookups must scan this far before they can see the id.
+    long probe_count = static_cast<long>(i) + 1;
+    long current = max_probe_count_;
+    while (current < probe_count) {
+      long previous =
+          AtomicCompareExchange(&max_probe_count_, probe_count, current);
+      if (previous == current)
+        break;
+      current = previous;
+    }
+
+    AtomicExchange(&slot->id, id);
+    return true;
+  }
+
+  return false;
+}
+
+PendingCall *PendingCallTable::Remove(long id) {
+  assert(id != 0);
+
+  size_t start = static_cast<unsigned long>(id) & mask_;
+  size_t probe_count = static_cast<size_t>(max_probe_count_);
+  for (size_t i = 0; i < probe_count && i < slots_.size(); ++i) {
+    Slot *slot = &slots_[(start + i) & mask_];
+    if (slot->id != id)
+      continue;
+
+    PendingCall *call = RemoveFromSlot(slot, id);
+    if (call != NULL)
+      return call;
+  }
+
+  return overflow_count_ != 0 ? RemoveOverflow(id) : NULL;
+}
+
+PendingCall *PendingCallTable::RemoveAny() {
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    Slot *slot = &slots_[i];
+    long id = slot->id;
+    if (id == 0)
+      continue;
+
+    PendingCall *call = RemoveFromSlot(slot, id);
+    if (call != NULL)
+      return call;
+  }
+
+  return overflow_count_ != 0 ? RemoveOverflow(0) : NULL;
+}
+
+PendingCall *PendingCallTable::RemoveFromSlot(Slot *slot, long id) {
+  // Only one of the racing removers wins the id.
+  if (AtomicCompareExchange(&slot->id, 0, id) != id)
+    return NULL;
+
+  PendingCall *call = slot->call;
+  assert(call != NULL);
+
+  // Now the slot may be claimed again.
+  AtomicExchangePointer(&slot->call, static_cast<PendingCall *>(NULL));
+  return call;
+}
+
+PendingCall *PendingCallTable::RemoveOverflow(long id) {
+  ScopedLock lock(overflow_lock_);
+
+  OverflowMap::iterator iter =
+      id != 0 ? overflow_calls_.find(id) : overflow_calls_.begin();
+  if (iter == overflow_calls_.end())
+    return NULL;
+
+  PendingCall *call = iter->second;
+  overflow_calls_.erase(iter);
+  AtomicDecrement(&overflow_count_);
+  return call;
+}
+
+} // namespace
@@ -0,0 +1,94 @@
+#if !defined(NANO_RPC_PENDING_CALL_TABLE_HPP__)
+#define NANO_RPC_PENDING_CALL_TABLE_HPP__
+
+#include <map>
+#include <vector>
+
+#include "basictypes.hpp"
+#include "synchronization_primitives.hpp"
+#include "RpcMessageTypes.pb.h"
+
+namespace NanoRpc {
+
+// Call that waits for its result, see RpcFuture.
+class PendingCall {
+public:
+  virtual ~PendingCall() {}
+
+  // Called once, on the thread that received the result (or saw the
+  // channel fail).
+  virtual void Complete(const RpcResult &result) = 0;
+
+  // Called instead of Complete when the results of the batch are received.
+  // The call that was not sent in a batch fails with RpcProtocolError.
+  virtual void CompleteBatch(const RpcBatch &batch);
+};
+
+// Open-addressed table of the calls that wait for the result, keyed by the
+// message id. The calls that do not fit go to the overflow map under the
+// lock, so there may be any number of them, only the slower.
+//
+// Ids are handed out sequentially, so the slot is picked by the low bits of
+// the id and the probe sequence is linear. Collisions only happen when calls
+// complete far out of order. Lookups scan no further than the longest probe
+// sequence any insert has used so far, so a miss is cheap too.
+//
+// The slot is claimed by swapping the call in and published by storing the
+// id; it is released the other way round, so a slot is never reused before
+// the thread that removed the id is done with the call.
+//
+// All operations are lock-free while nothing overflows. This class is thread
+// safe.
+class PendingCallTable {
+public:
+  static const size_t DefaultCapacity = 1024;
+
+  // The capacity is rounded up to the power of two.
+  explicit PendingCallTable(size_t capacity = DefaultCapacity);
+
+  // The id must not be zero.
+  void Insert(long id, PendingCall *call);
+
+  // Returns NULL if there is no call with the id (e.g. the result is late
+  // and the call was already failed).
+  PendingCall *Remove(long id);
+
+  // Removes any call. Returns NULL if the table is empty.
+  PendingCall *RemoveAny();
+
+private:
+  struct Slot {
+    Slot() : id(0), call(NULL) {}
+
+    volatile long id;
+    PendingCall *volatile call;
+  };
+
+  typedef std::map<long, PendingCall *> OverflowMap;
+
+  // Returns false if there is no free slot.
+  bool InsertIntoSlot(long id, PendingCall *call);
+
+  // Removes the call from the slot if the slot holds the id.
+  PendingCall *RemoveFromSlot(Slot *slot, long id);
+
+  // Returns NULL if the id is not in the overflow map, or any call if the
+  // id is zero.
+  PendingCall *RemoveOverflow(long id);
+
+  std::vector<Slot> slots_;
+  size_t mask_;
+  volatile long max_probe_count_;
+
+  // Guarded by the lock. The count is checked without it, so the lookups
+  // do not take the lock while nothing overflows.
+  OverflowMap overflow_calls_;
+  volatile long overflow_count_;
+  Lock overflow_lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(PendingCallTable);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_PENDING_CALL_TABLE_HPP__
@@ -8,14 +8,22 @@ RpcChannel::RpcChannel(RpcController *controller) : controller_(controller) {
   controller_->set_channel(this);
 }
 
-RpcChannel::~RpcChannel() {
+RpcChannel::~RpcChannel() { Detach(); }
+
+void RpcChannel::Detach() {
   if (controller_ != NULL)
-    controller_->set_channel(NULL);
-  controller_ = NULL;
+    controller_->DetachChannel();
 }
 
 void RpcChannel::Receive(const RpcMessage &message) {
   controller_->Receive(message);
 }
 
+void RpcChannel::ReceiveChannelFailure() {
+  RpcMessage message;
+  message.mutable_result()->set_status(RpcChannelFailure);
+  message.mutable_result()->set_error_message("RPC channel failure");
+  controller_->Receive(message);
+}
+
 } // namespace
@@ -23,6 +23,15 @@ protected:
   virtual void Send(const RpcMessage &message) = 0;
   void Receive(const RpcMessage &message);
 
+  // Tells the client and the server that the channel failed, so the calls
+  // that wait for the results do not wait forever.
+  void ReceiveChannelFailure();
+
+  // Stops the new sends and waits for the ones in progress. The derived
+  // channel calls it in its destructor once it is closed and before its
+  // members are gone, the base destructor runs too late for that.
+  void Detach();
+
 private:
   RpcController *controller_;
 };
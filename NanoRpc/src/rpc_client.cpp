@@ -0,0 +1,327 @@
+#include "rpc_client.hpp"
+
+#include <cassert>
+
+#include "atomic_operations.hpp"
+#include "rpc_controller.hpp"
+
+namespace NanoRpc {
+
+namespace {
+
+// The first protocol version that accepts the batches.
+const long BatchProtocolVersion = 2;
+
+// The first protocol version that accepts the pipelined calls.
+const long PipelineProtocolVersion = 3;
+
+// The first protocol version that deletes many objects in one call.
+const long MultipleDeleteProtocolVersion = 4;
+
+// The first protocol version that accepts the packed arguments.
+const long PackedParametersProtocolVersion = 5;
+
+} // namespace
+
+RpcClient::RpcClient(RpcController *controller)
+    : controller_(controller), next_id_(0), is_channel_failed_(0),
+      handshake_state_(HandshakeNotStarted),
+      handshake_callback_(this, &RpcClient::HandshakeCompleted),
+      service_ids_(NULL), peer_protocol_version_(0),
+      released_object_count_(0) {
+  controller_->set_client(this);
+}
+
+RpcClient::~RpcClient() {
+  if (controller_ != NULL) {
+    controller_->set_client(NULL);
+  }
+
+  controller_ = NULL;
+
+  delete service_ids_;
+}
+
+void RpcClient::Send(RpcMessage &rpcMessage) {
+  assert(rpcMessage.has_call());
+
+  if (released_object_count_ != 0)
+    FlushReleasedObjects();
+
+  StartHandshake();
+  ApplyHandshake(rpcMessage.mutable_call());
+
+  controller_->Send(rpcMessage);
+}
+
+void RpcClient::SendWithReply(RpcMessage &rpcMessage, RpcResult *result) {
+  assert(result != NULL);
+
+  RpcFuture *future = future_pool_.Allocate();
+  SendWithFuture(rpcMessage, future);
+  future->Wait();
+
+  result->Swap(&future->result_);
+  future_pool_.Deallocate(future);
+}
+
+void RpcClient::SendWithFuture(RpcMessage &rpcMessage, RpcFuture *future) {
+  assert(rpcMessage.has_call());
+  assert(future != NULL);
+
+  if (released_object_count_ != 0)
+    FlushReleasedObjects();
+
+  StartHandshake();
+  ApplyHandshake(rpcMessage.mutable_call());
+  rpcMessage.mutable_call()->set_expects_result(true);
+  rpcMessage.set_id(static_cast<int>(GetNextId()));
+
+  // The future may be completed and reused as soon as it is sent.
+  future->call_id_ = rpcMessage.id();
+  SendPending(rpcMessage, future);
+}
+
+void RpcClient::SendBatch(RpcBatch &batch, RpcFuture *const *futures) {
+  assert(futures != NULL || batch.calls_size() == 0);
+
+  if (batch.calls_size() == 0)
+    return;
+
+  if (released_object_count_ != 0)
+    FlushReleasedObjects();
+
+  StartHandshake();
+
+  if (peer_protocol_version_ < BatchProtocolVersion) {
+    RpcMessage rpcMessage;
+    for (int i = 0; i < batch.calls_size(); ++i) {
+      rpcMessage.mutable_call()->Swap(batch.mutable_calls(i));
+      SendWithFuture(rpcMessage, futures[i]);
+      rpcMessage.mutable_call()->Swap(batch.mutable_calls(i));
+    }
+    return;
+  }
+
+  BatchCall *call = batch_call_pool_.Allocate();
+  call->client_ = this;
+  call->futures_.assign(futures, futures + batch.calls_size());
+
+  for (int i = 0; i < batch.calls_size(); ++i)
+    ApplyHandshake(batch.mutable_calls(i));
+
+  RpcMessage rpcMessage;
+  rpcMessage.set_id(static_cast<int>(GetNextId()));
+  rpcMessage.mutable_batch()->Swap(&batch);
+  SendPending(rpcMessage, call);
+  rpcMessage.mutable_batch()->Swap(&batch);
+}
+
+void RpcClient::ReleaseObject(RpcObjectId object_id) {
+  if (object_id == 0)
+    return;
+
+  bool is_full;
+  {
+    ScopedLock lock(released_objects_lock_);
+    released_objects_.push_back(object_id);
+    is_full = released_objects_.size() >= MaxReleasedObjectCount;
+    AtomicExchange(&released_object_count_,
+                   static_cast<long>(released_objects_.size()));
+  }
+
+  if (is_full)
+    FlushReleasedObjects();
+}
+
+bool RpcClient::AcceptsPackedParameters() const {
+  return peer_protocol_version_ >= PackedParametersProtocolVersion;
+}
+
+bool RpcClient::AcceptsPipelinedCalls() const {
+  return peer_protocol_version_ >= PipelineProtocolVersion;
+}
+
+void RpcClient::FlushReleasedObjects() {
+  std::vector<RpcObjectId> object_ids;
+  {
+    ScopedLock lock(released_objects_lock_);
+    object_ids.swap(released_objects_);
+    AtomicExchange(&released_object_count_, 0);
+  }
+
+  if (object_ids.empty())
+    return;
+
+  if (peer_protocol_version_ >= MultipleDeleteProtocolVersion) {
+    SendDelete(&object_ids[0], object_ids.size());
+    return;
+  }
+
+  for (size_t i = 0; i < object_ids.size(); ++i)
+    SendDelete(&object_ids[i], 1);
+}
+
+void RpcClient::SendDelete(const RpcObjectId *object_ids, size_t count) {
+  RpcMessage rpcMessage;
+  RpcCall *rpc_call = rpcMessage.mutable_call();
+  rpc_call->set_service(RpcObjectManager::ServiceName);
+  rpc_call->set_method("Delete");
+  for (size_t i = 0; i < count; ++i)
+    rpc_call->add_parameters()->set_uint32_value(object_ids[i]);
+
+  StartHandshake();
+  ApplyHandshake(rpc_call);
+  controller_->Send(rpcMessage);
+}
+
+void RpcClient::SendPending(RpcMessage &rpcMessage, PendingCall *call) {
+  long id = rpcMessage.id();
+  pending_calls_.Insert(id, call);
+
+  // The failure may have been seen before the call was inserted, in which
+  // case nobody else is going to complete it.
+  if (is_channel_failed_ != 0) {
+    PendingCall *failed_call = pending_calls_.Remove(id);
+    if (failed_call != NULL) {
+      assert(failed_call == call);
+      FailCall(failed_call, "RPC channel failure");
+    }
+    return;
+  }
+
+  controller_->Send(rpcMessage);
+}
+
+void RpcClient::Receive(const RpcMessage &rpcMessage) {
+  assert(rpcMessage.has_result() || rpcMessage.has_batch());
+
+  // The channel failure is not related to any particular call.
+  if (!rpcMessage.has_id()) {
+    if (rpcMessage.result().status() == RpcChannelFailure) {
+      AtomicExchange(&is_channel_failed_, 1);
+      FailPendingCalls(rpcMessage.result());
+    }
+    return;
+  }
+
+  // TODO: Results that come after the call was failed are dropped silently.
+  PendingCall *call = pending_calls_.Remove(rpcMessage.id());
+  if (call == NULL)
+    return;
+
+  if (rpcMessage.has_batch())
+    call->CompleteBatch(rpcMessage.batch());
+  else
+    call->Complete(rpcMessage.result());
+}
+
+long RpcClient::GetNextId() {
+  // The id is 32 bit on the wire and zero means no id.
+  long id;
+  do {
+    id = static_cast<int>(AtomicIncrement(&next_id_));
+  } while (id == 0);
+  return id;
+}
+
+void RpcClient::StartHandshake() {
+  if (handshake_state_ != HandshakeNotStarted ||
+      AtomicCompareExchange(&handshake_state_, HandshakeStarted,
+                            HandshakeNotStarted) != HandshakeNotStarted)
+    return;
+
+  RpcHandshake handshake;
+  handshake.set_protocol_version(RpcObjectManager::ProtocolVersion);
+
+  RpcMessage rpcMessage;
+  rpcMessage.mutable_call()->set_service(RpcObjectManager::ServiceName);
+  rpcMessage.mutable_call()->set_method("Handshake");
+  handshake.SerializeToString(
+      rpcMessage.mutable_call()->add_parameters()->mutable_proto_value());
+
+  handshake_future_.set_callback(&handshake_callback_);
+  SendWithFuture(rpcMessage, &handshake_future_);
+}
+
+void RpcClient::HandshakeCompleted(RpcFuture *&future) {
+  // The servers that do not know the handshake reply with RpcUnknownMethod,
+  // the calls to them keep using the names.
+  const RpcResult &result = future->result_;
+  RpcHandshake handshake;
+  if (result.status() != RpcSucceeded ||
+      !handshake.ParseFromString(result.call_result().proto_value()) ||
+      handshake.protocol_version() < 1)
+    return;
+
+  ServiceIdMap *service_ids = new ServiceIdMap();
+  for (int i = 0; i < handshake.services_size(); ++i) {
+    const RpcServiceBinding &binding = handshake.services(i);
+    (*service_ids)[binding.name()] = binding.object_id();
+  }
+
+  AtomicExchangePointer(&service_ids_, service_ids);
+  AtomicExchange(&peer_protocol_version_,
+                 static_cast<long>(handshake.protocol_version()));
+}
+
+void RpcClient::ApplyHandshake(RpcCall *rpc_call) {
+  ServiceIdMap *service_ids = service_ids_;
+  if (service_ids == NULL)
+    return;
+
+  if (rpc_call->object_id() == 0 && rpc_call->has_service()) {
+    ServiceIdMap::const_iterator iter = service_ids->find(rpc_call->service());
+    if (iter != service_ids->end()) {
+      rpc_call->set_object_id(iter->second);
+      rpc_call->clear_service();
+    }
+  }
+
+  if (rpc_call->has_method_ordinal())
+    rpc_call->clear_method();
+}
+
+void RpcClient::BatchCall::Complete(const RpcResult &result) {
+  for (size_t i = 0; i < futures_.size(); ++i)
+    futures_[i]->Complete(result);
+
+  Release();
+}
+
+void RpcClient::BatchCall::CompleteBatch(const RpcBatch &batch) {
+  RpcResult missing_result;
+  missing_result.set_status(RpcProtocolError);
+  missing_result.set_error_message("The batch result is missing");
+
+  for (size_t i = 0; i < futures_.size(); ++i) {
+    if (static_cast<int>(i) < batch.results_size())
+      futures_[i]->Complete(batch.results(static_cast<int>(i)));
+    else
+      futures_[i]->Complete(missing_result);
+  }
+
+  Release();
+}
+
+void RpcClient::BatchCall::Release() {
+  RpcClient *client = client_;
+  client_ = NULL;
+  futures_.clear();
+  client->batch_call_pool_.Deallocate(this);
+}
+
+void RpcClient::FailCall(PendingCall *call, const char *error_message) {
+  RpcResult result;
+  result.set_status(RpcChannelFailure);
+  result.set_error_message(error_message);
+  call->Complete(result);
+}
+
+void RpcClient::FailPendingCalls(const RpcResult &result) {
+  PendingCall *call;
+  while ((call = pending_calls_.RemoveAny()) != NULL)
+    call->Complete(result);
+}
+
+} // namespace
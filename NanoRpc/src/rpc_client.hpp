@@ -1,14 +1,179 @@
 #if !defined(NANO_RPC_RPC_CLIENT_HPP__)
 #define NANO_RPC_RPC_CLIENT_HPP__
 
+#include <map>
+#include <string>
+#include <vector>
+
+#include "basictypes.hpp"
+#include "callback.hpp"
+#include "object_pool.hpp"
+#include "pending_call_table.hpp"
+#include "rpc_future.hpp"
+#include "rpc_message_sender.hpp"
+#include "rpc_object_manager.hpp"
+#include "synchronization_primitives.hpp"
+#include "RpcMessageTypes.pb.h"
+
 namespace NanoRpc {
 
+class RpcController;
+
 class IRpcClient : public IRpcMessageSender {
 public:
   // TODO: Rename to SendWithResult to be consistent with C# implementation.
   virtual void SendWithReply(RpcMessage &rpcMessage, RpcResult *result) = 0;
+
+  // Sends the call and returns right away, the result is delivered to the
+  // future. The future must stay alive until it is completed.
+  virtual void SendWithFuture(RpcMessage &rpcMessage, RpcFuture *future) = 0;
+
+  // Sends the calls together, the result of every call is delivered to its
+  // future, the n-th call's to the n-th one. The futures must stay alive
+  // until they are completed.
+  virtual void SendBatch(RpcBatch &batch, RpcFuture *const *futures) = 0;
+
+  // Deletes the marshalled object on the server, not necessarily right
+  // away. Called by the proxy that holds the object.
+  virtual void ReleaseObject(RpcObjectId object_id) = 0;
+
+  // Returns true if the server accepts the arguments packed into
+  // RpcCall.packed_parameters, see RpcPackedWriter. Asked by the proxy for
+  // every call, the answer changes once the handshake completes.
+  virtual bool AcceptsPackedParameters() const = 0;
+
+  // Returns true if the server accepts the calls pipelined on the pending
+  // calls, see RpcCall.target_call_id. Asked like AcceptsPackedParameters.
+  virtual bool AcceptsPipelinedCalls() const = 0;
+};
+
+// Implements the client side that issues calls and waits for their results.
+//
+// Every call that expects the result gets a new message id and waits in the
+// pending call table until the result with the same id is received. The
+// blocking calls wait on a pooled future; with SendWithFuture a single thread
+// may keep any number of calls in flight.
+//
+// When the channel fails, the pending calls and any calls issued after that
+// fail with RpcChannelFailure, so a new connection needs a new client.
+//
+// The first call on the connection is preceded by the handshake with the
+// server's object manager, which returns the object ids of the registered
+// services. Once it completes, the calls to those services carry the object
+// id instead of the service name, and the calls that have the method ordinal
+// do not carry the method name. The calls issued before that, as well as all
+// calls to the servers that do not know the handshake, use the names.
+//
+// The batch goes in one message and the server replies with all results in
+// one message, if the handshake says the server accepts batches. Otherwise,
+// and until the handshake completes, the calls in the batch are sent one by
+// one. Likewise the proxies pack the arguments and pipeline the calls only
+// once the handshake says the server accepts that.
+//
+// The released objects are deleted in bulk: their ids are collected and sent
+// in one Delete call before the next call goes out, or once there are
+// MaxReleasedObjectCount of them, or when FlushReleasedObjects is called.
+// The servers that accept only one id per call get one Delete call per id.
+//
+// This class is thread safe.
+class RpcClient : public IRpcClient {
+  friend class RpcController;
+
+public:
+  explicit RpcClient(RpcController *controller);
+  ~RpcClient();
+
+  // Sends the message without waiting for the result.
+  virtual void Send(RpcMessage &rpcMessage);
+
+  // Sets the message id, sends the call and waits for the result.
+  virtual void SendWithReply(RpcMessage &rpcMessage, RpcResult *result);
+
+  // Sets the message id and sends the call.
+  virtual void SendWithFuture(RpcMessage &rpcMessage, RpcFuture *future);
+
+  // Sets the message id and sends the calls. The calls are left in the
+  // batch, changed like in SendWithFuture.
+  virtual void SendBatch(RpcBatch &batch, RpcFuture *const *futures);
+
+  virtual void ReleaseObject(RpcObjectId object_id);
+
+  virtual bool AcceptsPackedParameters() const;
+  virtual bool AcceptsPipelinedCalls() const;
+
+  // Deletes the objects released so far.
+  void FlushReleasedObjects();
+
+private:
+  static const size_t MaxReleasedObjectCount = 1024;
+
+  // Calls sent in one message, which are completed all at once.
+  class BatchCall : public PendingCall {
+  public:
+    BatchCall() : client_(NULL) {}
+
+    // Completes every future with the same result.
+    virtual void Complete(const RpcResult &result);
+    virtual void CompleteBatch(const RpcBatch &batch);
+
+    RpcClient *client_;
+    std::vector<RpcFuture *> futures_;
+
+  private:
+    void Release();
+  };
+
+  // Accessible by controller.
+  void Receive(const RpcMessage &rpcMessage);
+
+  long GetNextId();
+
+  // Sends the message, the result of which is delivered to the call. The
+  // message id must be set.
+  void SendPending(RpcMessage &rpcMessage, PendingCall *call);
+
+  // Sends the handshake, unless it has been sent already.
+  void StartHandshake();
+  void HandshakeCompleted(RpcFuture *&future);
+
+  // Replaces the names in the call with the ids the server knows.
+  void ApplyHandshake(RpcCall *rpc_call);
+
+  void SendDelete(const RpcObjectId *object_ids, size_t count);
+
+  static void FailCall(PendingCall *call, const char *error_message);
+  void FailPendingCalls(const RpcResult &result);
+
+  RpcController *controller_;
+
+  volatile long next_id_;
+  volatile long is_channel_failed_;
+
+  enum HandshakeState { HandshakeNotStarted, HandshakeStarted };
+
+  typedef std::map<std::string, RpcObjectId> ServiceIdMap;
+
+  volatile long handshake_state_;
+  RpcFuture handshake_future_;
+  Callback<RpcClient, void (RpcClient::*)(RpcFuture *&), RpcFuture *>
+      handshake_callback_;
+
+  // Published once the handshake completes and not changed after that.
+  ServiceIdMap *volatile service_ids_;
+  volatile long peer_protocol_version_;
+
+  // Checked without the lock before every call.
+  volatile long released_object_count_;
+  std::vector<RpcObjectId> released_objects_;
+  Lock released_objects_lock_;
+
+  PendingCallTable pending_calls_;
+  ObjectPool<RpcFuture, RpcFutureInitializer> future_pool_;
+  ObjectPool<BatchCall> batch_call_pool_;
+
+  DISALLOW_COPY_AND_ASSIGN(RpcClient);
 };
 
 }  // namespace
 
-#endif  // NANO_RPC_RPC_CLIENT_HPP__
\ No newline at end of file
+#endif  // NANO_RPC_RPC_CLIENT_HPP__
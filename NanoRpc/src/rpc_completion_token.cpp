@@ -0,0 +1,144 @@
+#include "rpc_completion_token.hpp"
+
+#include <cassert>
+
+#include "atomic_operations.hpp"
+#include "synchronization_primitives.hpp"
+
+namespace NanoRpc {
+
+namespace {
+
+class WaitingCompletion : public IRpcAsyncService::ICompletion {
+public:
+  WaitingCompletion() : event_(true, false), is_completed_(0) {}
+
+  virtual void Complete() {
+    event_.Set();
+    AtomicExchange(&is_completed_, 1);
+  }
+
+  void Wait() {
+    event_.Wait();
+
+    // The completing thread may still be on its way out of Set.
+    while (is_completed_ == 0) {
+    }
+  }
+
+private:
+  Event event_;
+  volatile long is_completed_;
+};
+
+} // namespace
+
+struct RpcCompletionToken::State {
+  State(const RpcCall &call, RpcResult *result,
+        IRpcAsyncService::ICompletion *completion)
+      : references(1), is_completed(0), call(call), result(result),
+        completion(completion) {}
+
+  volatile long references;
+  volatile long is_completed;
+
+  const RpcCall &call;
+  RpcResult *result;
+  IRpcAsyncService::ICompletion *completion;
+};
+
+RpcCompletionToken::RpcCompletionToken() : state_(NULL) {}
+
+RpcCompletionToken::RpcCompletionToken(
+    const RpcCall &rpc_call, RpcResult *rpc_result,
+    IRpcAsyncService::ICompletion *completion)
+    : state_(new State(rpc_call, rpc_result, completion)) {
+  assert(rpc_result != NULL);
+  assert(completion != NULL);
+}
+
+RpcCompletionToken::RpcCompletionToken(const RpcCompletionToken &other)
+    : state_(other.state_) {
+  if (state_ != NULL)
+    AtomicIncrement(&state_->references);
+}
+
+RpcCompletionToken::~RpcCompletionToken() { Release(); }
+
+RpcCompletionToken &RpcCompletionToken::
+operator=(const RpcCompletionToken &other) {
+  if (other.state_ != NULL)
+    AtomicIncrement(&other.state_->references);
+  Release();
+  state_ = other.state_;
+  return *this;
+}
+
+const RpcCall &RpcCompletionToken::get_call() const {
+  assert(state_ != NULL);
+  return state_->call;
+}
+
+RpcResult *RpcCompletionToken::mutable_result() const {
+  assert(state_ != NULL);
+  return state_->result;
+}
+
+bool RpcCompletionToken::Complete() const {
+  if (!Claim())
+    return false;
+
+  state_->completion->Complete();
+  return true;
+}
+
+bool RpcCompletionToken::Fail(RpcStatus status,
+                              const std::string &error_message) const {
+  if (!Claim())
+    return false;
+
+  state_->result->Clear();
+  state_->result->set_status(status);
+  state_->result->set_error_message(error_message);
+  state_->completion->Complete();
+  return true;
+}
+
+bool RpcCompletionToken::Claim() const {
+  assert(state_ != NULL);
+  return AtomicCompareExchange(&state_->is_completed, 1, 0) == 0;
+}
+
+void RpcCompletionToken::Release() {
+  if (state_ == NULL)
+    return;
+
+  if (AtomicDecrement(&state_->references) == 0) {
+    if (state_->is_completed == 0)
+      Fail(RpcProtocolError, "The call was abandoned by the handler");
+    delete state_;
+  }
+
+  state_ = NULL;
+}
+
+void RpcDeferredService::CallMethodAsync(const RpcCall &rpc_call,
+                                         RpcResult *rpc_result,
+                                         ICompletion *completion) {
+  RpcCompletionToken token(rpc_call, rpc_result, completion);
+  CallMethodDeferred(token);
+}
+
+void RpcDeferredService::CallMethod(const RpcCall &rpc_call,
+                                    RpcResult *rpc_result) {
+  CallMethodAndWait(this, rpc_call, rpc_result);
+}
+
+void CallMethodAndWait(IRpcAsyncService *service, const RpcCall &rpc_call,
+                       RpcResult *rpc_result) {
+  WaitingCompletion completion;
+  service->CallMethodAsync(rpc_call, rpc_result, &completion);
+  completion.Wait();
+}
+
+} // namespace
@@ -0,0 +1,84 @@
+#if !defined(NANO_RPC_RPC_COMPLETION_TOKEN_HPP__)
+#define NANO_RPC_RPC_COMPLETION_TOKEN_HPP__
+
+#include <string>
+
+#include "rpc_service.hpp"
+#include "RpcMessageTypes.pb.h"
+
+namespace NanoRpc {
+
+// Handle of the call whose result is sent after the handler returns, see
+// RpcDeferredService.
+//
+// Tokens are cheap to copy and may be passed to any thread. The first
+// Complete or Fail on any copy completes the call, the rest are ignored. If
+// the last copy goes away before that, the call fails, so the client is not
+// left waiting for the result that never comes.
+//
+// The result should be filled in by the thread that completes the call.
+class RpcCompletionToken {
+public:
+  RpcCompletionToken();
+  RpcCompletionToken(const RpcCall &rpc_call, RpcResult *rpc_result,
+                     IRpcAsyncService::ICompletion *completion);
+  RpcCompletionToken(const RpcCompletionToken &other);
+  ~RpcCompletionToken();
+
+  RpcCompletionToken &operator=(const RpcCompletionToken &other);
+
+  bool IsValid() const { return state_ != NULL; }
+
+  // The call and the result are valid until the call is completed.
+  const RpcCall &get_call() const;
+  RpcResult *mutable_result() const;
+
+  // Sends the result back. Returns false if the call is already completed.
+  bool Complete() const;
+
+  // Replaces the result with the error and sends it back. Returns false if
+  // the call is already completed.
+  bool Fail(RpcStatus status, const std::string &error_message) const;
+
+private:
+  struct State;
+
+  // Returns true if the caller won the right to complete the call.
+  bool Claim() const;
+
+  void Release();
+
+  State *state_;
+};
+
+// Base of the services that complete their calls later, from any thread,
+// so the handlers waiting on the disk or other servers do not hold a worker
+// per call:
+//
+//   virtual void CallMethodDeferred(const RpcCompletionToken &token) {
+//     pending_reads_.push_back(token);
+//     StartRead(token.get_call().parameters(0).string_value());
+//   }
+//
+//   void ReadCompleted(const RpcCompletionToken &token, ...) {
+//     token.mutable_result()->mutable_call_result()->set_proto_value(...);
+//     token.Complete();
+//   }
+class RpcDeferredService : public IRpcAsyncService {
+public:
+  virtual void CallMethodDeferred(const RpcCompletionToken &token) = 0;
+
+  virtual void CallMethodAsync(const RpcCall &rpc_call, RpcResult *rpc_result,
+                               ICompletion *completion);
+
+  // Waits for the call to complete, for the callers that cannot wait.
+  virtual void CallMethod(const RpcCall &rpc_call, RpcResult *rpc_result);
+};
+
+// Calls the asynchronous service and waits until the call completes.
+void CallMethodAndWait(IRpcAsyncService *service, const RpcCall &rpc_call,
+                       RpcResult *rpc_result);
+
+}  // namespace
+
+#endif  // NANO_RPC_RPC_COMPLETION_TOKEN_HPP__
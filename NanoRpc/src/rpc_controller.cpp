@@ -1,23 +1,58 @@
 
 #include "rpc_controller.hpp"
+#include "atomic_operations.hpp"
 #include "rpc_channel.hpp"
 #include "rpc_server.hpp"
 #include "rpc_client.hpp"
 
 namespace NanoRpc {
 
-void RpcController::Send(const RpcMessage &message) { channel_->Send(message); }
+namespace {
+
+// How often (in milliseconds) the detaching channel checks the sends.
+const unsigned int SendDrainInterval = 10;
+
+} // namespace
+
+void RpcController::Send(const RpcMessage &message) {
+  // The server may complete a call after the channel is gone. The send is
+  // counted before the channel is read, so the channel that is being
+  // detached either is not seen here or waits for this send.
+  AtomicIncrement(&send_count_);
+  RpcChannel *channel = channel_;
+  if (channel != NULL)
+    channel->Send(message);
+  if (AtomicDecrement(&send_count_) == 0)
+    sends_drained_event_.Set();
+}
+
+void RpcController::DetachChannel() {
+  AtomicExchangePointer(&channel_, static_cast<RpcChannel *>(NULL));
+  while (send_count_ != 0)
+    sends_drained_event_.Wait(SendDrainInterval);
+}
 
 void RpcController::Receive(const RpcMessage &message) {
-  // TODO: Implement client handling
-  if (message.has_result() && message.result().status() != RpcSucceeded) {
+  // The batch carries either the calls or their results.
+  if (message.has_call() || message.batch().calls_size() != 0) {
     if (server_ != NULL)
       server_->Receive(message);
-  } else {
-    if (message.has_call()) {
-      if (server_ != NULL)
-        server_->Receive(message);
-    }
+    return;
+  }
+
+  if (message.has_batch()) {
+    if (client_ != NULL)
+      client_->Receive(message);
+    return;
+  }
+
+  if (message.has_result()) {
+    if (client_ != NULL)
+      client_->Receive(message);
+
+    // The server handles the failures too, see RpcServer::Receive.
+    if (message.result().status() != RpcSucceeded && server_ != NULL)
+      server_->Receive(message);
   }
 }
 
@@ -2,6 +2,7 @@
 #if !defined(NANO_RPC_RPC_CONTROLLER_HPP__)
 #define NANO_RPC_RPC_CONTROLLER_HPP__
 
+#include "synchronization_primitives.hpp"
 #include "RpcMessageTypes.pb.h"
 
 namespace NanoRpc {
@@ -17,6 +18,10 @@ class RpcController {
   friend class RpcClient;
 
 public:
+  RpcController()
+      : channel_(NULL), server_(NULL), client_(NULL), send_count_(0),
+        sends_drained_event_(false, false) {}
+
   RpcServer *get_server() { return server_; }
   RpcClient *get_client() { return client_; }
   RpcChannel *get_channel() { return channel_; }
@@ -32,10 +37,20 @@ protected:
   void set_client(RpcClient *client) { client_ = client; }
   void set_channel(RpcChannel *channel) { channel_ = channel; }
 
+  // Stops sending on the channel and waits for the sends in progress, the
+  // workers completing calls may still be in the channel's Send.
+  void DetachChannel();
+
 private:
-  RpcChannel *channel_;
+  RpcChannel *volatile channel_;
   RpcServer *server_;
   RpcClient *client_;
+
+  // Number of the sends in progress.
+  volatile long send_count_;
+  Event sends_drained_event_;
+
+  DISALLOW_COPY_AND_ASSIGN(RpcController);
 };
 
 }  // namespace
@@ -0,0 +1,152 @@
+#if !defined(NANO_RPC_RPC_COROUTINE_HPP__)
+#define NANO_RPC_RPC_COROUTINE_HPP__
+
+// C++20 coroutine support. The rest of the library does not depend on it,
+// so the header is empty for the compilers that do not have coroutines.
+#if defined(__cpp_impl_coroutine)
+
+#include <coroutine>
+#include <exception>
+
+#include "basictypes.hpp"
+#include "callback.hpp"
+#include "rpc_completion_token.hpp"
+#include "rpc_future.hpp"
+#include "rpc_service.hpp"
+#include "worker_pool.hpp"
+#include "RpcMessageTypes.pb.h"
+
+namespace NanoRpc {
+
+// Suspends the coroutine until the future is completed, so the generated
+// proxies can be awaited:
+//
+//   RpcFuture future;
+//   proxy->AddAsync(1, 2, &future);
+//   co_await future;
+//   int sum = proxy->EndAdd(&future);
+//
+// The coroutine is resumed on the thread that completed the future (usually
+// the channel's I/O thread), or on the worker pool if one is specified.
+class RpcFutureAwaiter : public CallbackBase<RpcFuture *>,
+                         public WorkerPool::Task {
+public:
+  explicit RpcFutureAwaiter(RpcFuture *future, WorkerPool *worker_pool = NULL)
+      : future_(future), worker_pool_(worker_pool) {}
+
+  bool await_ready() const { return future_->IsReady(); }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+    return future_->SetContinuation(this);
+  }
+
+  const RpcResult &await_resume() { return future_->get_result(); }
+
+  virtual void Invoke(RpcFuture *& /* future */) {
+    if (worker_pool_ != NULL)
+      worker_pool_->Submit(this);
+    else
+      handle_.resume();
+  }
+
+  virtual void Run() { handle_.resume(); }
+
+private:
+  RpcFuture *future_;
+  WorkerPool *worker_pool_;
+  std::coroutine_handle<> handle_;
+};
+
+inline RpcFutureAwaiter operator co_await(RpcFuture &future) {
+  return RpcFutureAwaiter(&future);
+}
+
+// Awaits the future and resumes the coroutine on the worker pool, so the
+// code after the co_await does not hold up the channel's I/O thread.
+inline RpcFutureAwaiter ResumeOn(RpcFuture &future, WorkerPool *worker_pool) {
+  return RpcFutureAwaiter(&future, worker_pool);
+}
+
+// Return type of the coroutine handlers, see RpcCoroutineService. The
+// coroutine runs right away and completes the call when it finishes.
+class RpcCoroutine {
+public:
+  struct promise_type {
+    promise_type() : rpc_result(NULL), completion(NULL) {}
+
+    RpcCoroutine get_return_object() {
+      return RpcCoroutine(
+          std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    // The handler starts once the completion is attached.
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    std::suspend_never final_suspend() noexcept {
+      completion->Complete();
+      return {};
+    }
+
+    void return_void() {}
+
+    void unhandled_exception() {
+      rpc_result->Clear();
+      rpc_result->set_status(RpcInvalidCallParameter);
+      rpc_result->set_error_message("Unhandled exception in the handler");
+    }
+
+    RpcResult *rpc_result;
+    IRpcAsyncService::ICompletion *completion;
+  };
+
+  // Attaches the completion and runs the coroutine up to the first
+  // suspension. The coroutine frame destroys itself when it finishes.
+  void Start(RpcResult *rpc_result,
+             IRpcAsyncService::ICompletion *completion) {
+    handle_.promise().rpc_result = rpc_result;
+    handle_.promise().completion = completion;
+    handle_.resume();
+  }
+
+private:
+  explicit RpcCoroutine(std::coroutine_handle<promise_type> handle)
+      : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+// Base of the services whose handlers are coroutines, so the handler may
+// wait for the calls to other servers without holding the worker:
+//
+//   RpcCoroutine CallMethodCoroutine(const RpcCall &rpc_call,
+//                                    RpcResult *rpc_result) {
+//     RpcFuture future;
+//     backend_proxy_->LookupAsync(rpc_call.parameters(0).string_value(),
+//                                 &future);
+//     co_await ResumeOn(future, worker_pool_);
+//     ...
+//   }
+//
+// The call and the result stay valid until the coroutine finishes.
+class RpcCoroutineService : public IRpcAsyncService {
+public:
+  virtual RpcCoroutine CallMethodCoroutine(const RpcCall &rpc_call,
+                                           RpcResult *rpc_result) = 0;
+
+  virtual void CallMethodAsync(const RpcCall &rpc_call, RpcResult *rpc_result,
+                               ICompletion *completion) {
+    CallMethodCoroutine(rpc_call, rpc_result).Start(rpc_result, completion);
+  }
+
+  // Runs the handler to the end, for the callers that cannot wait.
+  virtual void CallMethod(const RpcCall &rpc_call, RpcResult *rpc_result) {
+    CallMethodAndWait(this, rpc_call, rpc_result);
+  }
+};
+
+}  // namespace
+
+#endif  // __cpp_impl_coroutine
+
+#endif  // NANO_RPC_RPC_COROUTINE_HPP__
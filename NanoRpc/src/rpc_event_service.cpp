@@ -40,14 +40,17 @@ void RpcEventService::CallMethod(const RpcCall &rpc_call,
 }
 
 void RpcEventService::Add(const std::string &event_interface_name) {
+  ScopedLock lock(lock_);
   event_interfaces_.insert(event_interface_name);
 }
 
 void RpcEventService::Remove(const std::string &event_interface_name) {
+  ScopedLock lock(lock_);
   event_interfaces_.erase(event_interface_name);
 }
 
 bool RpcEventService::HasInterface(const std::string &event_interface_name) {
+  ScopedLock lock(lock_);
   return event_interfaces_.find(event_interface_name) !=
          event_interfaces_.end();
 }
@@ -7,6 +7,7 @@
 #include "RpcMessageTypes.pb.h"
 
 #include "rpc_service.hpp"
+#include "synchronization_primitives.hpp"
 
 namespace NanoRpc {
 
@@ -26,6 +27,7 @@ public:
 
 private:
   std::set<std::string> event_interfaces_;
+  Lock lock_;
 };
 
 }  // namespace
@@ -0,0 +1,66 @@
+#include "rpc_future.hpp"
+
+#include <cassert>
+
+#include "atomic_operations.hpp"
+
+namespace NanoRpc {
+
+RpcFuture::RpcFuture()
+    : call_id_(0), callback_(NULL), continuation_(NULL),
+      completed_event_(true, false), state_(Pending) {}
+
+RpcFuture::RpcFuture(CallbackBase<RpcFuture *> *callback)
+    : call_id_(0), callback_(callback), continuation_(NULL),
+      completed_event_(true, false), state_(Pending) {}
+
+void RpcFuture::Wait() {
+  for (int i = 0; i < SpinCount; ++i) {
+    if (state_ == Completed)
+      return;
+  }
+
+  completed_event_.Wait();
+
+  // The completing thread may still be on its way out of Set.
+  while (state_ != Completed) {
+  }
+}
+
+bool RpcFuture::SetContinuation(CallbackBase<RpcFuture *> *continuation) {
+  assert(continuation != NULL);
+  assert(continuation_ == NULL);
+
+  // The completing thread reads it only after it sees the state changed.
+  continuation_ = continuation;
+  return AtomicCompareExchange(&state_, Continued, Pending) == Pending;
+}
+
+void RpcFuture::Reset() {
+  result_.Clear();
+  call_id_ = 0;
+  completed_event_.Reset();
+  continuation_ = NULL;
+  state_ = Pending;
+}
+
+void RpcFuture::Complete(const RpcResult &result) {
+  result_.CopyFrom(result);
+  completed_event_.Set();
+
+  // The waiting thread may reuse the future right after this, so the
+  // callback is read first. The thread that set the continuation, on the
+  // other hand, does not touch the future until it is continued.
+  CallbackBase<RpcFuture *> *callback = callback_;
+  long previous = AtomicExchange(&state_, Completed);
+  CallbackBase<RpcFuture *> *continuation =
+      previous == Continued ? continuation_ : NULL;
+
+  RpcFuture *future = this;
+  if (callback != NULL)
+    callback->Invoke(future);
+  if (continuation != NULL)
+    continuation->Invoke(future);
+}
+
+} // namespace
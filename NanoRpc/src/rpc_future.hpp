@@ -0,0 +1,89 @@
+#if !defined(NANO_RPC_RPC_FUTURE_HPP__)
+#define NANO_RPC_RPC_FUTURE_HPP__
+
+#include "basictypes.hpp"
+#include "callback.hpp"
+#include "pending_call_table.hpp"
+#include "synchronization_primitives.hpp"
+#include "RpcMessageTypes.pb.h"
+
+namespace NanoRpc {
+
+class RpcClient;
+
+// Result of the call that is sent without waiting for it, see
+// IRpcClient::SendWithFuture and the generated FooAsync proxy methods.
+//
+// The result is either waited for or picked up by the callback, which runs
+// on the thread that received the result (usually the channel's I/O thread),
+// so it should not block. The callback may delete the future, in which case
+// nobody else may be waiting for it.
+//
+// A coroutine may suspend until the future is completed, see
+// rpc_coroutine.hpp.
+//
+// A completed future may be reset and reused for another call.
+class RpcFuture : public PendingCall {
+  friend class RpcClient;
+
+public:
+  RpcFuture();
+  explicit RpcFuture(CallbackBase<RpcFuture *> *callback);
+
+  // Must not be changed while the call is in flight.
+  void set_callback(CallbackBase<RpcFuture *> *callback) {
+    callback_ = callback;
+  }
+
+  bool IsReady() const { return state_ == Completed; }
+
+  // The message id of the call, which the calls pipelined on the object it
+  // returns target (see RpcCall.target_call_id). Set when the call is sent.
+  int get_call_id() const { return call_id_; }
+
+  void Wait();
+
+  // Makes the thread that completes the future invoke the continuation,
+  // after the callback if there is one. Returns false if the future is
+  // already completed, in which case the continuation is not invoked.
+  // Only one continuation may be set per call.
+  bool SetContinuation(CallbackBase<RpcFuture *> *continuation);
+
+  // Waits for the result.
+  const RpcResult &get_result() {
+    Wait();
+    return result_;
+  }
+
+  void Reset();
+
+  virtual void Complete(const RpcResult &result);
+
+private:
+  enum State { Pending = 0, Completed = 1, Continued = 2 };
+
+  // How many times the waiting thread checks for the result before it
+  // sleeps. On the local transports the result often arrives sooner than
+  // the thread could be put to sleep and woken up again.
+  static const int SpinCount = 4000;
+
+  RpcResult result_;
+  int call_id_;
+  CallbackBase<RpcFuture *> *callback_;
+  CallbackBase<RpcFuture *> *continuation_;
+
+  Event completed_event_;
+  volatile long state_;
+
+  DISALLOW_COPY_AND_ASSIGN(RpcFuture);
+};
+
+// Resets the future when it is reused from the object pool.
+class RpcFutureInitializer {
+public:
+  void operator()(RpcFuture *future) { future->Reset(); }
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_RPC_FUTURE_HPP__
@@ -0,0 +1,67 @@
+#include "rpc_lease_wheel.hpp"
+
+#include <cassert>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "atomic_operations.hpp"
+
+namespace NanoRpc {
+
+RpcLeaseWheel::RpcLeaseWheel()
+    : tick_length_(0), current_tick_(0), current_tick_time_(0) {}
+
+void RpcLeaseWheel::set_lease_time(unsigned int milliseconds) {
+  tick_length_ = 0;
+  if (milliseconds != 0) {
+    tick_length_ = milliseconds / TicksPerLease;
+    if (tick_length_ == 0)
+      tick_length_ = 1;
+  }
+
+  current_tick_time_ = GetTickCount();
+}
+
+void RpcLeaseWheel::Schedule(RpcObjectId object_id, long tick) {
+  assert(IsEnabled());
+  assert(tick > current_tick_ && tick - current_tick_ <= TicksPerLease);
+
+  buckets_[tick & (BucketCount - 1)].push_back(object_id);
+}
+
+void RpcLeaseWheel::Advance(unsigned int now,
+                            std::vector<RpcObjectId> *object_ids) {
+  if (!IsDue(now))
+    return;
+
+  long ticks = static_cast<long>((now - current_tick_time_) / tick_length_);
+  current_tick_time_ =
+      current_tick_time_ + static_cast<unsigned int>(ticks) * tick_length_;
+
+  // After a full turn every bucket is due.
+  long due_count = ticks < BucketCount ? ticks : BucketCount;
+  for (long tick = current_tick_ + 1; tick <= current_tick_ + due_count;
+       ++tick) {
+    std::vector<RpcObjectId> &bucket = buckets_[tick & (BucketCount - 1)];
+    object_ids->insert(object_ids->end(), bucket.begin(), bucket.end());
+    bucket.clear();
+  }
+
+  AtomicExchange(&current_tick_, current_tick_ + ticks);
+}
+
+unsigned int RpcLeaseWheel::GetTickCount() {
+#if defined(_WIN32)
+  return ::GetTickCount();
+#else
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<unsigned int>(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+#endif
+}
+
+} // namespace
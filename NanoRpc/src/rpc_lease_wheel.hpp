@@ -0,0 +1,67 @@
+#if !defined(NANO_RPC_RPC_LEASE_WHEEL_HPP__)
+#define NANO_RPC_RPC_LEASE_WHEEL_HPP__
+
+#include <vector>
+
+#include "basictypes.hpp"
+#include "rpc_object_table.hpp"
+
+namespace NanoRpc {
+
+// Timer wheel of the leases on the marshalled objects, see
+// RpcObjectManager::set_lease_time.
+//
+// The time is counted in ticks, TicksPerLease of them to the lease. The
+// wheel has a bucket per tick, and more buckets than there are ticks in the
+// lease, so the lease scheduled from the current tick lands within one turn
+// of the wheel and the ids in the bucket are all due when the wheel gets to
+// it. Using the object does not move it on the wheel: the owner checks when
+// the due objects were last used and schedules them again if their leases
+// have been renewed since.
+//
+// The current tick may be read by any thread, the rest must be serialized
+// by the caller.
+class RpcLeaseWheel {
+public:
+  static const long TicksPerLease = 16;
+
+  RpcLeaseWheel();
+
+  // Zero disables the leases.
+  void set_lease_time(unsigned int milliseconds);
+
+  bool IsEnabled() const { return tick_length_ != 0; }
+
+  // Returns true if Advance would move the wheel.
+  bool IsDue(unsigned int now) const {
+    return tick_length_ != 0 && now - current_tick_time_ >= tick_length_;
+  }
+
+  long get_current_tick() const { return current_tick_; }
+
+  // The tick must be after the current one, at most TicksPerLease ahead.
+  void Schedule(RpcObjectId object_id, long tick);
+
+  // Moves the wheel to the time and appends the ids that are due.
+  void Advance(unsigned int now, std::vector<RpcObjectId> *object_ids);
+
+  // Milliseconds, wraps around.
+  static unsigned int GetTickCount();
+
+private:
+  static const long BucketCount = 32;
+
+  std::vector<RpcObjectId> buckets_[BucketCount];
+
+  unsigned int tick_length_;
+  volatile long current_tick_;
+
+  // When the current tick started.
+  volatile unsigned int current_tick_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(RpcLeaseWheel);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_RPC_LEASE_WHEEL_HPP__
@@ -1,23 +1,52 @@
 #include "rpc_object_manager.hpp"
 
+#include <algorithm>
+#include <cstring>
+
+#include "atomic_operations.hpp"
+
 namespace NanoRpc {
 
 const char *const RpcObjectManager::ServiceName =
     "NanoRpc.ObjectManagerService";
 
-RpcObjectManager::RpcObjectManager() : last_object_id_(0) {}
+namespace {
+
+// Advancing the epoch twice frees the objects retired in the current one,
+// unless there are readers.
+const int MaxEpochAdvanceCount = 2;
+
+} // namespace
+
+RpcObjectManager::RpcObjectManager()
+    : epoch_(0), retired_object_count_(0), peer_protocol_version_(0) {
+  reader_counts_[0] = 0;
+  reader_counts_[1] = 0;
+}
 
 RpcObjectManager::~RpcObjectManager() {
-  for (std::map<RpcObjectId, IRpcService *>::const_iterator iter =
-           objects_.begin();
-       iter != objects_.end(); iter++) {
-    delete iter->second;
+  std::vector<IRpcService *> objects;
+  objects_.RemoveAll(&objects);
+  for (int i = 0; i < 2; ++i) {
+    assert(reader_counts_[i] == 0);
+    objects.insert(objects.end(), retired_objects_[i].begin(),
+                   retired_objects_[i].end());
+  }
+
+  for (std::vector<IRpcService *>::const_iterator iter = objects.begin();
+       iter != objects.end(); iter++) {
+    delete *iter;
   }
 }
 
 void RpcObjectManager::RegisterService(const char *name, IRpcService *service) {
   assert(service != NULL);
-  services_[name] = RegisterInstance(service);
+
+  // The services have no lease.
+  ScopedLock lock(lock_);
+  RpcObjectId object_id = objects_.Insert(service);
+  assert(object_id != 0);
+  services_.Insert(name, object_id);
 }
 
 void RpcObjectManager::RegisterService(IRpcStub *stub) {
@@ -25,12 +54,79 @@ void RpcObjectManager::RegisterService(IRpcStub *stub) {
   RegisterService(stub->GetInterfaceName(), stub);
 }
 
-// Currently implementation assumes that only unique instances are registered.
-// So, it is wrong if method returns the same object accross multiple calls.
 RpcObjectId RpcObjectManager::RegisterInstance(IRpcService *instance) {
   assert(instance != NULL);
-  objects_[++last_object_id_] = instance;
-  return last_object_id_;
+
+  ScopedLock lock(lock_);
+  RpcObjectId object_id = InsertInstance(instance);
+  assert(object_id != 0);
+  return object_id;
+}
+
+RpcObjectId RpcObjectManager::RegisterInstance(IRpcService *instance,
+                                              const void *implementation,
+                                              const char *interface_name) {
+  assert(instance != NULL);
+  assert(interface_name != NULL);
+
+  // Nothing to share for the null implementation.
+  if (implementation == NULL)
+    return RegisterInstance(instance);
+
+  ImplementationKey key(implementation, interface_name);
+  RpcObjectId object_id;
+  {
+    ScopedLock lock(lock_);
+    object_id = AddReference(key);
+    if (object_id == 0) {
+      object_id = InsertInstance(instance);
+      assert(object_id != 0);
+      if (object_id != 0) {
+        implementations_[key] = object_id;
+        Instance &counted = instances_[object_id];
+        counted.key = key;
+        counted.references = 1;
+      }
+      return object_id;
+    }
+  }
+
+  // The other call returned the same implementation first. Nobody has seen
+  // this instance yet.
+  delete instance;
+  return object_id;
+}
+
+RpcObjectId RpcObjectManager::AddInstanceReference(const void *implementation,
+                                                  const char *interface_name) {
+  assert(interface_name != NULL);
+
+  if (implementation == NULL)
+    return 0;
+
+  ScopedLock lock(lock_);
+  return AddReference(ImplementationKey(implementation, interface_name));
+}
+
+RpcObjectId RpcObjectManager::AddReference(const ImplementationKey &key) {
+  ImplementationMap::const_iterator iter = implementations_.find(key);
+  if (iter == implementations_.end())
+    return 0;
+
+  ++instances_[iter->second].references;
+  if (leases_.IsEnabled())
+    objects_.MarkUsed(iter->second, leases_.get_current_tick());
+  return iter->second;
+}
+
+RpcObjectId RpcObjectManager::InsertInstance(IRpcService *instance) {
+  RpcObjectId object_id = objects_.Insert(instance);
+  if (object_id != 0 && leases_.IsEnabled()) {
+    long tick = leases_.get_current_tick();
+    objects_.MarkUsed(object_id, tick);
+    leases_.Schedule(object_id, tick + RpcLeaseWheel::TicksPerLease);
+  }
+  return object_id;
 }
 
 IRpcService *RpcObjectManager::GetService(const char *name) {
@@ -39,41 +135,198 @@ IRpcService *RpcObjectManager::GetService(const char *name) {
   if (name == NULL)
     return NULL;
 
-  return GetService(std::string(name));
+  return GetInstance(services_.Find(name, strlen(name)));
 }
 
 IRpcService *RpcObjectManager::GetService(const std::string &name) {
-  std::map<std::string, RpcObjectId>::const_iterator iter =
-      services_.find(name);
-  if (iter == services_.end())
-    return NULL;
+  return GetInstance(GetServiceId(name));
+}
 
-  return GetInstance(iter->second);
+RpcObjectId RpcObjectManager::GetServiceId(const std::string &name) {
+  return services_.Find(name.data(), name.size());
 }
 
 IRpcService *RpcObjectManager::GetInstance(RpcObjectId object_id) {
-  if (object_id == 0)
-    return NULL;
+  if (leases_.IsEnabled())
+    objects_.MarkUsed(object_id, leases_.get_current_tick());
+  return objects_.Get(object_id);
+}
 
-  std::map<RpcObjectId, IRpcService *>::const_iterator iter =
-      objects_.find(object_id);
-  if (iter == objects_.end())
-    return NULL;
+void RpcObjectManager::DeleteObject(RpcObjectId object_id) {
+  DeleteObjects(&object_id, 1);
+}
 
-  return iter->second;
+void RpcObjectManager::DeleteObjects(const RpcObjectId *object_ids,
+                                     size_t count) {
+  bool is_retired = false;
+  {
+    ScopedLock lock(lock_);
+    for (size_t i = 0; i < count; ++i) {
+      if (ReleaseReference(object_ids[i]) && RetireObject(object_ids[i]))
+        is_retired = true;
+    }
+  }
+
+  if (is_retired)
+    DeleteRetiredObjects();
 }
 
-void RpcObjectManager::DeleteObject(RpcObjectId object_id) {
-  if (object_id == 0)
+void RpcObjectManager::DeleteInstances() {
+  bool is_retired = false;
+  {
+    ScopedLock lock(lock_);
+    std::vector<RpcServiceRegistry::Service> services;
+    services_.GetServices(&services);
+    std::vector<RpcObjectId> service_ids;
+    service_ids.reserve(services.size());
+    for (std::vector<RpcServiceRegistry::Service>::const_iterator iter =
+             services.begin();
+         iter != services.end(); iter++) {
+      service_ids.push_back(iter->second);
+    }
+    std::sort(service_ids.begin(), service_ids.end());
+
+    std::vector<RpcObjectId> object_ids;
+    objects_.GetObjectIds(&object_ids);
+    for (std::vector<RpcObjectId>::const_iterator iter = object_ids.begin();
+         iter != object_ids.end(); iter++) {
+      if (std::binary_search(service_ids.begin(), service_ids.end(), *iter))
+        continue;
+
+      ForgetInstance(*iter);
+      if (RetireObject(*iter))
+        is_retired = true;
+    }
+  }
+
+  if (is_retired)
+    DeleteRetiredObjects();
+}
+
+void RpcObjectManager::set_lease_time(unsigned int milliseconds) {
+  ScopedLock lock(lock_);
+  leases_.set_lease_time(milliseconds);
+}
+
+void RpcObjectManager::ExpireLeases() {
+  unsigned int now = RpcLeaseWheel::GetTickCount();
+  if (!leases_.IsDue(now))
     return;
 
-  std::map<RpcObjectId, IRpcService *>::const_iterator iter =
-      objects_.find(object_id);
-  if (iter == objects_.end())
+  bool is_retired = false;
+  {
+    ScopedLock lock(lock_);
+    std::vector<RpcObjectId> object_ids;
+    leases_.Advance(now, &object_ids);
+
+    long current_tick = leases_.get_current_tick();
+    for (std::vector<RpcObjectId>::const_iterator iter = object_ids.begin();
+         iter != object_ids.end(); iter++) {
+      // Deleted since it was scheduled.
+      long last_used;
+      if (!objects_.GetLastUsed(*iter, &last_used))
+        continue;
+
+      long expiry_tick = last_used + RpcLeaseWheel::TicksPerLease;
+      if (expiry_tick > current_tick) {
+        leases_.Schedule(*iter, expiry_tick);
+        continue;
+      }
+
+      ForgetInstance(*iter);
+      if (RetireObject(*iter))
+        is_retired = true;
+    }
+  }
+
+  if (is_retired)
+    DeleteRetiredObjects();
+}
+
+bool RpcObjectManager::RetireObject(RpcObjectId object_id) {
+  IRpcService *object = objects_.Remove(object_id);
+  if (object == NULL)
+    return false;
+
+  retired_objects_[epoch_ & 1].push_back(object);
+  AtomicIncrement(&retired_object_count_);
+  return true;
+}
+
+void RpcObjectManager::DeleteRetiredObjects() {
+  std::vector<IRpcService *> objects;
+  {
+    ScopedLock lock(lock_);
+    for (int i = 0; i < MaxEpochAdvanceCount && AdvanceEpoch(&objects); ++i) {
+    }
+
+    AtomicExchange(&retired_object_count_,
+                   static_cast<long>(retired_objects_[0].size() +
+                                     retired_objects_[1].size()));
+  }
+
+  for (std::vector<IRpcService *>::const_iterator iter = objects.begin();
+       iter != objects.end(); iter++) {
+    delete *iter;
+  }
+}
+
+bool RpcObjectManager::ReleaseReference(RpcObjectId object_id) {
+  InstanceMap::iterator iter = instances_.find(object_id);
+  if (iter == instances_.end())
+    return true;
+
+  Instance &counted = iter->second;
+  if (--counted.references != 0)
+    return false;
+
+  implementations_.erase(counted.key);
+  instances_.erase(iter);
+  return true;
+}
+
+void RpcObjectManager::ForgetInstance(RpcObjectId object_id) {
+  InstanceMap::iterator iter = instances_.find(object_id);
+  if (iter == instances_.end())
     return;
 
-  delete iter->second;
-  objects_.erase(iter);
+  implementations_.erase(iter->second.key);
+  instances_.erase(iter);
+}
+
+long RpcObjectManager::EnterReader() {
+  // The epoch may advance before the reader is counted. That is fine: the
+  // reader can only find the objects retired after it is counted, and one
+  // of the two advances needed to free them checks the reader's parity.
+  long epoch = epoch_;
+  AtomicIncrement(&reader_counts_[epoch & 1]);
+  return epoch;
+}
+
+void RpcObjectManager::ExitReader(long epoch) {
+  // The call that deleted the objects is a reader itself, so the epoch
+  // cannot advance past the objects it retired until it exits. The last
+  // reader to exit frees them, rather than leaving them for the next
+  // deletion.
+  if (AtomicDecrement(&reader_counts_[epoch & 1]) == 0 &&
+      retired_object_count_ != 0)
+    DeleteRetiredObjects();
+}
+
+bool RpcObjectManager::AdvanceEpoch(std::vector<IRpcService *> *objects) {
+  // The readers of the previous epoch share the parity with the next one.
+  long next_epoch = epoch_ + 1;
+  if (reader_counts_[next_epoch & 1] != 0)
+    return false;
+
+  // These were retired in the previous epoch, before the current readers
+  // entered.
+  std::vector<IRpcService *> &retired = retired_objects_[next_epoch & 1];
+  objects->insert(objects->end(), retired.begin(), retired.end());
+  retired.clear();
+
+  AtomicExchange(&epoch_, next_epoch);
+  return true;
 }
 
 void RpcObjectManager::CallMethod(const RpcCall &rpc_call,
@@ -81,21 +334,65 @@ void RpcObjectManager::CallMethod(const RpcCall &rpc_call,
   rpc_result->set_status(RpcSucceeded);
 
   if (rpc_call.method() == "Delete") {
-    assert(rpc_call.parameters_size() == 1);
-    assert(rpc_call.parameters().Get(0).has_uint32_value());
+    // Every parameter is the id of the object to delete, see RpcClient.
+    std::vector<RpcObjectId> object_ids;
+    object_ids.reserve(rpc_call.parameters_size());
+    for (int i = 0; i < rpc_call.parameters_size(); ++i) {
+      if (!rpc_call.parameters().Get(i).has_uint32_value())
+        break;
+      object_ids.push_back(rpc_call.parameters().Get(i).uint32_value());
+    }
 
-    if (rpc_call.parameters_size() != 1 ||
-        !rpc_call.parameters().Get(0).has_uint32_value()) {
+    if (object_ids.empty() ||
+        object_ids.size() != static_cast<size_t>(rpc_call.parameters_size())) {
       rpc_result->set_status(RpcInvalidCallParameter);
       rpc_result->set_error_message("Invalid call parameter.");
     } else {
-      RpcObjectId object_id = rpc_call.parameters().Get(0).uint32_value();
-      DeleteObject(object_id);
+      DeleteObjects(&object_ids[0], object_ids.size());
     }
+  } else if (rpc_call.method() == "Handshake") {
+    Handshake(rpc_call, rpc_result);
   } else {
     rpc_result->set_status(RpcUnknownMethod);
     rpc_result->set_error_message("Unknown method.");
   }
 }
 
+void RpcObjectManager::Handshake(const RpcCall &rpc_call,
+                                 RpcResult *rpc_result) {
+  RpcHandshake peer_handshake;
+  if (rpc_call.parameters_size() != 1 ||
+      !peer_handshake.ParseFromString(
+          rpc_call.parameters().Get(0).proto_value())) {
+    rpc_result->set_status(RpcInvalidCallParameter);
+    rpc_result->set_error_message("Invalid call parameter.");
+    return;
+  }
+
+  AtomicExchange(&peer_protocol_version_,
+                 static_cast<long>(peer_handshake.protocol_version()));
+
+  RpcHandshake handshake;
+  handshake.set_protocol_version(ProtocolVersion);
+  std::vector<RpcServiceRegistry::Service> services;
+  services_.GetServices(&services);
+  for (std::vector<RpcServiceRegistry::Service>::const_iterator iter =
+           services.begin();
+       iter != services.end(); iter++) {
+    RpcServiceBinding *binding = handshake.add_services();
+    binding->set_name(iter->first);
+    binding->set_object_id(iter->second);
+  }
+
+  handshake.SerializeToString(
+      rpc_result->mutable_call_result()->mutable_proto_value());
+}
+
+bool RpcObjectManager::ImplementationKey::operator<(
+    const ImplementationKey &other) const {
+  if (implementation != other.implementation)
+    return implementation < other.implementation;
+  return strcmp(interface_name, other.interface_name) < 0;
+}
+
 } // namespace
@@ -1,51 +1,211 @@
 #if !defined(NANO_RPC_RPC_OBJECT_MANANGER_HPP__)
 #define NANO_RPC_RPC_OBJECT_MANANGER_HPP__
 
-#include <string>
 #include <map>
+#include <string>
+#include <vector>
 
 #include "RpcMessageTypes.pb.h"
 
+#include "basictypes.hpp"
+#include "rpc_lease_wheel.hpp"
+#include "rpc_object_table.hpp"
 #include "rpc_service.hpp"
+#include "rpc_service_registry.hpp"
 #include "rpc_stub.hpp"
+#include "synchronization_primitives.hpp"
 
 namespace NanoRpc {
 
-typedef unsigned int RpcObjectId;
-
 class IRpcObjectManager {
 public:
   virtual ~IRpcObjectManager() {}
   virtual RpcObjectId RegisterInstance(IRpcService *instance) = 0;
+
+  // Registers the instance that marshals the implementation as the
+  // interface, so the same implementation returned again as that interface
+  // gets the same object id, see AddInstanceReference. If it got registered
+  // in the meantime, the instance is deleted and the existing id is returned
+  // with one more reference. The interface name is kept, not copied, the
+  // stubs pass the string literal.
+  virtual RpcObjectId RegisterInstance(IRpcService *instance,
+                                       const void *implementation,
+                                       const char *interface_name) = 0;
+
+  // Returns the id of the object registered for the implementation as the
+  // interface with one more reference to it, or 0 if there is no such
+  // object.
+  virtual RpcObjectId AddInstanceReference(const void *implementation,
+                                           const char *interface_name) = 0;
 };
 
+// Owns the objects of one connection and serves the client's handshake,
+// which maps the service names to their ids (see RpcClient), and Delete
+// calls. The objects other than the services are deleted by the client's
+// Delete (the counted ones with the last reference, see
+// AddInstanceReference), when the connection is gone (see DeleteInstances)
+// or, if the lease time is set, once they are not used for that long.
+//
+// The lookups take no locks. The object found may only be used while a
+// reader is active, see ScopedReader.
+//
+// This class is thread safe.
 class RpcObjectManager : public IRpcService, public IRpcObjectManager {
 public:
   static const char *const ServiceName;
 
+  // Keeps the objects found while it is alive from being deleted.
+  class ScopedReader {
+  public:
+    explicit ScopedReader(RpcObjectManager *object_manager)
+        : object_manager_(object_manager),
+          epoch_(object_manager->EnterReader()) {}
+    ~ScopedReader() { object_manager_->ExitReader(epoch_); }
+
+  private:
+    RpcObjectManager *object_manager_;
+    long epoch_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedReader);
+  };
+
+  // Version 1 peers address the services by object id and dispatch on
+  // RpcCall.method_ordinal when it is set. Version 2 peers also accept the
+  // calls in batches, see RpcMessage.batch, version 3 peers the calls
+  // pipelined on the objects returned by other calls, see RpcServer,
+  // version 4 peers the Delete call with more than one object id, and
+  // version 5 peers the arguments packed into RpcCall.packed_parameters.
+  static const unsigned int ProtocolVersion = 5;
+
   RpcObjectManager();
   virtual ~RpcObjectManager();
 
   void RegisterService(const char *name, IRpcService *service);
   void RegisterService(IRpcStub *stub);
 
-  // Currently implementation assumes that only unique instances are registered.
-  // So, it is wrong if method returns the same object accross multiple calls.
+  // Returns 0 if there are too many objects, see RpcObjectTable.
   RpcObjectId RegisterInstance(IRpcService *instance);
+  RpcObjectId RegisterInstance(IRpcService *instance,
+                               const void *implementation,
+                               const char *interface_name);
+
+  RpcObjectId AddInstanceReference(const void *implementation,
+                                   const char *interface_name);
 
   IRpcService *GetService(const char *name);
   IRpcService *GetService(const std::string &name);
+
+  // Returns the id of the service object or 0 if there is no such service.
+  RpcObjectId GetServiceId(const std::string &name);
+
+  // The object may only be used while the reader is active.
   IRpcService *GetInstance(RpcObjectId object_id);
 
   void DeleteObject(RpcObjectId object_id);
 
+  // Deletes all objects but the services.
+  void DeleteInstances();
+
+  // The objects not used for that long are deleted. Zero (the default)
+  // disables the leases. Must be set before the objects are registered.
+  void set_lease_time(unsigned int milliseconds);
+
+  // Deletes the objects whose leases have run out. Cheap while the wheel
+  // has not moved a tick.
+  void ExpireLeases();
+
+  // Releases one reference per id, if the object is counted. The ids of the
+  // objects that do not exist are skipped.
+  void DeleteObjects(const RpcObjectId *object_ids, size_t count);
+
+  // For the readers that outlive the scope, e.g. the asynchronous calls.
+  // Returns the value to pass to ExitReader.
+  long EnterReader();
+  void ExitReader(long epoch);
+
   void CallMethod(const RpcCall &rpc_call, RpcResult *rpc_result);
 
+  // Returns 0 until the peer's handshake is received.
+  unsigned int get_peer_protocol_version() const {
+    return static_cast<unsigned int>(peer_protocol_version_);
+  }
+
 private:
-  RpcObjectId last_object_id_;
+  // The implementation and the interface it is marshalled as.
+  struct ImplementationKey {
+    ImplementationKey() : implementation(NULL), interface_name(NULL) {}
+    ImplementationKey(const void *implementation, const char *interface_name)
+        : implementation(implementation), interface_name(interface_name) {}
+
+    bool operator<(const ImplementationKey &other) const;
+
+    const void *implementation;
+    const char *interface_name;
+  };
+
+  // The object registered for the implementation.
+  struct Instance {
+    Instance() : references(0) {}
+
+    ImplementationKey key;
+    size_t references;
+  };
+
+  typedef std::map<ImplementationKey, RpcObjectId> ImplementationMap;
+  typedef std::map<RpcObjectId, Instance> InstanceMap;
+
+  void Handshake(const RpcCall &rpc_call, RpcResult *rpc_result);
+
+  // Must be called under the lock. Inserts the object and starts its lease.
+  // Returns 0 if there are too many objects.
+  RpcObjectId InsertInstance(IRpcService *instance);
+
+  // Must be called under the lock. Returns 0 if the implementation is not
+  // registered as the interface.
+  RpcObjectId AddReference(const ImplementationKey &key);
+
+  // Must be called under the lock. Returns true if the object has no more
+  // references, or is not counted, and should be deleted.
+  bool ReleaseReference(RpcObjectId object_id);
+
+  // Must be called under the lock. Forgets the references to the object, if
+  // it is counted.
+  void ForgetInstance(RpcObjectId object_id);
+
+  // Must be called under the lock. Removes the object and retires it for
+  // DeleteRetiredObjects. Returns false if there is no such object.
+  bool RetireObject(RpcObjectId object_id);
+
+  // Advances the epoch if no reader of the previous one is left and appends
+  // the objects it is now safe to delete. Must be called under the lock.
+  bool AdvanceEpoch(std::vector<IRpcService *> *objects);
+
+  // Advances the epoch as far as the readers allow and deletes the objects
+  // that are no longer read.
+  void DeleteRetiredObjects();
+
+  RpcServiceRegistry services_;
+  RpcObjectTable objects_;
+
+  // The counted objects, both ways. Guarded by the lock.
+  ImplementationMap implementations_;
+  InstanceMap instances_;
+
+  // Guarded by the lock, but the current tick.
+  RpcLeaseWheel leases_;
+
+  volatile long epoch_;
+
+  // Active readers and the objects retired, by the parity of the epoch.
+  volatile long reader_counts_[2];
+  std::vector<IRpcService *> retired_objects_[2];
+
+  // Both epochs' retired objects. Checked without the lock by the readers.
+  volatile long retired_object_count_;
+
+  volatile long peer_protocol_version_;
 
-  std::map<std::string, RpcObjectId> services_;
-  std::map<RpcObjectId, IRpcService *> objects_;
+  Lock lock_;
 };
 
 } // namespace
@@ -0,0 +1,156 @@
+#include "rpc_object_table.hpp"
+
+#include <cassert>
+
+#include "atomic_operations.hpp"
+
+namespace NanoRpc {
+
+namespace {
+
+const unsigned int GenerationIncrement = RpcObjectTable::MaxObjectCount;
+
+} // namespace
+
+RpcObjectTable::RpcObjectTable()
+    : slot_count_(0), first_free_(NoSlot), last_free_(NoSlot),
+      object_count_(0) {
+  for (unsigned int i = 0; i < SegmentCount; ++i)
+    segments_[i] = NULL;
+}
+
+RpcObjectTable::~RpcObjectTable() {
+  for (unsigned int i = 0; i < SegmentCount; ++i)
+    delete[] segments_[i];
+}
+
+RpcObjectId RpcObjectTable::Insert(IRpcService *object) {
+  assert(object != NULL);
+
+  unsigned int index;
+  if (first_free_ != NoSlot) {
+    index = first_free_;
+    first_free_ = GetSlot(index)->next_free;
+    if (first_free_ == NoSlot)
+      last_free_ = NoSlot;
+  } else {
+    if (slot_count_ == MaxObjectCount)
+      return 0;
+
+    index = slot_count_++;
+    if (segments_[index >> SegmentBits] == NULL) {
+      // Published after the slots are constructed.
+      Slot *segment = new Slot[SegmentSize];
+      AtomicExchangePointer(&segments_[index >> SegmentBits], segment);
+    }
+  }
+
+  Slot *slot = GetSlot(index);
+  slot->generation = (slot->generation + GenerationIncrement) & GenerationMask;
+  if (slot->generation == 0)
+    slot->generation = GenerationIncrement;
+  slot->next_free = NoSlot;
+  ++object_count_;
+
+  RpcObjectId object_id = slot->generation | index;
+  slot->object = object;
+  slot->last_used = 0;
+  AtomicExchange(&slot->id, static_cast<long>(object_id));
+  return object_id;
+}
+
+IRpcService *RpcObjectTable::Get(RpcObjectId object_id) const {
+  if (object_id == 0)
+    return NULL;
+
+  const Slot *slot = GetSlot(object_id & IndexMask);
+  if (slot == NULL || slot->id != static_cast<long>(object_id))
+    return NULL;
+
+  IRpcService *object = slot->object;
+  if (slot->id != static_cast<long>(object_id))
+    return NULL;
+
+  return object;
+}
+
+IRpcService *RpcObjectTable::Remove(RpcObjectId object_id) {
+  if (object_id == 0)
+    return NULL;
+
+  unsigned int index = object_id & IndexMask;
+  Slot *slot = GetSlot(index);
+  if (slot == NULL ||
+      AtomicCompareExchange(&slot->id, 0, static_cast<long>(object_id)) !=
+          static_cast<long>(object_id))
+    return NULL;
+
+  IRpcService *object = slot->object;
+  FreeSlot(index);
+  return object;
+}
+
+void RpcObjectTable::RemoveAll(std::vector<IRpcService *> *objects) {
+  for (unsigned int index = 0; index < slot_count_; ++index) {
+    Slot *slot = GetSlot(index);
+    if (slot->id != 0) {
+      AtomicExchange(&slot->id, 0);
+      IRpcService *object = slot->object;
+      objects->push_back(object);
+      FreeSlot(index);
+    }
+  }
+}
+
+void RpcObjectTable::GetObjectIds(std::vector<RpcObjectId> *object_ids) const {
+  for (unsigned int index = 0; index < slot_count_; ++index) {
+    const Slot *slot = GetSlot(index);
+    if (slot->id != 0)
+      object_ids->push_back(static_cast<RpcObjectId>(slot->id));
+  }
+}
+
+void RpcObjectTable::MarkUsed(RpcObjectId object_id, long tick) {
+  if (object_id == 0)
+    return;
+
+  Slot *slot = GetSlot(object_id & IndexMask);
+  if (slot != NULL && slot->id == static_cast<long>(object_id))
+    slot->last_used = tick;
+}
+
+bool RpcObjectTable::GetLastUsed(RpcObjectId object_id, long *tick) const {
+  if (object_id == 0)
+    return false;
+
+  const Slot *slot = GetSlot(object_id & IndexMask);
+  if (slot == NULL || slot->id != static_cast<long>(object_id))
+    return false;
+
+  *tick = slot->last_used;
+  return true;
+}
+
+RpcObjectTable::Slot *RpcObjectTable::GetSlot(unsigned int index) const {
+  Slot *segment = segments_[index >> SegmentBits];
+  if (segment == NULL)
+    return NULL;
+
+  return &segment[index & (SegmentSize - 1)];
+}
+
+void RpcObjectTable::FreeSlot(unsigned int index) {
+  Slot *slot = GetSlot(index);
+  slot->object = NULL;
+  slot->next_free = NoSlot;
+
+  if (last_free_ != NoSlot)
+    GetSlot(last_free_)->next_free = index;
+  else
+    first_free_ = index;
+  last_free_ = index;
+
+  --object_count_;
+}
+
+} // namespace
@@ -0,0 +1,109 @@
+#if !defined(NANO_RPC_RPC_OBJECT_TABLE_HPP__)
+#define NANO_RPC_RPC_OBJECT_TABLE_HPP__
+
+#include <vector>
+
+#include "basictypes.hpp"
+#include "rpc_service.hpp"
+
+namespace NanoRpc {
+
+typedef unsigned int RpcObjectId;
+
+// Slot map of the marshalled objects, keyed by the object id.
+//
+// The id packs the slot index into the low bits and the slot's generation
+// into the high bits, so the lookup is a single array access and the id of
+// a deleted object does not find the object that reuses its slot. The freed
+// slots are reused in the order they were freed, so a slot's generation
+// wraps only after all other free slots have been reused as many times.
+//
+// The generation is never zero, so neither is the id.
+//
+// The slots are allocated in segments that never move, so the lookups take
+// no locks and do not wait: the slot's id is checked before and after the
+// object is read. The lookups may run concurrently with each other and with
+// one writer; the writers (Insert, Remove, RemoveAll) must be serialized by
+// the caller. MarkUsed is not a writer, it may run concurrently with
+// anything. The table does not keep the removed objects alive, see
+// RpcObjectManager for that.
+class RpcObjectTable {
+public:
+  static const unsigned int IndexBits = 20;
+  static const unsigned int MaxObjectCount = 1 << IndexBits;
+
+  RpcObjectTable();
+  ~RpcObjectTable();
+
+  // Returns 0 if the table is full.
+  RpcObjectId Insert(IRpcService *object);
+
+  // Returns NULL if there is no object with the id.
+  IRpcService *Get(RpcObjectId object_id) const;
+
+  // Returns NULL if there is no object with the id.
+  IRpcService *Remove(RpcObjectId object_id);
+
+  // Removes all objects and appends them to the vector.
+  void RemoveAll(std::vector<IRpcService *> *objects);
+
+  // Appends the ids of all objects to the vector.
+  void GetObjectIds(std::vector<RpcObjectId> *object_ids) const;
+
+  // Records the tick the object was last used at, see RpcLeaseWheel. Does
+  // nothing if there is no object with the id.
+  void MarkUsed(RpcObjectId object_id, long tick);
+
+  // Returns false if there is no object with the id.
+  bool GetLastUsed(RpcObjectId object_id, long *tick) const;
+
+  size_t get_object_count() const { return object_count_; }
+
+private:
+  static const unsigned int IndexMask = MaxObjectCount - 1;
+  static const unsigned int GenerationMask = ~IndexMask;
+  static const unsigned int SegmentBits = 10;
+  static const unsigned int SegmentSize = 1 << SegmentBits;
+  static const unsigned int SegmentCount = MaxObjectCount / SegmentSize;
+  static const unsigned int NoSlot = ~0U;
+
+  struct Slot {
+    Slot()
+        : id(0), object(NULL), last_used(0), generation(0),
+          next_free(NoSlot) {}
+
+    // Zero while the slot is free. Set after the object and cleared before
+    // it, so the lookup that sees the same id on both sides of reading the
+    // object has read the right one.
+    volatile long id;
+    IRpcService *volatile object;
+
+    // Reset on Insert. MarkUsed that races with the slot being reused only
+    // extends the new object's lease.
+    volatile long last_used;
+
+    // Only used by the writer. Kept in the high bits, like in the id.
+    unsigned int generation;
+    unsigned int next_free;
+  };
+
+  // Returns NULL if the slot is not allocated yet.
+  Slot *GetSlot(unsigned int index) const;
+
+  void FreeSlot(unsigned int index);
+
+  Slot *volatile segments_[SegmentCount];
+  unsigned int slot_count_;
+
+  // The free list is a queue, oldest freed slot first.
+  unsigned int first_free_;
+  unsigned int last_free_;
+
+  size_t object_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(RpcObjectTable);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_RPC_OBJECT_TABLE_HPP__
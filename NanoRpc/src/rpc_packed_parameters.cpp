@@ -0,0 +1,159 @@
+#include "rpc_packed_parameters.hpp"
+
+#include <cstring>
+
+#include "string_conversion.hpp"
+
+namespace NanoRpc {
+
+namespace {
+
+// A 64-bit varint takes at most 10 bytes, 7 bits each.
+const int MaxVarintSize = 10;
+
+unsigned long long ZigZagEncode(long long value) {
+  return (static_cast<unsigned long long>(value) << 1) ^
+         static_cast<unsigned long long>(value >> 63);
+}
+
+long long ZigZagDecode(unsigned long long value) {
+  return static_cast<long long>(value >> 1) ^
+         -static_cast<long long>(value & 1);
+}
+
+} // namespace
+
+void RpcPackedWriter::WriteBool(bool value) {
+  buffer_->push_back(value ? 1 : 0);
+}
+
+void RpcPackedWriter::WriteInt(int value) { WriteVarint(ZigZagEncode(value)); }
+
+void RpcPackedWriter::WriteLong(long long value) {
+  WriteVarint(ZigZagEncode(value));
+}
+
+void RpcPackedWriter::WriteDouble(double value) {
+  unsigned long long bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  char bytes[sizeof(bits)];
+  for (size_t i = 0; i < sizeof(bits); ++i)
+    bytes[i] = static_cast<char>(bits >> (i * 8));
+  buffer_->append(bytes, sizeof(bytes));
+}
+
+void RpcPackedWriter::WriteString(const std::wstring &value) {
+  std::string utf8;
+  WideToUtf8String(value, &utf8);
+  WriteBytes(utf8);
+}
+
+void RpcPackedWriter::WriteMessage(
+    const google::protobuf::MessageLite &value) {
+  std::string bytes;
+  value.SerializeToString(&bytes);
+  WriteBytes(bytes);
+}
+
+void RpcPackedWriter::WriteVarint(unsigned long long value) {
+  char bytes[MaxVarintSize];
+  int size = 0;
+  while (value >= 0x80) {
+    bytes[size++] = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  bytes[size++] = static_cast<char>(value);
+  buffer_->append(bytes, size);
+}
+
+void RpcPackedWriter::WriteBytes(const std::string &value) {
+  WriteVarint(value.size());
+  buffer_->append(value);
+}
+
+bool RpcPackedReader::ReadBool(bool *value) {
+  if (position_ == end_)
+    return false;
+
+  *value = *position_++ != 0;
+  return true;
+}
+
+bool RpcPackedReader::ReadInt(int *value) {
+  unsigned long long encoded;
+  if (!ReadVarint(&encoded))
+    return false;
+
+  *value = static_cast<int>(ZigZagDecode(encoded));
+  return true;
+}
+
+bool RpcPackedReader::ReadLong(long long *value) {
+  unsigned long long encoded;
+  if (!ReadVarint(&encoded))
+    return false;
+
+  *value = ZigZagDecode(encoded);
+  return true;
+}
+
+bool RpcPackedReader::ReadDouble(double *value) {
+  unsigned long long bits = 0;
+  if (static_cast<size_t>(end_ - position_) < sizeof(bits))
+    return false;
+
+  for (size_t i = 0; i < sizeof(bits); ++i) {
+    bits |= static_cast<unsigned long long>(
+                static_cast<unsigned char>(*position_++)) << (i * 8);
+  }
+  memcpy(value, &bits, sizeof(bits));
+  return true;
+}
+
+bool RpcPackedReader::ReadString(std::wstring *value) {
+  const char *data;
+  size_t size;
+  if (!ReadBytes(&data, &size))
+    return false;
+
+  Utf8ToWideString(std::string(data, size), value);
+  return true;
+}
+
+bool RpcPackedReader::ReadMessage(google::protobuf::MessageLite *value) {
+  const char *data;
+  size_t size;
+  if (!ReadBytes(&data, &size))
+    return false;
+
+  return value->ParseFromArray(data, static_cast<int>(size));
+}
+
+bool RpcPackedReader::ReadVarint(unsigned long long *value) {
+  unsigned long long result = 0;
+  for (int i = 0; i < MaxVarintSize && position_ != end_; ++i) {
+    unsigned char byte = static_cast<unsigned char>(*position_++);
+    result |= static_cast<unsigned long long>(byte & 0x7F) << (i * 7);
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool RpcPackedReader::ReadBytes(const char **data, size_t *size) {
+  unsigned long long length;
+  if (!ReadVarint(&length) ||
+      length > static_cast<unsigned long long>(end_ - position_))
+    return false;
+
+  *data = position_;
+  *size = static_cast<size_t>(length);
+  position_ += *size;
+  return true;
+}
+
+} // namespace
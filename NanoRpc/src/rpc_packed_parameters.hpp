@@ -0,0 +1,82 @@
+#if !defined(NANO_RPC_RPC_PACKED_PARAMETERS_HPP__)
+#define NANO_RPC_RPC_PACKED_PARAMETERS_HPP__
+
+#include <string>
+
+#include <google/protobuf/message_lite.h>
+
+#include "basictypes.hpp"
+
+namespace NanoRpc {
+
+// Packs the arguments of the call into RpcCall.packed_parameters, one after
+// another in the order of the method's signature, with no tags and no
+// wrapping message per argument. The method's signature is all the stub
+// needs to unpack them, see RpcPackedReader.
+//
+// The integers and the enums are zigzag varints, so the small negative
+// values stay short, the doubles are 8 bytes little-endian, the strings are
+// UTF-8 and the messages serialized, both prefixed with the varint length.
+// The bools are one byte.
+//
+// Only the servers that report protocol version 5 or later in the handshake
+// accept the packed calls, see IRpcClient::AcceptsPackedParameters.
+class RpcPackedWriter {
+public:
+  explicit RpcPackedWriter(std::string *buffer) : buffer_(buffer) {}
+
+  void WriteBool(bool value);
+  void WriteInt(int value);
+  void WriteLong(long long value);
+  void WriteDouble(double value);
+  void WriteString(const std::wstring &value);
+  void WriteMessage(const google::protobuf::MessageLite &value);
+
+private:
+  void WriteVarint(unsigned long long value);
+  void WriteBytes(const std::string &value);
+
+  std::string *buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(RpcPackedWriter);
+};
+
+// Unpacks the arguments packed by RpcPackedWriter, in the same order. Every
+// read returns false if the buffer ends before the value does, or the value
+// does not parse.
+class RpcPackedReader {
+public:
+  explicit RpcPackedReader(const std::string &buffer)
+      : position_(buffer.data()), end_(buffer.data() + buffer.size()) {}
+
+  bool ReadBool(bool *value);
+  bool ReadInt(int *value);
+  bool ReadLong(long long *value);
+  bool ReadDouble(double *value);
+  bool ReadString(std::wstring *value);
+  bool ReadMessage(google::protobuf::MessageLite *value);
+
+  template <typename Enum> bool ReadEnum(Enum *value) {
+    int number;
+    if (!ReadInt(&number))
+      return false;
+
+    *value = static_cast<Enum>(number);
+    return true;
+  }
+
+private:
+  bool ReadVarint(unsigned long long *value);
+
+  // Reads the length prefix and returns the bytes it covers.
+  bool ReadBytes(const char **data, size_t *size);
+
+  const char *position_;
+  const char *end_;
+
+  DISALLOW_COPY_AND_ASSIGN(RpcPackedReader);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_RPC_PACKED_PARAMETERS_HPP__
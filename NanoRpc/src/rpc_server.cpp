@@ -7,9 +7,17 @@
 #include "rpc_object_manager.hpp"
 #include "rpc_controller.hpp"
 #include "rpc_service.hpp"
+#include "atomic_operations.hpp"
 
 namespace NanoRpc {
 
+namespace {
+
+// How often the destructor checks for the calls still being dispatched.
+const unsigned int DispatchDrainInterval = 10;
+
+} // namespace
+
 class ExternallyControlledLifetimeWrapper : public IRpcService {
 public:
   ExternallyControlledLifetimeWrapper(IRpcService *object) : object_(object) {}
@@ -18,11 +26,18 @@ public:
     object_->CallMethod(rpc_call, rpc_result);
   }
 
+  virtual IRpcAsyncService *GetAsyncService() {
+    return object_->GetAsyncService();
+  }
+
 private:
   IRpcService *object_;
 };
 
-RpcServer::RpcServer(RpcController *controller) : controller_(controller) {
+RpcServer::RpcServer(RpcController *controller)
+    : controller_(controller), worker_pool_(WorkerPool::GetDefault()),
+      strands_(worker_pool_), pending_dispatch_count_(0),
+      dispatch_drained_event_(false, false) {
   controller_->set_server(this);
   RegisterService(RpcObjectManager::ServiceName,
                   new ExternallyControlledLifetimeWrapper(&object_manager_));
@@ -31,6 +46,17 @@ RpcServer::RpcServer(RpcController *controller) : controller_(controller) {
 }
 
 RpcServer::~RpcServer() {
+  // The strand still touches the map after the last call completes.
+  while (pending_dispatch_count_ != 0 || strands_.GetActiveStrandCount() != 0)
+    dispatch_drained_event_.Wait(DispatchDrainInterval);
+
+  // Every target completes before the calls drain, so nothing should be
+  // waiting here.
+  for (AnswerMap::iterator iter = answers_.begin(); iter != answers_.end();
+       iter++) {
+    assert(iter->second.pipelined_calls_.empty());
+  }
+
   if (controller_ != NULL) {
     controller_->set_server(NULL);
   }
@@ -50,6 +76,11 @@ void RpcServer::RegisterService(IRpcStub *stub) {
 
 void RpcServer::Receive(const RpcMessage &rpcMessage) {
   if (rpcMessage.has_result() && rpcMessage.result().status() != RpcSucceeded) {
+    // The objects marshalled over the connection are of no use to anyone
+    // once it is gone, the services stay for the next one.
+    if (rpcMessage.result().status() == RpcChannelFailure)
+      object_manager_.DeleteInstances();
+
     // TODO: Dont know what to do in this case yet.
     // We were waiting for the message and seen the channel break and received
     // notification about it.
@@ -62,6 +93,292 @@ void RpcServer::Receive(const RpcMessage &rpcMessage) {
     return;
   }
 
+  object_manager_.ExpireLeases();
+
+  if (rpcMessage.has_batch()) {
+    ReceiveBatch(rpcMessage);
+    return;
+  }
+
+  // The answer is expected before anything can be pipelined on it, the
+  // calls that can are received after this one.
+  if (rpcMessage.call().is_pipeline_target() && rpcMessage.id() != 0)
+    ExpectAnswer(rpcMessage.id());
+
+  Post(rpcMessage, NULL);
+}
+
+void RpcServer::Post(const RpcMessage &rpcMessage, Batch *batch) {
+  if (rpcMessage.call().has_target_call_id()) {
+    PostPipelined(rpcMessage, batch);
+    return;
+  }
+
+  // The target is looked up once, the dispatch reuses it.
+  RpcObjectId object_id = GetTargetObjectId(rpcMessage.call());
+
+  if (worker_pool_ == NULL) {
+    Dispatch(rpcMessage, object_id, batch);
+    return;
+  }
+
+  DispatchTask *task = dispatch_task_pool_.Allocate();
+  task->server_ = this;
+  task->message_.CopyFrom(rpcMessage);
+  task->object_id_ = object_id;
+  task->batch_ = batch;
+
+  AtomicIncrement(&pending_dispatch_count_);
+
+  // Calls to the unknown objects fail right away, there is nothing to order.
+  if (object_id != 0)
+    strands_.Post(object_id, task);
+  else
+    worker_pool_->Submit(task);
+}
+
+void RpcServer::ReceiveBatch(const RpcMessage &rpcMessage) {
+  const RpcBatch &calls = rpcMessage.batch();
+
+  // The results are allocated up front, so the calls never add to the
+  // reply while the other calls are filling it in.
+  Batch *batch = batch_pool_.Allocate();
+  batch->reply_.set_id(rpcMessage.id());
+  batch->results_ = batch->reply_.mutable_batch();
+  for (int i = 0; i < calls.calls_size(); ++i)
+    batch->results_->add_results();
+
+  // The extra count keeps the batch from completing before all of its calls
+  // are posted.
+  batch->remaining_count_ = calls.calls_size() + 1;
+
+  RpcMessage callMessage;
+  for (int i = 0; i < calls.calls_size(); ++i) {
+    callMessage.set_id(i);
+    callMessage.mutable_call()->CopyFrom(calls.calls(i));
+    Post(callMessage, batch);
+  }
+
+  BatchCallCompleted(batch);
+}
+
+void RpcServer::BatchCallCompleted(Batch *batch) {
+  if (AtomicDecrement(&batch->remaining_count_) != 0)
+    return;
+
+  // The message without the id does not expect the results.
+  if (batch->reply_.id() != 0)
+    controller_->Send(batch->reply_);
+
+  batch->reply_.Clear();
+  batch->results_ = NULL;
+  batch_pool_.Deallocate(batch);
+}
+
+void RpcServer::ExpectAnswer(int call_id) {
+  std::vector<PipelinedCall *> forgotten_calls;
+  {
+    ScopedLock lock(answers_lock_);
+
+    // The ids wrap around only after billions of calls, long after the
+    // answer is forgotten.
+    if (!answers_.insert(AnswerMap::value_type(call_id, Answer())).second)
+      return;
+    answer_ids_.push_back(call_id);
+
+    // The target that never completes, e.g. held by a deferred handler, is
+    // forgotten all the same, and the calls pipelined on it fail.
+    while (answer_ids_.size() > MaxAnswerCount) {
+      AnswerMap::iterator iter = answers_.find(answer_ids_.front());
+      std::vector<PipelinedCall *> &pipelined_calls =
+          iter->second.pipelined_calls_;
+      forgotten_calls.insert(forgotten_calls.end(), pipelined_calls.begin(),
+                             pipelined_calls.end());
+
+      answers_.erase(iter);
+      answer_ids_.pop_front();
+    }
+  }
+
+  if (forgotten_calls.empty())
+    return;
+
+  RpcResult error;
+  error.set_status(RpcUnknownInterface);
+  error.set_error_message("The pipeline target was forgotten");
+  PostPipelinedCalls(forgotten_calls, 0, error);
+}
+
+void RpcServer::PostPipelined(const RpcMessage &rpcMessage, Batch *batch) {
+  RpcObjectId object_id = 0;
+  RpcResult error;
+  {
+    ScopedLock lock(answers_lock_);
+    AnswerMap::iterator iter =
+        answers_.find(rpcMessage.call().target_call_id());
+    if (iter == answers_.end()) {
+      error.set_status(RpcUnknownInterface);
+      error.set_error_message("Unknown pipeline target");
+    } else if (!iter->second.is_resolved_) {
+      PipelinedCall *call = pipelined_call_pool_.Allocate();
+      call->message_.CopyFrom(rpcMessage);
+      call->batch_ = batch;
+      iter->second.pipelined_calls_.push_back(call);
+      return;
+    } else {
+      object_id = iter->second.object_id_;
+      error.CopyFrom(iter->second.error_);
+    }
+  }
+
+  PostResolved(rpcMessage, batch, object_id, error);
+}
+
+void RpcServer::PostResolved(const RpcMessage &rpcMessage, Batch *batch,
+                             RpcObjectId object_id, const RpcResult &error) {
+  if (object_id == 0) {
+    SendResult(rpcMessage, error, batch);
+    return;
+  }
+
+  RpcMessage resolvedMessage;
+  resolvedMessage.CopyFrom(rpcMessage);
+  resolvedMessage.mutable_call()->clear_target_call_id();
+  resolvedMessage.mutable_call()->set_object_id(object_id);
+  Post(resolvedMessage, batch);
+}
+
+void RpcServer::ResolveAnswer(int call_id, const RpcResult &rpc_result) {
+  RpcObjectId object_id = 0;
+  if (rpc_result.status() == RpcSucceeded)
+    object_id = rpc_result.call_result().object_id_value();
+
+  RpcResult error;
+  if (rpc_result.status() != RpcSucceeded) {
+    error.set_status(rpc_result.status());
+    error.set_error_message(rpc_result.error_message());
+  } else if (object_id == 0) {
+    error.set_status(RpcUnknownInterface);
+    error.set_error_message("The pipeline target returned no object");
+  }
+
+  std::vector<PipelinedCall *> pipelined_calls;
+  {
+    ScopedLock lock(answers_lock_);
+    AnswerMap::iterator iter = answers_.find(call_id);
+    if (iter == answers_.end())
+      return;
+
+    Answer &answer = iter->second;
+    answer.is_resolved_ = true;
+    answer.object_id_ = object_id;
+    answer.error_.CopyFrom(error);
+    pipelined_calls.swap(answer.pipelined_calls_);
+  }
+
+  PostPipelinedCalls(pipelined_calls, object_id, error);
+}
+
+void RpcServer::PostPipelinedCalls(
+    const std::vector<PipelinedCall *> &pipelined_calls,
+    RpcObjectId object_id, const RpcResult &error) {
+  for (std::vector<PipelinedCall *>::const_iterator iter =
+           pipelined_calls.begin();
+       iter != pipelined_calls.end(); iter++) {
+    PipelinedCall *call = *iter;
+    PostResolved(call->message_, call->batch_, object_id, error);
+    call->message_.Clear();
+    call->batch_ = NULL;
+    pipelined_call_pool_.Deallocate(call);
+  }
+}
+
+RpcObjectId RpcServer::GetTargetObjectId(const RpcCall &rpc_call) {
+  if (rpc_call.object_id() != 0)
+    return rpc_call.object_id();
+
+  return object_manager_.GetServiceId(rpc_call.service());
+}
+
+void RpcServer::DispatchTask::Run() {
+  server_->Dispatch(message_, object_id_, batch_);
+  server_->DispatchCompleted(this);
+}
+
+void RpcServer::DispatchCompleted(DispatchTask *task) {
+  task->message_.Clear();
+  task->batch_ = NULL;
+  dispatch_task_pool_.Deallocate(task);
+
+  DispatchFinished();
+}
+
+void RpcServer::DispatchAsync(IRpcAsyncService *service,
+                              const RpcMessage &rpcMessage, Batch *batch) {
+  // The received message is reused as soon as the dispatch returns, the
+  // handler may need the call for longer than that.
+  AsyncCall *call = async_call_pool_.Allocate();
+  call->server_ = this;
+  call->message_.CopyFrom(rpcMessage);
+  call->batch_ = batch;
+  call->reader_epoch_ = object_manager_.EnterReader();
+
+  AtomicIncrement(&pending_dispatch_count_);
+  service->CallMethodAsync(call->message_.call(), &call->result_, call);
+}
+
+void RpcServer::AsyncCall::Complete() { server_->AsyncCallCompleted(this); }
+
+void RpcServer::AsyncCallCompleted(AsyncCall *call) {
+  SendResult(call->message_, call->result_, call->batch_);
+  object_manager_.ExitReader(call->reader_epoch_);
+
+  call->message_.Clear();
+  call->result_.Clear();
+  call->batch_ = NULL;
+  async_call_pool_.Deallocate(call);
+
+  DispatchFinished();
+}
+
+void RpcServer::DispatchFinished() {
+  // The destructor returns as soon as it sees no pending dispatches, so the
+  // event is set before the count drops to zero and nothing is touched after.
+  long count;
+  do {
+    count = pending_dispatch_count_;
+    if (count == 1)
+      dispatch_drained_event_.Set();
+  } while (AtomicCompareExchange(&pending_dispatch_count_, count - 1,
+                                 count) != count);
+}
+
+void RpcServer::SendResult(const RpcMessage &rpcMessage,
+                           const RpcResult &rpc_result, Batch *batch) {
+  if (batch != NULL) {
+    batch->results_->mutable_results(rpcMessage.id())->CopyFrom(rpc_result);
+    BatchCallCompleted(batch);
+    return;
+  }
+
+  // The calls pipelined on this one are posted before its result is sent.
+  if (rpcMessage.call().is_pipeline_target())
+    ResolveAnswer(rpcMessage.id(), rpc_result);
+
+  // TODO: See comment in Dispatch on expects_result and handling
+  // rpc_result containing an error.
+  if (!rpcMessage.call().expects_result())
+    return;
+
+  // Send back the result to the client if client requested it.
+  RpcMessage resultMessage;
+  resultMessage.set_id(rpcMessage.id());
+  resultMessage.mutable_result()->MergeFrom(rpc_result);
+  controller_->Send(resultMessage);
+}
+
+void RpcServer::Dispatch(const RpcMessage &rpcMessage, RpcObjectId object_id,
+                         Batch *batch) {
   // TODO: Asynchronous calls, see below.
   /*
   // Here we have the option of handling incoming calls sequentually
@@ -74,12 +391,13 @@ void RpcServer::Receive(const RpcMessage &rpcMessage) {
   // The default server behavior can also be specified as Syncrhonous or
   Asynchronous.
    */
-  // For now make all calls synchronous.
+  // For now all calls are made asynchronously on the worker pool (unless
+  // there is none), so the service implementations must be thread safe.
 
   IRpcService *service = NULL;
 
-  RpcMessage resultMessage;
-  resultMessage.set_id(rpcMessage.id());
+  // The client may delete the object while the call is being dispatched.
+  RpcObjectManager::ScopedReader reader(&object_manager_);
 
   // Check if the call relates to the singleton or transient object and
   // then try to find the appropriate service.
@@ -90,40 +408,32 @@ void RpcServer::Receive(const RpcMessage &rpcMessage) {
   // The transient objects are registered as result of a method call and
   // identified by context ID.
   // The lifetime of a transient object controlled by the client.
-  if (rpcMessage.call().object_id() != 0) {
-    // Try to find object that corresponds to the marshalled interface.
-    service = object_manager_.GetInstance(rpcMessage.call().object_id());
-    if (service == NULL) {
-      // The requested service was not found. Reply with an error.
-      resultMessage.mutable_result()->set_status(RpcUnknownInterface);
-      resultMessage.mutable_result()->set_error_message(
-          "Marshalled object does not exist (was object disposed?).");
-    }
-  } else {
-    // Try to find the requested service.
-    service = object_manager_.GetService(rpcMessage.call().service().c_str());
-    if (service == NULL) {
-      // The requested service was not found. Reply with an error.
-      resultMessage.mutable_result()->set_status(RpcUnknownInterface);
-      resultMessage.mutable_result()->set_error_message("Unknown interface");
-    }
-  }
+  //
+  // Either way the object id was found by GetTargetObjectId.
+  service = object_manager_.GetInstance(object_id);
+
+  RpcResult rpc_result;
 
   // If service was found - service the call, otherwise respond with an error.
   if (service != NULL) {
-    RpcResult rpc_result;
+    IRpcAsyncService *async_service = service->GetAsyncService();
+    if (async_service != NULL) {
+      DispatchAsync(async_service, rpcMessage, batch);
+      return;
+    }
 
     // Call the requested method.
     service->CallMethod(rpcMessage.call(), &rpc_result);
-    // TODO: See comment in else branch on expects_result and handling
-    // rpc_result containing an error.
-    if (rpcMessage.call().expects_result()) {
-      // Send back the result to the client if client requested it.
-      assert(resultMessage.has_id());
-      resultMessage.mutable_result()->MergeFrom(rpc_result);
-      controller_->Send(resultMessage);
-    }
   } else {
+    // The requested service was not found. Reply with an error.
+    rpc_result.set_status(RpcUnknownInterface);
+    if (rpcMessage.call().object_id() != 0) {
+      rpc_result.set_error_message(
+          "Marshalled object does not exist (was object disposed?).");
+    } else {
+      rpc_result.set_error_message("Unknown interface");
+    }
+
     // If client does not expect result, there is no point of sending one,
     // even if it is an error message.
     // TODO: It possibly make sense to implement catch all
@@ -132,13 +442,9 @@ void RpcServer::Receive(const RpcMessage &rpcMessage) {
     // condition have to be removed. Also, it make sense control the behavior,
     // whether the server replies with an error message, even if the call does
     // not expect the result, through an option on the server.
-    if (rpcMessage.call().expects_result()) {
-      assert(resultMessage.has_id());
-      assert(resultMessage.has_result());
-      assert(resultMessage.result().has_status());
-      controller_->Send(resultMessage);
-    }
   }
+
+  SendResult(rpcMessage, rpc_result, batch);
 }
 
 void RpcServer::Send(RpcMessage &rpcMessage) {
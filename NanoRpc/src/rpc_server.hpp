@@ -1,14 +1,20 @@
 #if !defined(NANO_RPC_RPC_SERVER_HPP__)
 #define NANO_RPC_RPC_SERVER_HPP__
 
+#include <deque>
 #include <map>
 #include <set>
+#include <vector>
 
 #include "rpc_event_service.hpp"
 #include "rpc_object_manager.hpp"
 #include "rpc_message_sender.hpp"
 #include "rpc_service.hpp"
 #include "rpc_stub.hpp"
+#include "object_pool.hpp"
+#include "strand.hpp"
+#include "synchronization_primitives.hpp"
+#include "worker_pool.hpp"
 #include "RpcMessageTypes.pb.h"
 
 namespace NanoRpc {
@@ -20,16 +26,70 @@ class RpcController;
 
 // Implements the server side that receives client's calls and replies with
 // result.
+//
+// The calls are dispatched on the worker pool, by default the process-wide
+// one, so the channel's I/O thread only reads and writes and a slow call does
+// not hold up the other calls received on the connection. The calls that
+// target the same object (or the same service) run one at a time in the
+// order they were received, calls to different objects run in parallel.
+// Without a worker pool the calls are dispatched inline, on the thread that
+// received them.
+//
+// The calls to the asynchronous services (see IRpcAsyncService) complete
+// whenever the handler says so, the worker moves on to the next call as soon
+// as the handler returns. The order in which such calls complete is up to
+// the service.
+//
+// The calls received in one batch (see RpcBatch) are dispatched the same
+// way, each on its own, and their results are sent back in one message once
+// the last of them completes.
+//
+// The call may be pipelined on the object another call returns, so the
+// client does not wait for that call's result before calling the object.
+// The server keeps the object id returned by every call marked as the
+// pipeline target (RpcCall.is_pipeline_target), and the call that targets
+// it (RpcCall.target_call_id) waits until it is there, then goes to that
+// object. If the target call fails or returns no object, so do the calls
+// pipelined on it. Only the last MaxAnswerCount targets are kept, whether
+// they completed or not, the calls pipelined on the older ones fail with
+// RpcUnknownInterface. The calls in a batch may be pipelined on the calls
+// sent on their own, but not be the targets themselves.
+//
+// The objects the calls return belong to the connection, they are deleted
+// when it fails or, if the lease time is set, when they are not used for
+// that long, see RpcObjectManager.
 class RpcServer : public IRpcMessageSender {
 public:
   explicit RpcServer(RpcController *controller);
+
+  // Waits for the calls that are being dispatched.
   ~RpcServer();
 
+  // NULL worker pool means the calls are dispatched inline. Should be set
+  // before the channel is started.
+  void set_worker_pool(WorkerPool *worker_pool) {
+    worker_pool_ = worker_pool;
+    strands_.set_worker_pool(worker_pool);
+  }
+  WorkerPool *get_worker_pool() { return worker_pool_; }
+
   void RegisterService(const char *name, IRpcService *service);
   void RegisterService(IRpcStub *stub);
 
   IRpcObjectManager *GetObjectManager() { return &object_manager_; }
 
+  // The objects the clients do not use for that long are deleted, see
+  // RpcObjectManager::set_lease_time. Zero (the default) means they live
+  // until the client deletes them or the connection is gone. Should be set
+  // before the channel is started.
+  void set_object_lease_time(unsigned int milliseconds) {
+    object_manager_.set_lease_time(milliseconds);
+  }
+
+  // The leases run out as the calls are received. The host may call this
+  // periodically, so they also run out on the idle connection.
+  void ExpireObjectLeases() { object_manager_.ExpireLeases(); }
+
   void Receive(const RpcMessage &rpcMessage);
 
   // Sends a message to the client.
@@ -38,8 +98,152 @@ public:
   virtual void Send(RpcMessage &rpcMessage);
 
 private:
+  // Calls received in one message. The results are collected in the reply
+  // in the order of the calls.
+  class Batch {
+  public:
+    Batch() : results_(NULL), remaining_count_(0) {}
+
+    RpcMessage reply_;
+
+    // Points into the reply. Every call fills in its own result, so the
+    // calls completing on different threads do not touch the same object.
+    RpcBatch *results_;
+
+    // The calls not completed yet, plus one while they are being posted.
+    volatile long remaining_count_;
+  };
+
+  // Call that waits for the object returned by the call it is pipelined on.
+  class PipelinedCall {
+  public:
+    PipelinedCall() : batch_(NULL) {}
+
+    RpcMessage message_;
+    Batch *batch_;
+  };
+
+  // Object returned by the pipeline target.
+  class Answer {
+  public:
+    Answer() : is_resolved_(false), object_id_(0) {}
+
+    bool is_resolved_;
+
+    // Zero if the target failed or returned no object, in which case the
+    // pipelined calls fail with the error.
+    RpcObjectId object_id_;
+    RpcResult error_;
+
+    // The calls received before the target completed.
+    std::vector<PipelinedCall *> pipelined_calls_;
+  };
+
+  typedef std::map<int, Answer> AnswerMap;
+
+  static const size_t MaxAnswerCount = 1024;
+
+  // The received message is copied into the task, the channel reuses its
+  // message objects for the next read.
+  class DispatchTask : public WorkerPool::Task {
+  public:
+    DispatchTask() : server_(NULL), object_id_(0), batch_(NULL) {}
+
+    virtual void Run();
+
+    RpcServer *server_;
+    RpcMessage message_;
+    RpcObjectId object_id_;
+    Batch *batch_;
+  };
+
+  // Call to the asynchronous service, which keeps the call and the result
+  // until the handler completes it.
+  class AsyncCall : public IRpcAsyncService::ICompletion {
+  public:
+    AsyncCall() : server_(NULL), batch_(NULL), reader_epoch_(0) {}
+
+    virtual void Complete();
+
+    RpcServer *server_;
+    RpcMessage message_;
+    RpcResult result_;
+    Batch *batch_;
+
+    // The service is not deleted until the call completes.
+    long reader_epoch_;
+  };
+
+  // Dispatches the call inline or posts it to the worker pool. The call
+  // that belongs to the batch has the index of the call in the batch for
+  // the message id.
+  void Post(const RpcMessage &rpcMessage, Batch *batch);
+
+  void ReceiveBatch(const RpcMessage &rpcMessage);
+
+  // Makes room for the object the call is going to return.
+  void ExpectAnswer(int call_id);
+
+  // Posts the call to the object returned by its target, or keeps it until
+  // the target completes.
+  void PostPipelined(const RpcMessage &rpcMessage, Batch *batch);
+  void PostResolved(const RpcMessage &rpcMessage, Batch *batch,
+                    RpcObjectId object_id, const RpcResult &error);
+
+  // Posts the calls waiting for the result of the target.
+  void ResolveAnswer(int call_id, const RpcResult &rpc_result);
+  void PostPipelinedCalls(const std::vector<PipelinedCall *> &pipelined_calls,
+                          RpcObjectId object_id, const RpcResult &error);
+
+  // Sends the results once all calls in the batch complete.
+  void BatchCallCompleted(Batch *batch);
+
+  // Returns the id of the object the call targets, or 0 if there is no such
+  // object.
+  RpcObjectId GetTargetObjectId(const RpcCall &rpc_call);
+
+  // Services the call and sends the result back. The object id is the one
+  // GetTargetObjectId returned for the call.
+  void Dispatch(const RpcMessage &rpcMessage, RpcObjectId object_id,
+                Batch *batch);
+
+  void DispatchCompleted(DispatchTask *task);
+
+  void DispatchAsync(IRpcAsyncService *service, const RpcMessage &rpcMessage,
+                     Batch *batch);
+  void AsyncCallCompleted(AsyncCall *call);
+
+  // Takes the completed call off the pending dispatch count. The server may
+  // be destroyed as soon as this returns.
+  void DispatchFinished();
+
+  // Sends the result of the call, if the client expects it, or stores it in
+  // the batch.
+  void SendResult(const RpcMessage &rpcMessage, const RpcResult &rpc_result,
+                  Batch *batch);
+
   RpcController *controller_;
 
+  WorkerPool *worker_pool_;
+  ObjectPool<DispatchTask> dispatch_task_pool_;
+  ObjectPool<AsyncCall> async_call_pool_;
+  ObjectPool<Batch> batch_pool_;
+  ObjectPool<PipelinedCall> pipelined_call_pool_;
+
+  // Keyed by the message id of the pipeline target. The ids are kept in the
+  // order the targets were received, the oldest are forgotten first.
+  AnswerMap answers_;
+  std::deque<int> answer_ids_;
+  Lock answers_lock_;
+
+  // Keyed by the target object id.
+  StrandMap strands_;
+
+  // Number of the calls queued or being dispatched on the worker pool, plus
+  // the asynchronous calls that are not completed yet.
+  volatile long pending_dispatch_count_;
+  Event dispatch_drained_event_;
+
   // This service keeps track of event subscriptions.
   // If client is interested in receiving events, it should
   // subscribe providing event interface name.
@@ -5,10 +5,39 @@
 
 namespace NanoRpc {
 
+class IRpcAsyncService;
+
 class IRpcService {
 public:
   virtual ~IRpcService() {}
   virtual void CallMethod(const RpcCall &rpc_call, RpcResult *rpc_result) = 0;
+
+  // Returns the interface to use instead of CallMethod, if the service may
+  // complete its calls after returning from the handler.
+  virtual IRpcAsyncService *GetAsyncService() { return NULL; }
+};
+
+// Service whose handlers may complete the call later, e.g. a coroutine
+// that waits for a call to another server (see rpc_coroutine.hpp) or a
+// handler that keeps the completion token (see rpc_completion_token.hpp), so
+// the worker is not held while the handler waits.
+class IRpcAsyncService : public IRpcService {
+public:
+  class ICompletion {
+  public:
+    virtual ~ICompletion() {}
+
+    // Sends back the result. Must be called exactly once, on any thread,
+    // after the result is filled in.
+    virtual void Complete() = 0;
+  };
+
+  // The call and the result stay valid until the completion is invoked,
+  // which may happen before this returns.
+  virtual void CallMethodAsync(const RpcCall &rpc_call, RpcResult *rpc_result,
+                               ICompletion *completion) = 0;
+
+  virtual IRpcAsyncService *GetAsyncService() { return this; }
 };
 
 } // namespace
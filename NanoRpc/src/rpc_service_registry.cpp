@@ -0,0 +1,109 @@
+#include "rpc_service_registry.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#include "atomic_operations.hpp"
+
+namespace NanoRpc {
+
+namespace {
+
+// 32-bit FNV-1a.
+const unsigned int HashOffsetBasis = 2166136261U;
+const unsigned int HashPrime = 16777619U;
+
+} // namespace
+
+RpcServiceRegistry::RpcServiceRegistry()
+    : table_(new Table(InitialCapacity)), service_count_(0) {}
+
+RpcServiceRegistry::~RpcServiceRegistry() {
+  delete table_;
+  for (std::vector<Table *>::const_iterator iter = retired_tables_.begin();
+       iter != retired_tables_.end(); iter++) {
+    delete *iter;
+  }
+}
+
+unsigned int RpcServiceRegistry::Hash(const char *name, size_t length) {
+  unsigned int hash = HashOffsetBasis;
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= static_cast<unsigned char>(name[i]);
+    hash *= HashPrime;
+  }
+  return hash;
+}
+
+void RpcServiceRegistry::Insert(const std::string &name,
+                                RpcObjectId object_id) {
+  assert(object_id != 0);
+
+  // Keep the load factor at or below one half, so the probe sequences stay
+  // short and there is always a free entry to stop at.
+  if ((service_count_ + 1) * 2 > table_->mask + 1)
+    Grow();
+
+  unsigned int hash = Hash(name.data(), name.size());
+  Entry *entry = Probe(table_, name.data(), name.size(), hash);
+  if (entry->object_id == 0) {
+    entry->hash = hash;
+    entry->name = name;
+    ++service_count_;
+  }
+
+  AtomicExchange(&entry->object_id, static_cast<long>(object_id));
+}
+
+RpcObjectId RpcServiceRegistry::Find(const char *name, size_t length) const {
+  const Entry *entry = Probe(table_, name, length, Hash(name, length));
+  return static_cast<RpcObjectId>(entry->object_id);
+}
+
+void RpcServiceRegistry::GetServices(std::vector<Service> *services) const {
+  Table *table = table_;
+  for (size_t i = 0; i <= table->mask; ++i) {
+    const Entry &entry = table->entries[i];
+    if (entry.object_id != 0) {
+      services->push_back(
+          Service(entry.name, static_cast<RpcObjectId>(entry.object_id)));
+    }
+  }
+}
+
+RpcServiceRegistry::Entry *RpcServiceRegistry::Probe(Table *table,
+                                                     const char *name,
+                                                     size_t length,
+                                                     unsigned int hash) {
+  for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+    Entry *entry = &table->entries[i];
+    if (entry->object_id == 0)
+      return entry;
+
+    if (entry->hash == hash && entry->name.size() == length &&
+        memcmp(entry->name.data(), name, length) == 0)
+      return entry;
+  }
+}
+
+void RpcServiceRegistry::Grow() {
+  Table *table = table_;
+  Table *new_table = new Table((table->mask + 1) * 2);
+
+  for (size_t i = 0; i <= table->mask; ++i) {
+    const Entry &entry = table->entries[i];
+    if (entry.object_id == 0)
+      continue;
+
+    Entry *new_entry = Probe(new_table, entry.name.data(), entry.name.size(),
+                             entry.hash);
+    new_entry->hash = entry.hash;
+    new_entry->name = entry.name;
+    new_entry->object_id = entry.object_id;
+  }
+
+  AtomicExchangePointer(&table_, new_table);
+  retired_tables_.push_back(table);
+}
+
+} // namespace
@@ -0,0 +1,80 @@
+#if !defined(NANO_RPC_RPC_SERVICE_REGISTRY_HPP__)
+#define NANO_RPC_RPC_SERVICE_REGISTRY_HPP__
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "basictypes.hpp"
+#include "rpc_object_table.hpp"
+
+namespace NanoRpc {
+
+// Maps the service names to the object ids of the services.
+//
+// Open-addressed hash table with linear probing. The names are hashed and
+// compared in place, so the lookup does not allocate.
+//
+// The services are never removed, so the entry, once published, stays
+// where it is. The lookups take no locks and do not wait; the table that
+// outgrew its capacity is replaced with the bigger one and kept until the
+// registry is destroyed, for the lookups that may still be reading it.
+// The lookups may run concurrently with one writer; the writers (Insert)
+// must be serialized by the caller.
+class RpcServiceRegistry {
+public:
+  typedef std::pair<std::string, RpcObjectId> Service;
+
+  RpcServiceRegistry();
+  ~RpcServiceRegistry();
+
+  static unsigned int Hash(const char *name, size_t length);
+
+  // Replaces the object id if the name is already registered.
+  void Insert(const std::string &name, RpcObjectId object_id);
+
+  // Returns 0 if there is no service with the name.
+  RpcObjectId Find(const char *name, size_t length) const;
+
+  // Appends all services to the vector.
+  void GetServices(std::vector<Service> *services) const;
+
+private:
+  static const size_t InitialCapacity = 16;
+
+  struct Entry {
+    Entry() : object_id(0), hash(0) {}
+
+    // Zero while the entry is free. Set after the name and the hash.
+    volatile long object_id;
+    unsigned int hash;
+    std::string name;
+  };
+
+  struct Table {
+    explicit Table(size_t capacity)
+        : entries(new Entry[capacity]), mask(capacity - 1) {}
+    ~Table() { delete[] entries; }
+
+    Entry *entries;
+    size_t mask;
+  };
+
+  // Returns the entry with the name, or the free entry the name goes to.
+  static Entry *Probe(Table *table, const char *name, size_t length,
+                      unsigned int hash);
+
+  void Grow();
+
+  Table *volatile table_;
+  size_t service_count_;
+
+  // Replaced tables, see the class comment.
+  std::vector<Table *> retired_tables_;
+
+  DISALLOW_COPY_AND_ASSIGN(RpcServiceRegistry);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_RPC_SERVICE_REGISTRY_HPP__
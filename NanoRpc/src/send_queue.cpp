@@ -0,0 +1,151 @@
+#include "send_queue.hpp"
+
+#include <cassert>
+#include <cstring>
+
+#include "atomic_operations.hpp"
+#include "buffer_chain_output_stream.hpp"
+
+namespace NanoRpc {
+
+SendQueue::SendQueue(BufferPool *buffer_pool)
+    : buffer_pool_(buffer_pool), head_(NULL), queued_bytes_(0),
+      max_write_size_(DefaultMaxWriteSize), flush_delay_(0),
+      frames_written_(0), writes_(0), bytes_written_(0) {
+  assert(buffer_pool_ != NULL);
+}
+
+SendQueue::~SendQueue() { Clear(); }
+
+bool SendQueue::Push(const google::protobuf::MessageLite &message) {
+  BufferChainOutputStream stream(buffer_pool_);
+  stream.WriteFrame(message);
+
+  size_t chunk_count = stream.GetChunkCount();
+  assert(chunk_count > 0);
+
+  // Link the chunks so the last one is first, then the whole frame is
+  // pushed with a single exchange and never interleaves with other frames.
+  Item *first = NULL;
+  Item *last = NULL;
+  for (size_t i = 0; i < chunk_count; ++i) {
+    const BufferChainOutputStream::Chunk &chunk = stream.GetChunk(i);
+    Item *item = item_pool_.Allocate();
+    item->buffer = chunk.buffer;
+    item->size = chunk.size;
+    item->is_frame_end = i == chunk_count - 1;
+    item->next = last;
+    last = item;
+    if (first == NULL)
+      first = item;
+  }
+  stream.Detach();
+
+  long frame_size = static_cast<long>(stream.ByteCount());
+  long queued_bytes = AtomicExchangeAdd(&queued_bytes_, frame_size);
+
+  Item *head;
+  do {
+    head = head_;
+    first->next = head;
+  } while (AtomicCompareExchangePointer(&head_, last, head) != head);
+
+  // With the flush delay the I/O thread may be waiting for more data, wake
+  // it up once there is enough for a full write.
+  return head == NULL ||
+         (flush_delay_ > 0 && queued_bytes < max_write_size_ &&
+          queued_bytes + frame_size >= max_write_size_);
+}
+
+SendQueue::Item *SendQueue::TakeAll() {
+  Item *items = AtomicExchangePointer<Item>(&head_, NULL);
+
+  // Restore the push order.
+  Item *ordered = NULL;
+  long taken_bytes = 0;
+  while (items != NULL) {
+    Item *next = items->next;
+    taken_bytes += items->size;
+    items->next = ordered;
+    ordered = items;
+    items = next;
+  }
+
+  AtomicExchangeAdd(&queued_bytes_, -taken_bytes);
+  return ordered;
+}
+
+bool SendQueue::GetNextWrite(Item **items, char **buffer, int *size) {
+  assert(items != NULL);
+
+  Item *item = *items;
+  if (item == NULL)
+    return false;
+
+  // Find out how many items fit into a single write.
+  int total_size = 0;
+  int frames = 0;
+  Item *end = item;
+  while (end != NULL && total_size + end->size <= max_write_size_) {
+    total_size += end->size;
+    frames += end->is_frame_end ? 1 : 0;
+    end = end->next;
+  }
+
+  if (end == item || end == item->next) {
+    // Single item, no need to copy it.
+    *buffer = item->buffer;
+    *size = item->size;
+    *items = item->next;
+    RecordWrite(item->is_frame_end ? 1 : 0, item->size);
+    item_pool_.Deallocate(item);
+    return true;
+  }
+
+  char *write_buffer = buffer_pool_->Allocate(total_size);
+  int offset = 0;
+  while (item != end) {
+    Item *next = item->next;
+    memcpy(write_buffer + offset, item->buffer, item->size);
+    offset += item->size;
+    FreeItem(item);
+    item = next;
+  }
+
+  *items = end;
+  *buffer = write_buffer;
+  *size = total_size;
+  RecordWrite(frames, total_size);
+  return true;
+}
+
+void SendQueue::FreeItems(Item *items) {
+  while (items != NULL) {
+    Item *next = items->next;
+    FreeItem(items);
+    items = next;
+  }
+}
+
+void SendQueue::Clear() { FreeItems(TakeAll()); }
+
+void SendQueue::RecordWrite(int frames, int bytes) {
+  frames_written_ = frames_written_ + frames;
+  writes_ = writes_ + 1;
+  bytes_written_ = bytes_written_ + bytes;
+}
+
+void SendQueue::GetStatistics(Statistics *statistics) const {
+  assert(statistics != NULL);
+  statistics->frames = frames_written_;
+  statistics->writes = writes_;
+  statistics->bytes = bytes_written_;
+}
+
+void SendQueue::FreeItem(Item *item) {
+  if (item->buffer != NULL)
+    buffer_pool_->Deallocate(item->buffer);
+  item_pool_.Deallocate(item);
+}
+
+} // namespace
@@ -0,0 +1,116 @@
+#if !defined(NANO_RPC_SEND_QUEUE_HPP__)
+#define NANO_RPC_SEND_QUEUE_HPP__
+
+#include <google/protobuf/message_lite.h>
+
+#include "basictypes.hpp"
+#include "buffer_pool.hpp"
+#include "object_pool.hpp"
+
+namespace NanoRpc {
+
+// Queue of outgoing frames with multiple producers and a single consumer,
+// the channel's I/O thread.
+//
+// Senders serialize the message and push it without waiting for any I/O.
+// The I/O thread takes everything queued since the last flush at once and
+// packs it into as few writes as possible, so a burst of small messages
+// (e.g. events) costs one write instead of one per message.
+//
+// The flush policy is controlled by two knobs: the maximum size of a
+// single write and the delay the I/O thread may wait for more frames
+// before it flushes a write that is not full yet. With zero delay (the
+// default) the queue is flushed as soon as the I/O thread gets to it,
+// which coalesces only the frames that arrive while it is busy.
+class SendQueue {
+public:
+  // Part of the frame. Big frames are split into several items.
+  struct Item {
+    Item *next;
+    char *buffer;
+    int size;
+    bool is_frame_end;
+  };
+
+  struct Statistics {
+    long frames;
+    long writes;
+    long bytes;
+  };
+
+  static const int DefaultMaxWriteSize = 64 * 1024;
+
+  explicit SendQueue(BufferPool *buffer_pool);
+  ~SendQueue();
+
+  int get_max_write_size() const { return max_write_size_; }
+  void set_max_write_size(int max_write_size) {
+    max_write_size_ = max_write_size;
+  }
+
+  // Milliseconds.
+  unsigned int get_flush_delay() const { return flush_delay_; }
+  void set_flush_delay(unsigned int flush_delay) {
+    flush_delay_ = flush_delay;
+  }
+
+  // Serializes the message and appends it to the queue. May be called from
+  // any thread.
+  // Returns true if the I/O thread should be woken up, i.e. the queue was
+  // empty or it has grown over the maximum write size.
+  bool Push(const google::protobuf::MessageLite &message);
+
+  bool IsEmpty() const { return head_ == NULL; }
+
+  // Returns true if there is enough data for a full write, so the flush
+  // should not be delayed.
+  bool IsFull() const { return queued_bytes_ >= max_write_size_; }
+
+  // Takes all queued items in the order they were pushed.
+  // Must be called from the I/O thread.
+  Item *TakeAll();
+
+  // Builds the next write out of the taken items and advances the list.
+  // Consecutive items are copied into one buffer of at most the maximum
+  // write size; an item that does not fit is returned as is. The returned
+  // buffer is allocated from the pool and the caller owns it.
+  // Returns false if the list is empty.
+  bool GetNextWrite(Item **items, char **buffer, int *size);
+
+  // Frees the items and their buffers. The caller may take over a buffer by
+  // setting it to NULL in the item.
+  void FreeItems(Item *items);
+
+  // Drops everything queued.
+  void Clear();
+
+  // Accounts a write. GetNextWrite does it already, consumers that write
+  // the items directly (e.g. with a gather write) call it themselves.
+  void RecordWrite(int frames, int bytes);
+
+  void GetStatistics(Statistics *statistics) const;
+
+private:
+  void FreeItem(Item *item);
+
+  BufferPool *buffer_pool_;
+  ObjectPool<Item> item_pool_;
+
+  // Last pushed item. The list is linked towards the older items.
+  Item *volatile head_;
+  volatile long queued_bytes_;
+
+  int max_write_size_;
+  unsigned int flush_delay_;
+
+  // Updated by the I/O thread only.
+  volatile long frames_written_;
+  volatile long writes_;
+  volatile long bytes_written_;
+
+  DISALLOW_COPY_AND_ASSIGN(SendQueue);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_SEND_QUEUE_HPP__
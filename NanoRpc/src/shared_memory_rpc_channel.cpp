@@ -0,0 +1,499 @@
+// Each ring is a single-producer/single-consumer queue of records. A record
+// is the 4-byte message length followed by the serialized message, padded to
+// the 4-byte boundary. Records never wrap around the end of the ring; if the
+// record does not fit into the tail, the producer writes a wrap marker and
+// starts from the beginning of the ring.
+//
+// The read and write positions are free running 32-bit counters, so the
+// ring size must be the power of two.
+
+#include "shared_memory_rpc_channel.hpp"
+
+#include <cassert>
+#include <climits>
+#include <cstring>
+#include <iostream>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rpc_controller.hpp"
+
+namespace NanoRpc {
+
+namespace {
+
+const uint32_t SegmentMagic = 0x4350524E;  // "NRPC"
+const int CacheLineSize = 64;
+const int MinRingSize = 4096;
+
+const int32_t WrapMarker = -1;
+
+// Number of polls of the ring before the receiving side goes to sleep.
+const int SpinCount = 2000;
+
+// The futex waits are bounded, so the peer that died without marking the
+// segment closed is eventually noticed.
+const int WaitTimeout = 100;
+
+uint32_t AlignRecordSize(uint32_t size) { return (size + 3) & ~3u; }
+
+int FutexWait(volatile uint32_t *address, uint32_t expected, int timeout) {
+  timespec wait_time;
+  wait_time.tv_sec = timeout / 1000;
+  wait_time.tv_nsec = (timeout % 1000) * 1000000;
+  return static_cast<int>(syscall(SYS_futex, address, FUTEX_WAIT, expected,
+                                  &wait_time, NULL, 0));
+}
+
+void FutexWake(volatile uint32_t *address) {
+  syscall(SYS_futex, address, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+bool IsProcessAlive(pid_t pid) {
+  return pid == 0 || kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+std::string MakeSegmentName(const char *name) {
+  std::string segment_name = name == NULL ? "" : name;
+  if (segment_name.empty() || segment_name[0] != '/')
+    segment_name.insert(0, "/");
+  return segment_name;
+}
+
+} // namespace
+
+// The producer and consumer fields live on separate cache lines, so the two
+// processes do not fight over the same line on every message.
+struct SharedMemoryRing {
+  volatile uint32_t write_position;
+  volatile uint32_t consumer_waiting;
+  char padding0[CacheLineSize - 2 * sizeof(uint32_t)];
+  volatile uint32_t read_position;
+  volatile uint32_t producer_waiting;
+  char padding1[CacheLineSize - 2 * sizeof(uint32_t)];
+};
+
+// Ring 0 carries messages from server to client, ring 1 the other way.
+// The ring data follows the header in the same order.
+struct SharedMemorySegmentHeader {
+  volatile uint32_t magic;
+  uint32_t ring_size;
+  volatile uint32_t server_closed;
+  volatile uint32_t client_closed;
+  volatile pid_t server_pid;
+  volatile pid_t client_pid;
+  char padding[CacheLineSize - 4 * sizeof(uint32_t) - 2 * sizeof(pid_t)];
+  SharedMemoryRing rings[2];
+};
+
+SharedMemorySegment::SharedMemorySegment(const char *name, bool is_server_side,
+                                         void *memory, size_t size)
+    : name_(name), is_server_side_(is_server_side), memory_(memory),
+      size_(size),
+      header_(reinterpret_cast<SharedMemorySegmentHeader *>(memory)) {}
+
+SharedMemorySegment::~SharedMemorySegment() {
+  munmap(memory_, size_);
+  if (is_server_side_)
+    shm_unlink(name_.c_str());
+}
+
+SharedMemorySegment *SharedMemorySegment::Create(const char *name,
+                                                 int ring_size) {
+  uint32_t size = MinRingSize;
+  while (static_cast<int>(size) < ring_size && size < (1u << 30))
+    size <<= 1;
+
+  std::string segment_name = MakeSegmentName(name);
+  int fd = shm_open(segment_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd == -1)
+    return NULL;
+
+  size_t total_size = sizeof(SharedMemorySegmentHeader) + 2 * size;
+  void *memory = MAP_FAILED;
+  if (ftruncate(fd, total_size) == 0) {
+    memory = mmap(NULL, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+
+  if (memory == MAP_FAILED) {
+    shm_unlink(segment_name.c_str());
+    return NULL;
+  }
+
+  // The memory is zero filled by ftruncate, so positions and flags are
+  // already initialized.
+  SharedMemorySegmentHeader *header =
+      reinterpret_cast<SharedMemorySegmentHeader *>(memory);
+  header->ring_size = size;
+  header->server_pid = getpid();
+  __atomic_store_n(&header->magic, SegmentMagic, __ATOMIC_RELEASE);
+
+  return new SharedMemorySegment(segment_name.c_str(), true, memory,
+                                 total_size);
+}
+
+SharedMemorySegment *SharedMemorySegment::Open(const char *name) {
+  std::string segment_name = MakeSegmentName(name);
+  int fd = shm_open(segment_name.c_str(), O_RDWR, 0);
+  if (fd == -1)
+    return NULL;
+
+  struct stat info;
+  void *memory = MAP_FAILED;
+  if (fstat(fd, &info) == 0 &&
+      info.st_size > static_cast<off_t>(sizeof(SharedMemorySegmentHeader))) {
+    memory = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                  0);
+  }
+  close(fd);
+
+  if (memory == MAP_FAILED)
+    return NULL;
+
+  SharedMemorySegmentHeader *header =
+      reinterpret_cast<SharedMemorySegmentHeader *>(memory);
+  if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SegmentMagic ||
+      sizeof(SharedMemorySegmentHeader) + 2 * header->ring_size !=
+          static_cast<size_t>(info.st_size)) {
+    munmap(memory, info.st_size);
+    return NULL;
+  }
+
+  // The rings have a single producer and a single consumer each, the
+  // segment takes one client only.
+  if (__sync_val_compare_and_swap(&header->client_pid, 0, getpid()) != 0) {
+    munmap(memory, info.st_size);
+    return NULL;
+  }
+
+  return new SharedMemorySegment(segment_name.c_str(), false, memory,
+                                 info.st_size);
+}
+
+int SharedMemorySegment::get_ring_size() const {
+  return static_cast<int>(header_->ring_size);
+}
+
+SharedMemoryRing *SharedMemorySegment::get_send_ring() const {
+  return &header_->rings[is_server_side_ ? 0 : 1];
+}
+
+SharedMemoryRing *SharedMemorySegment::get_receive_ring() const {
+  return &header_->rings[is_server_side_ ? 1 : 0];
+}
+
+char *SharedMemorySegment::get_send_ring_data() const {
+  char *data = reinterpret_cast<char *>(header_ + 1);
+  return is_server_side_ ? data : data + header_->ring_size;
+}
+
+char *SharedMemorySegment::get_receive_ring_data() const {
+  char *data = reinterpret_cast<char *>(header_ + 1);
+  return is_server_side_ ? data + header_->ring_size : data;
+}
+
+void SharedMemorySegment::MarkClosed() {
+  if (is_server_side_)
+    __atomic_store_n(&header_->server_closed, 1, __ATOMIC_SEQ_CST);
+  else
+    __atomic_store_n(&header_->client_closed, 1, __ATOMIC_SEQ_CST);
+
+  // Wake up both sides of both rings, so whoever sleeps notices the flag.
+  for (int i = 0; i < 2; ++i) {
+    FutexWake(&header_->rings[i].write_position);
+    FutexWake(&header_->rings[i].read_position);
+  }
+}
+
+bool SharedMemorySegment::IsPeerClosed() const {
+  if (is_server_side_) {
+    return header_->client_closed != 0 || !IsProcessAlive(header_->client_pid);
+  } else {
+    return header_->server_closed != 0 || !IsProcessAlive(header_->server_pid);
+  }
+}
+
+SharedMemoryRpcChannel::SharedMemoryRpcChannel(RpcController *controller,
+                                               SharedMemorySegment *segment)
+    : RpcChannel(controller), segment_(segment), has_receive_thread_(false),
+      disconnected_callback_(NULL), is_connected_(NotConnected) {
+  assert(segment_ != NULL);
+}
+
+SharedMemoryRpcChannel::~SharedMemoryRpcChannel() {
+  Close();
+  Detach();
+
+  // Not before, the receive thread that closed the channel from a handler
+  // may still be on its way out of the ring, and so may be the senders.
+  delete segment_;
+}
+
+bool SharedMemoryRpcChannel::Start() {
+  if (__sync_val_compare_and_swap(&is_connected_, NotConnected, Connected) !=
+      NotConnected)
+    return true;
+
+  if (pthread_create(&receive_thread_, NULL, &ReceiveThreadProcThunk, this) !=
+      0) {
+    __sync_lock_test_and_set(&is_connected_, NotConnected);
+    return false;
+  }
+
+  has_receive_thread_ = true;
+  return true;
+}
+
+void SharedMemoryRpcChannel::Close() {
+  int was = __sync_lock_test_and_set(&is_connected_, Disconnected);
+  if (was != Disconnected) {
+    CloseConnection();
+    ReceiveChannelFailure();
+  }
+}
+
+void SharedMemoryRpcChannel::Send(const RpcMessage &message) {
+  bool is_written;
+  {
+    // The segment stays mapped until the channel is destroyed, but the
+    // closed channel does not write into it any more. Checked under the
+    // lock, which CloseConnection takes too.
+    ScopedLock lock(send_lock_);
+    if (is_connected_ != Connected)
+      return; // TODO: false;
+
+    is_written = WriteMessage(message);
+  }
+
+  // The message is lost, so the calls waiting for the results are failed
+  // with the connection rather than left waiting. Not under the lock,
+  // closing the connection takes it.
+  if (!is_written)
+    HandleSurpriseDisconnect();
+}
+
+bool SharedMemoryRpcChannel::WriteMessage(const RpcMessage &message) {
+  int message_size = message.ByteSize();
+  uint32_t record_size = AlignRecordSize(message_size + sizeof(int32_t));
+
+  // Limit the record to the half of the ring, so it always fits after
+  // the wrap marker.
+  uint32_t ring_size = segment_->get_ring_size();
+  if (record_size > ring_size / 2) {
+    std::cout << "error: Message of " << message_size
+              << " bytes does not fit into the shared memory ring\n";
+    std::cout.flush();
+    return false;
+  }
+
+  SharedMemoryRing *ring = segment_->get_send_ring();
+  char *data = segment_->get_send_ring_data();
+
+  uint32_t write_position = ring->write_position;
+  uint32_t offset = write_position & (ring_size - 1);
+  uint32_t tail_size = ring_size - offset;
+  uint32_t space = record_size > tail_size ? tail_size + record_size
+                                           : record_size;
+
+  if (!WaitForSpace(write_position, space)) {
+    std::cout << "error: Peer disconnected while waiting for ring space\n";
+    std::cout.flush();
+    return false;
+  }
+
+  if (record_size > tail_size) {
+    memcpy(data + offset, &WrapMarker, sizeof(WrapMarker));
+    write_position += tail_size;
+    offset = 0;
+  }
+
+  int32_t prefix = message_size;
+  memcpy(data + offset, &prefix, sizeof(prefix));
+  message.SerializeWithCachedSizesToArray(
+      reinterpret_cast<google::protobuf::uint8 *>(data + offset +
+                                                  sizeof(prefix)));
+
+  __atomic_store_n(&ring->write_position, write_position + record_size,
+                   __ATOMIC_RELEASE);
+
+  // Pairs with the fence in the receive thread; either we see the flag or
+  // the consumer sees the new position before it goes to sleep.
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (ring->consumer_waiting != 0)
+    FutexWake(&ring->write_position);
+  return true;
+}
+
+bool SharedMemoryRpcChannel::WaitForSpace(uint32_t write_position,
+                                          uint32_t space) {
+  SharedMemoryRing *ring = segment_->get_send_ring();
+  uint32_t ring_size = segment_->get_ring_size();
+
+  for (int spin = 0;; ++spin) {
+    uint32_t read_position =
+        __atomic_load_n(&ring->read_position, __ATOMIC_ACQUIRE);
+    if (ring_size - (write_position - read_position) >= space)
+      return true;
+
+    if (is_connected_ != Connected || segment_->IsPeerClosed())
+      return false;
+
+    if (spin < SpinCount)
+      continue;
+
+    __atomic_store_n(&ring->producer_waiting, 1, __ATOMIC_SEQ_CST);
+    read_position = __atomic_load_n(&ring->read_position, __ATOMIC_SEQ_CST);
+    if (ring_size - (write_position - read_position) < space)
+      FutexWait(&ring->read_position, read_position, WaitTimeout);
+    __atomic_store_n(&ring->producer_waiting, 0, __ATOMIC_RELAXED);
+  }
+}
+
+bool SharedMemoryRpcChannel::ReceiveAvailableMessages() {
+  SharedMemoryRing *ring = segment_->get_receive_ring();
+  char *data = segment_->get_receive_ring_data();
+  uint32_t ring_size = segment_->get_ring_size();
+
+  uint32_t read_position = ring->read_position;
+  uint32_t write_position =
+      __atomic_load_n(&ring->write_position, __ATOMIC_ACQUIRE);
+
+  while (read_position != write_position && is_connected_ == Connected) {
+    uint32_t offset = read_position & (ring_size - 1);
+
+    int32_t message_size;
+    memcpy(&message_size, data + offset, sizeof(message_size));
+    if (message_size == WrapMarker) {
+      read_position += ring_size - offset;
+      continue;
+    }
+
+    uint32_t record_size = AlignRecordSize(message_size + sizeof(int32_t));
+    if (message_size < 0 || record_size > ring_size - offset) {
+      std::cout << "error: Malformed record in the shared memory ring\n";
+      return false;
+    }
+
+    RpcMessage message;
+    bool parsed =
+        message.ParseFromArray(data + offset + sizeof(int32_t), message_size);
+
+    // Give the space back to the producer before the message is handled.
+    read_position += record_size;
+    __atomic_store_n(&ring->read_position, read_position, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (ring->producer_waiting != 0)
+      FutexWake(&ring->read_position);
+
+    if (!parsed) {
+      std::cout << "error: Failed to parse incoming message\n";
+      return false;
+    }
+
+    // TODO: Without the worker pool the calls block the receive thread, so
+    // a native client that makes a synchronous call while handling an event
+    // would lock up.
+    Receive(message);
+
+    // The handler may have closed the channel, the ring is not ours then.
+    if (is_connected_ != Connected)
+      return true;
+
+    if (read_position == write_position)
+      write_position = __atomic_load_n(&ring->write_position, __ATOMIC_ACQUIRE);
+  }
+
+  // Wrap markers are skipped without publishing, so publish the final
+  // position here.
+  if (is_connected_ == Connected)
+    __atomic_store_n(&ring->read_position, read_position, __ATOMIC_RELEASE);
+  return true;
+}
+
+int SharedMemoryRpcChannel::ReceiveThreadProc() {
+  SharedMemoryRing *ring = segment_->get_receive_ring();
+
+  int idle_polls = 0;
+  while (is_connected_ == Connected) {
+    uint32_t read_position = ring->read_position;
+    if (__atomic_load_n(&ring->write_position, __ATOMIC_ACQUIRE) !=
+        read_position) {
+      if (!ReceiveAvailableMessages()) {
+        HandleSurpriseDisconnect();
+        break;
+      }
+      idle_polls = 0;
+      continue;
+    }
+
+    if (++idle_polls < SpinCount)
+      continue;
+
+    // Announce that we are about to sleep, then check the ring once more.
+    __atomic_store_n(&ring->consumer_waiting, 1, __ATOMIC_SEQ_CST);
+    uint32_t write_position =
+        __atomic_load_n(&ring->write_position, __ATOMIC_SEQ_CST);
+    if (write_position == read_position) {
+      if (segment_->IsPeerClosed()) {
+        __atomic_store_n(&ring->consumer_waiting, 0, __ATOMIC_RELAXED);
+        std::cout << "Shared memory peer disconnected\n";
+        HandleSurpriseDisconnect();
+        break;
+      }
+      FutexWait(&ring->write_position, write_position, WaitTimeout);
+    }
+    __atomic_store_n(&ring->consumer_waiting, 0, __ATOMIC_RELAXED);
+    idle_polls = 0;
+  }
+
+  return 0;
+}
+
+void SharedMemoryRpcChannel::CloseConnection() {
+  assert(segment_ != NULL);
+
+  // Wakes up our own receive thread as well as the peer.
+  segment_->MarkClosed();
+
+  if (has_receive_thread_) {
+    if (pthread_equal(pthread_self(), receive_thread_))
+      pthread_detach(receive_thread_);
+    else
+      pthread_join(receive_thread_, NULL);
+    has_receive_thread_ = false;
+  }
+
+  // Wait for the sender that may still be writing into the ring, the
+  // later ones see the channel closed. The segment itself is deleted by the
+  // destructor.
+  ScopedLock lock(send_lock_);
+}
+
+void SharedMemoryRpcChannel::HandleSurpriseDisconnect() {
+  // We can get here from multiple points, but only one should be allowed to do
+  // the work.
+  if (__sync_val_compare_and_swap(&is_connected_, Connected, Disconnected) ==
+      Connected) {
+    CloseConnection();
+    ReceiveChannelFailure();
+    InvokeDisconnectedCallback();
+  }
+}
+
+void SharedMemoryRpcChannel::InvokeDisconnectedCallback() {
+  if (disconnected_callback_ != NULL) {
+    SharedMemoryRpcChannel *channel = this;
+    disconnected_callback_->Invoke(channel);
+  }
+}
+
+} // namespace
@@ -0,0 +1,156 @@
+#if !defined(NANO_RPC_SHARED_MEMORY_RPC_CHANNEL_HPP__)
+#define NANO_RPC_SHARED_MEMORY_RPC_CHANNEL_HPP__
+
+#include <string>
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "RpcMessageTypes.pb.h"
+
+#include "rpc_channel.hpp"
+#include "basictypes.hpp"
+#include "callback.hpp"
+#include "synchronization_primitives.hpp"
+
+namespace NanoRpc {
+
+struct SharedMemoryRing;
+struct SharedMemorySegmentHeader;
+
+// Named shared memory segment that holds a pair of single-producer/
+// single-consumer ring buffers, one per direction.
+//
+// The server side creates the segment and the client side opens it by the
+// same name. The segment is removed from the namespace when the server side
+// object is destroyed; mappings that are still open stay valid.
+//
+// This implementation is only available on Linux.
+class SharedMemorySegment {
+public:
+  static const int DefaultRingSize = 1024 * 1024;
+
+  ~SharedMemorySegment();
+
+  // Creates new segment. The ring size is rounded up to the power of two.
+  // Returns NULL if segment cannot be created (e.g. it already exists).
+  static SharedMemorySegment *Create(const char *name,
+                                     int ring_size = DefaultRingSize);
+
+  // Opens segment created by the server. Returns NULL if the segment does not
+  // exist yet or another client has already opened it.
+  static SharedMemorySegment *Open(const char *name);
+
+  bool is_server_side() const { return is_server_side_; }
+  const std::string &get_name() const { return name_; }
+
+  int get_ring_size() const;
+
+  // The ring this side writes to and the ring it reads from.
+  SharedMemoryRing *get_send_ring() const;
+  SharedMemoryRing *get_receive_ring() const;
+
+  char *get_send_ring_data() const;
+  char *get_receive_ring_data() const;
+
+  // Marks this side as gone, so the peer notices the disconnect.
+  void MarkClosed();
+  bool IsPeerClosed() const;
+
+private:
+  SharedMemorySegment(const char *name, bool is_server_side, void *memory,
+                      size_t size);
+
+  std::string name_;
+  bool is_server_side_;
+  void *memory_;
+  size_t size_;
+  SharedMemorySegmentHeader *header_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedMemorySegment);
+};
+
+// Channel that exchanges messages with the co-located peer through shared
+// memory instead of the kernel.
+//
+// Messages are serialized directly into the send ring and parsed in place
+// from the receive ring. The records keep the 4-byte length prefix framing
+// of the stream channels. The peer is woken up through a futex only if it
+// announced that it is about to sleep, so the steady state exchange between
+// busy processes does not involve system calls at all.
+//
+// The message takes at most the half of the ring, the larger one fails the
+// connection, so the ring size should fit the largest message expected.
+//
+// The channel takes ownership of the segment and keeps it mapped until it
+// is destroyed, the closed channel just stops touching it.
+//
+// This implementation is only available on Linux.
+class SharedMemoryRpcChannel : public RpcChannel {
+public:
+  SharedMemoryRpcChannel(RpcController *controller,
+                         SharedMemorySegment *segment);
+  ~SharedMemoryRpcChannel();
+
+  virtual bool Start();
+  virtual void Close();
+
+  void set_disconnected_callback(
+      CallbackBase<SharedMemoryRpcChannel *> *callback) {
+    disconnected_callback_ = callback;
+  }
+  CallbackBase<SharedMemoryRpcChannel *> *get_disconnected_callback() {
+    return disconnected_callback_;
+  }
+
+protected:
+  virtual void Send(const RpcMessage &message);
+
+private:
+  enum ChannelState { NotConnected = 0, Connected = 1, Disconnected = 2 };
+
+  int ReceiveThreadProc();
+
+  static void *ReceiveThreadProcThunk(void *parameter) {
+    SharedMemoryRpcChannel *channel =
+        reinterpret_cast<SharedMemoryRpcChannel *>(parameter);
+    channel->ReceiveThreadProc();
+    return NULL;
+  }
+
+  // Writes the message into the send ring. Must be called with send_lock_
+  // held. Returns false if the message is too large for the ring or the
+  // peer got disconnected meanwhile.
+  bool WriteMessage(const RpcMessage &message);
+
+  // Waits until the send ring has the requested amount of free space.
+  // Returns false if the channel got disconnected meanwhile.
+  bool WaitForSpace(uint32_t write_position, uint32_t space);
+
+  // Dispatches all messages available in the receive ring.
+  // Returns false if a malformed record was found.
+  bool ReceiveAvailableMessages();
+
+  void CloseConnection();
+
+  void HandleSurpriseDisconnect();
+
+  void InvokeDisconnectedCallback();
+
+  SharedMemorySegment *segment_;
+  pthread_t receive_thread_;
+  bool has_receive_thread_;
+
+  // Serializes producers, the ring itself supports a single one.
+  Lock send_lock_;
+
+  CallbackBase<SharedMemoryRpcChannel *> *disconnected_callback_;
+
+  volatile int is_connected_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedMemoryRpcChannel);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_SHARED_MEMORY_RPC_CHANNEL_HPP__
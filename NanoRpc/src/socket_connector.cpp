@@ -0,0 +1,232 @@
+#include "socket_connector.hpp"
+
+#include <cassert>
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace NanoRpc {
+
+namespace {
+
+// Interval between attempts to connect to the server socket.
+const int ClientPollInterval = 100;
+
+} // namespace
+
+SocketConnector::SocketConnector()
+    : is_connecting_(0), is_client_side_connection_(false),
+      listen_socket_(-1), stop_event_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      active_threads_(0), callback_(NULL) {}
+
+SocketConnector::~SocketConnector() {
+  // Normally the derived class has already done this.
+  Shutdown();
+
+  if (stop_event_ != -1)
+    close(stop_event_);
+}
+
+void SocketConnector::Shutdown() {
+  StopConnection();
+
+  // Waiting threads notice the stop event within a poll interval.
+  while (active_threads_ != 0)
+    usleep(ClientPollInterval * 1000);
+
+  if (listen_socket_ != -1) {
+    CloseListeningSocket(listen_socket_);
+    listen_socket_ = -1;
+  }
+}
+
+void SocketConnector::CloseListeningSocket(int socket) { close(socket); }
+
+bool SocketConnector::StartConnection(bool client_side) {
+  if (__sync_val_compare_and_swap(&is_connecting_, 0, 1) == 0) {
+    uint64_t value;
+    while (read(stop_event_, &value, sizeof(value)) > 0) {
+    }
+
+    is_client_side_connection_ = client_side;
+    if (client_side)
+      return StartClientConnection();
+    else
+      return StartServerConnection();
+  } else {
+    return client_side == is_client_side_connection_;
+  }
+}
+
+void SocketConnector::StopConnection() {
+  uint64_t value = 1;
+  if (write(stop_event_, &value, sizeof(value)) == -1)
+    assert(false);
+}
+
+void *SocketConnector::WaitForClientThreadProcThunk(void *parameter) {
+  assert(parameter != NULL);
+  SocketConnector *connector = reinterpret_cast<SocketConnector *>(parameter);
+  connector->WaitForClientThreadProc();
+  __sync_fetch_and_sub(&connector->active_threads_, 1);
+  return NULL;
+}
+
+void *SocketConnector::WaitForServerThreadProcThunk(void *parameter) {
+  assert(parameter != NULL);
+  SocketConnector *connector = reinterpret_cast<SocketConnector *>(parameter);
+  connector->WaitForServerThreadProc();
+  __sync_fetch_and_sub(&connector->active_threads_, 1);
+  return NULL;
+}
+
+bool SocketConnector::StartServerConnection() {
+  assert(HasAddress());
+
+  if (!HasAddress()) {
+    __sync_lock_test_and_set(&is_connecting_, 0);
+    return false;
+  }
+
+  if (listen_socket_ == -1) {
+    listen_socket_ = CreateListeningSocket();
+    if (listen_socket_ == -1) {
+      __sync_lock_test_and_set(&is_connecting_, 0);
+      return false;
+    }
+  }
+
+  // Try to pick up client that is already waiting and avoid starting a
+  // new thread.
+  int socket = AttemptAcceptClient();
+  if (socket != -1) {
+    __sync_lock_test_and_set(&is_connecting_, 0);
+    InvokeConnectedCallback(socket);
+    return true;
+  }
+
+  return StartWaitingThread(&WaitForClientThreadProcThunk);
+}
+
+bool SocketConnector::StartClientConnection() {
+  assert(HasAddress());
+
+  if (!HasAddress()) {
+    __sync_lock_test_and_set(&is_connecting_, 0);
+    return false;
+  }
+
+  // First try to see if we can connect immediately and
+  // avoid spanning a new thread.
+  int socket = AttemptConnectToServer();
+  if (socket != -1) {
+    __sync_lock_test_and_set(&is_connecting_, 0);
+    InvokeConnectedCallback(socket);
+    return true;
+  }
+
+  return StartWaitingThread(&WaitForServerThreadProcThunk);
+}
+
+bool SocketConnector::StartWaitingThread(void *(*thread_proc)(void *)) {
+  __sync_fetch_and_add(&active_threads_, 1);
+
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, thread_proc, this) != 0) {
+    __sync_fetch_and_sub(&active_threads_, 1);
+    __sync_lock_test_and_set(&is_connecting_, 0);
+    return false;
+  }
+
+  pthread_detach(thread);
+
+  // We do not change is_connecting_ here, because we are still pending the
+  // connection asynchronously in the other thread.
+  return true;
+}
+
+int SocketConnector::WaitForClientThreadProc() {
+  while (true) {
+    pollfd fds[2];
+    fds[0].fd = listen_socket_;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = stop_event_;
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+
+    int result = poll(fds, arraysize(fds), -1);
+    if (result == -1 && errno != EINTR) {
+      __sync_lock_test_and_set(&is_connecting_, 0);
+      break;
+    }
+
+    if (fds[1].revents & POLLIN) {
+      __sync_lock_test_and_set(&is_connecting_, 0);
+      break;
+    }
+
+    // The client could have gone away between poll and accept, so just
+    // go back to waiting in that case.
+    int socket = AttemptAcceptClient();
+    if (socket != -1) {
+      __sync_lock_test_and_set(&is_connecting_, 0);
+      InvokeConnectedCallback(socket);
+      break;
+    }
+  }
+
+  return 0;
+}
+
+int SocketConnector::WaitForServerThreadProc() {
+  while (true) {
+    int socket = AttemptConnectToServer();
+    if (socket != -1) {
+      __sync_lock_test_and_set(&is_connecting_, 0);
+      InvokeConnectedCallback(socket);
+      break;
+    }
+
+    if (WaitForStop(ClientPollInterval)) {
+      __sync_lock_test_and_set(&is_connecting_, 0);
+      break;
+    }
+  }
+
+  return 0;
+}
+
+int SocketConnector::AttemptAcceptClient() {
+  assert(listen_socket_ != -1);
+
+  int socket;
+  do {
+    socket = accept4(listen_socket_, NULL, NULL, SOCK_CLOEXEC);
+  } while (socket == -1 && errno == EINTR);
+
+  return socket;
+}
+
+bool SocketConnector::WaitForStop(int timeout) {
+  pollfd fd;
+  fd.fd = stop_event_;
+  fd.events = POLLIN;
+  fd.revents = 0;
+  return poll(&fd, 1, timeout) > 0 && (fd.revents & POLLIN) != 0;
+}
+
+void SocketConnector::InvokeConnectedCallback(int socket) {
+  assert(callback_ != NULL);
+  if (callback_ != NULL)
+    callback_->Connected(socket);
+  else
+    close(socket);
+}
+
+} // namespace
@@ -0,0 +1,119 @@
+#if !defined(NANO_RPC_SOCKET_CONNECTOR_HPP__)
+#define NANO_RPC_SOCKET_CONNECTOR_HPP__
+
+#include "basictypes.hpp"
+#include "synchronization_primitives.hpp"
+
+// The class facilitates stream socket connection sequence and mirrors
+// NamedPipeConnector. The address family specific parts are implemented by
+// UnixSocketConnector and TcpSocketConnector.
+// If in server mode, once started, it listens for incoming
+// connections and once client connected fires an event.
+// The handler code could start listening for more connections if needed.
+// The listening socket is kept open between connections, so clients that
+// connect while the handler runs are queued by the kernel.
+// If started in client mode, constantly polls for the server, and once
+// it is available, connects to it and fires an event.
+// The connected socket is compatible with SocketRpcChannel implementation.
+// The class does not own any connected sockets and it is client's
+// responsibility to close them.
+//
+// This implementation is only available on Linux.
+namespace NanoRpc {
+
+class SocketConnector {
+public:
+  class ICallback {
+  public:
+    virtual ~ICallback() {}
+    virtual void Connected(int socket) = 0;
+  };
+
+  SocketConnector();
+  virtual ~SocketConnector();
+
+  void set_callback(ICallback *callback) { callback_ = callback; }
+  ICallback *get_callback() { return callback_; }
+
+  // Attempts to connect to the socket.
+  //
+  // First it tries to do connection synchronously. If connection established,
+  // then callback is called from the same thread that called StartConnection.
+  // If synchronous attempt fails, the method starts a thread that waits for
+  // the connection and returns immediately. If asynchronous connection
+  // succeeds, the callback is called from that thread and once callback
+  // returns, the thread terminates.
+  // When callback called the socket is passed as an argument. The callback
+  // handler assumes ownership of the socket.
+  //
+  // If no connection is pending the method returns false if
+  // fatal error occurred while trying make initial connection.
+  //
+  // If connection is already pending and specified connection side is same as
+  // of the pending connection, then method returns true.
+  bool StartConnection(bool client_side = false);
+
+  // Cancels pending connection. The listening socket stays open until the
+  // connector is destroyed.
+  void StopConnection();
+
+  bool IsConnecting() const { return is_connecting_ != 0; }
+
+protected:
+  // Returns false if the connector lacks the address to connect to.
+  virtual bool HasAddress() const = 0;
+
+  // Returns bound non-blocking socket that listens for connections or -1.
+  virtual int CreateListeningSocket() = 0;
+
+  // Returns connected socket or -1 if server is not available.
+  virtual int AttemptConnectToServer() = 0;
+
+  virtual void CloseListeningSocket(int socket);
+
+  // Cancels pending connection, waits for the waiting thread to finish and
+  // closes the listening socket. Derived classes must call it from their
+  // destructor, because CloseListeningSocket is virtual.
+  void Shutdown();
+
+private:
+  static void *WaitForClientThreadProcThunk(void *parameter);
+  static void *WaitForServerThreadProcThunk(void *parameter);
+
+  // Returns false if failed to create listening socket.
+  bool StartServerConnection();
+
+  // Returns false if failed to setup polling for the server.
+  bool StartClientConnection();
+
+  bool StartWaitingThread(void *(*thread_proc)(void *));
+
+  int WaitForClientThreadProc();
+  int WaitForServerThreadProc();
+
+  // Returns connected socket or -1 if there is no client waiting.
+  int AttemptAcceptClient();
+
+  // Returns true if stop was requested while waiting.
+  bool WaitForStop(int timeout);
+
+  void InvokeConnectedCallback(int socket);
+
+  volatile int is_connecting_;
+  bool is_client_side_connection_;
+
+  int listen_socket_;
+  int stop_event_;
+
+  // Number of running waiting threads, so destructor does not pull
+  // the object from under them.
+  volatile int active_threads_;
+
+  ICallback *callback_;
+
+  DISALLOW_COPY_AND_ASSIGN(SocketConnector);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_SOCKET_CONNECTOR_HPP__
@@ -0,0 +1,458 @@
+// The socket is used in non-blocking mode and all I/O is done from the event
+// loop thread, except for writes that the socket accepts immediately. This
+// keeps the send path free of thread switches in the common case where the
+// socket send buffer is not full.
+
+#include "socket_rpc_channel.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rpc_controller.hpp"
+
+namespace NanoRpc {
+
+namespace {
+
+const int MaxEventsPerWait = 8;
+
+// Number of pending writes handed to a single sendmsg call.
+const int MaxWriteVectors = 64;
+
+bool IsWouldBlockError(int err) {
+  return err == EAGAIN || err == EWOULDBLOCK;
+}
+
+// Milliseconds, wraps around the same way as GetTickCount on Windows.
+unsigned int GetTickCount() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<unsigned int>(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+} // namespace
+
+SocketRpcChannel::SocketRpcChannel(RpcController *controller, int socket)
+    : RpcChannel(controller), socket_(socket), epoll_(-1), wakeup_event_(-1),
+      send_event_(-1), has_event_thread_(false), write_interest_(false),
+      cork_count_(0), send_queue_(&buffer_pool_), is_flush_scheduled_(false),
+      flush_scheduled_at_(0), frame_reader_(&buffer_pool_),
+      disconnected_callback_(NULL),
+      is_connected_(NotConnected) {}
+
+SocketRpcChannel::~SocketRpcChannel() {
+  Close();
+  Detach();
+}
+
+bool SocketRpcChannel::Start() {
+  if (__sync_val_compare_and_swap(&is_connected_, NotConnected, Connected) !=
+      NotConnected)
+    return true;
+
+  int flags = fcntl(socket_, F_GETFL, 0);
+  if (flags == -1 || fcntl(socket_, F_SETFL, flags | O_NONBLOCK) == -1) {
+    __sync_lock_test_and_set(&is_connected_, NotConnected);
+    return false;
+  }
+
+  // Fails for non-TCP sockets, which is fine.
+  SetNoDelay(true);
+
+  epoll_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_ == -1) {
+    __sync_lock_test_and_set(&is_connected_, NotConnected);
+    return false;
+  }
+
+  wakeup_event_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  send_event_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wakeup_event_ == -1 || send_event_ == -1) {
+    if (wakeup_event_ != -1)
+      close(wakeup_event_);
+    if (send_event_ != -1)
+      close(send_event_);
+    close(epoll_);
+    wakeup_event_ = -1;
+    send_event_ = -1;
+    epoll_ = -1;
+    __sync_lock_test_and_set(&is_connected_, NotConnected);
+    return false;
+  }
+
+  epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.fd = wakeup_event_;
+  bool registered =
+      epoll_ctl(epoll_, EPOLL_CTL_ADD, wakeup_event_, &event) == 0;
+
+  event.data.fd = send_event_;
+  registered =
+      registered && epoll_ctl(epoll_, EPOLL_CTL_ADD, send_event_, &event) == 0;
+
+  event.events = EPOLLIN | EPOLLRDHUP;
+  event.data.fd = socket_;
+  registered =
+      registered && epoll_ctl(epoll_, EPOLL_CTL_ADD, socket_, &event) == 0;
+
+  if (!registered || pthread_create(&event_thread_, NULL,
+                                    &EventLoopThreadProcThunk, this) != 0) {
+    close(wakeup_event_);
+    close(send_event_);
+    close(epoll_);
+    wakeup_event_ = -1;
+    send_event_ = -1;
+    epoll_ = -1;
+    __sync_lock_test_and_set(&is_connected_, NotConnected);
+    return false;
+  }
+
+  has_event_thread_ = true;
+  return true;
+}
+
+void SocketRpcChannel::Close() {
+  int was = __sync_lock_test_and_set(&is_connected_, Disconnected);
+  if (was != Disconnected) {
+    shutdown(socket_, SHUT_RDWR);
+    CloseConnection();
+    ReceiveChannelFailure();
+  }
+}
+
+bool SocketRpcChannel::SetNoDelay(bool no_delay) {
+  int value = no_delay ? 1 : 0;
+  return setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, &value,
+                    sizeof(value)) == 0;
+}
+
+void SocketRpcChannel::Cork() {
+  ScopedLock lock(write_lock_);
+  if (cork_count_++ == 0) {
+    int value = 1;
+    setsockopt(socket_, IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+  }
+}
+
+void SocketRpcChannel::Uncork() {
+  ScopedLock lock(write_lock_);
+  assert(cork_count_ > 0);
+  if (cork_count_ > 0 && --cork_count_ == 0) {
+    int value = 0;
+    setsockopt(socket_, IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+  }
+}
+
+void SocketRpcChannel::Send(const RpcMessage &message) {
+  if (is_connected_ != Connected)
+    return; // TODO: false;
+
+  // The message is written by the event loop together with whatever else
+  // gets queued meanwhile. The loop checks the queue after every wakeup, so
+  // it only needs to be signalled from other threads.
+  if (send_queue_.Push(message) && has_event_thread_ &&
+      !pthread_equal(pthread_self(), event_thread_)) {
+    uint64_t value = 1;
+    if (write(send_event_, &value, sizeof(value)) == -1)
+      std::cout << "warning: Failed to wake up the event loop.\n";
+  }
+}
+
+bool SocketRpcChannel::FlushSendQueueIfDue() {
+  if (send_queue_.IsEmpty()) {
+    is_flush_scheduled_ = false;
+    return true;
+  }
+
+  unsigned int now = GetTickCount();
+  unsigned int flush_delay = send_queue_.get_flush_delay();
+  if (flush_delay == 0 || send_queue_.IsFull() ||
+      (is_flush_scheduled_ && now - flush_scheduled_at_ >= flush_delay)) {
+    is_flush_scheduled_ = false;
+    return FlushSendQueue();
+  }
+
+  if (!is_flush_scheduled_) {
+    is_flush_scheduled_ = true;
+    flush_scheduled_at_ = now;
+  }
+  return true;
+}
+
+int SocketRpcChannel::GetFlushTimeout() const {
+  if (!is_flush_scheduled_)
+    return -1;
+
+  unsigned int elapsed = GetTickCount() - flush_scheduled_at_;
+  unsigned int flush_delay = send_queue_.get_flush_delay();
+  return elapsed >= flush_delay ? 0 : flush_delay - elapsed;
+}
+
+bool SocketRpcChannel::FlushSendQueue() {
+  ScopedLock lock(write_lock_);
+
+  for (SendQueue::Item *item = send_queue_.TakeAll(); item != NULL;) {
+    PendingWrite write = { item->buffer, item->size, 0, item->is_frame_end };
+    pending_writes_.push_back(write);
+
+    // The buffer now belongs to the pending write.
+    SendQueue::Item *next = item->next;
+    item->buffer = NULL;
+    item->next = NULL;
+    send_queue_.FreeItems(item);
+    item = next;
+  }
+
+  // If the socket is not writable, the loop picks the writes up once it
+  // becomes writable again.
+  return write_interest_ || FlushPendingWrites();
+}
+
+bool SocketRpcChannel::FlushPendingWrites() {
+  while (!pending_writes_.empty()) {
+    iovec vectors[MaxWriteVectors];
+    int vector_count = 0;
+    for (std::deque<PendingWrite>::const_iterator iter =
+             pending_writes_.begin();
+         iter != pending_writes_.end() && vector_count < MaxWriteVectors;
+         ++iter) {
+      vectors[vector_count].iov_base = iter->buffer + iter->offset;
+      vectors[vector_count].iov_len = iter->size - iter->offset;
+      ++vector_count;
+    }
+
+    msghdr header;
+    memset(&header, 0, sizeof(header));
+    header.msg_iov = vectors;
+    header.msg_iovlen = vector_count;
+
+    ssize_t written = sendmsg(socket_, &header, MSG_NOSIGNAL);
+    if (written == -1) {
+      if (errno == EINTR)
+        continue;
+      if (IsWouldBlockError(errno)) {
+        SetWriteInterest(true);
+        return true;
+      }
+      return false;
+    }
+
+    int bytes_written = static_cast<int>(written);
+    int frames_written = 0;
+    while (written > 0) {
+      PendingWrite &write = pending_writes_.front();
+      int remaining = write.size - write.offset;
+      if (written < remaining) {
+        write.offset += static_cast<int>(written);
+        break;
+      }
+
+      written -= remaining;
+      frames_written += write.is_frame_end ? 1 : 0;
+      buffer_pool_.Deallocate(write.buffer);
+      pending_writes_.pop_front();
+    }
+
+    send_queue_.RecordWrite(frames_written, bytes_written);
+  }
+
+  SetWriteInterest(false);
+  return true;
+}
+
+void SocketRpcChannel::SetWriteInterest(bool enabled) {
+  if (write_interest_ == enabled)
+    return;
+
+  epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN | EPOLLRDHUP;
+  if (enabled)
+    event.events |= EPOLLOUT;
+  event.data.fd = socket_;
+  if (epoll_ctl(epoll_, EPOLL_CTL_MOD, socket_, &event) == 0)
+    write_interest_ = enabled;
+}
+
+bool SocketRpcChannel::WritePendingData() {
+  ScopedLock lock(write_lock_);
+  return FlushPendingWrites();
+}
+
+bool SocketRpcChannel::ReadAvailableData() {
+  while (is_connected_ == Connected) {
+    int size;
+    char *target = frame_reader_.PrepareRead(&size);
+
+    ssize_t bytes_read = recv(socket_, target, size, 0);
+    if (bytes_read == 0) {
+      std::cout << "Socket closed by peer\n";
+      return false;
+    } else if (bytes_read == -1) {
+      if (errno == EINTR)
+        continue;
+      if (IsWouldBlockError(errno))
+        return true;
+      std::cout << "error: recv failed with errno == " << errno << "\n";
+      return false;
+    }
+
+    frame_reader_.CommitRead(static_cast<int>(bytes_read));
+
+    const char *data;
+    int message_size;
+    MessageFrameReader::Result result = MessageFrameReader::NeedMoreData;
+    while (is_connected_ == Connected &&
+           (result = frame_reader_.ReadNextMessage(&data, &message_size)) ==
+               MessageFrameReader::MessageAvailable) {
+      RpcMessage message;
+      if (!message.ParseFromArray(data, message_size)) {
+        std::cout << "error: Failed to parse incoming message\n";
+        return false;
+      }
+
+      // TODO: Without the worker pool the calls block the event loop
+      // thread, so a native client that makes a synchronous call while
+      // handling an event would lock up.
+      Receive(message);
+    }
+
+    if (result == MessageFrameReader::InvalidFrame) {
+      std::cout << "error: Received malformed message\n";
+      return false;
+    }
+
+    // The socket is drained, no need to wait for EAGAIN.
+    if (bytes_read < size)
+      return true;
+  }
+
+  return true;
+}
+
+int SocketRpcChannel::EventLoopThreadProc() {
+  while (is_connected_ == Connected) {
+    epoll_event events[MaxEventsPerWait];
+    int count =
+        epoll_wait(epoll_, events, MaxEventsPerWait, GetFlushTimeout());
+    if (count == -1) {
+      if (errno == EINTR)
+        continue;
+      std::cout << "error: epoll_wait failed with errno == " << errno << "\n";
+      HandleSurpriseDisconnect();
+      break;
+    }
+
+    bool broken = false;
+    for (int i = 0; i < count && !broken && is_connected_ == Connected; ++i) {
+      // Wakeup event is only signalled by Close.
+      if (events[i].data.fd == wakeup_event_)
+        return 0;
+
+      // Send event only wakes the loop up, the queue is flushed below.
+      if (events[i].data.fd == send_event_) {
+        uint64_t value;
+        if (read(send_event_, &value, sizeof(value)) == -1)
+          std::cout << "warning: Failed to reset the send event.\n";
+        continue;
+      }
+
+      if (events[i].events & EPOLLOUT)
+        broken = !WritePendingData();
+
+      if (!broken && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)))
+        broken = !ReadAvailableData();
+
+      if (!broken && (events[i].events & EPOLLERR))
+        broken = true;
+    }
+
+    // Writes queued by the handlers or other threads.
+    if (!broken && is_connected_ == Connected)
+      broken = !FlushSendQueueIfDue();
+
+    if (broken) {
+      HandleSurpriseDisconnect();
+      break;
+    }
+  }
+
+  return 0;
+}
+
+int SocketRpcChannel::CloseConnection() {
+  assert(socket_ != -1);
+
+  // Wake up the event loop and wait for it to finish, unless we are on the
+  // event loop thread (surprise disconnect or Close called from a handler).
+  if (has_event_thread_) {
+    uint64_t value = 1;
+    if (write(wakeup_event_, &value, sizeof(value)) == -1)
+      std::cout << "warning: Failed to wake up the event loop.\n";
+
+    if (pthread_equal(pthread_self(), event_thread_))
+      pthread_detach(event_thread_);
+    else
+      pthread_join(event_thread_, NULL);
+    has_event_thread_ = false;
+  }
+
+  {
+    ScopedLock lock(write_lock_);
+    while (!pending_writes_.empty()) {
+      buffer_pool_.Deallocate(pending_writes_.front().buffer);
+      pending_writes_.pop_front();
+    }
+  }
+
+  // Drop whatever was not written.
+  send_queue_.Clear();
+
+  int socket = socket_;
+
+  if (epoll_ != -1)
+    close(epoll_);
+  if (wakeup_event_ != -1)
+    close(wakeup_event_);
+  if (send_event_ != -1)
+    close(send_event_);
+  close(socket_);
+
+  epoll_ = -1;
+  wakeup_event_ = -1;
+  send_event_ = -1;
+  socket_ = -1;
+
+  return socket;
+}
+
+void SocketRpcChannel::HandleSurpriseDisconnect() {
+  // We can get here from multiple points, but only one should be allowed to do
+  // the work.
+  if (__sync_val_compare_and_swap(&is_connected_, Connected, Disconnected) ==
+      Connected) {
+    int socket = CloseConnection();
+    ReceiveChannelFailure();
+    InvokeDisconnectedCallback(socket);
+  }
+}
+
+void SocketRpcChannel::InvokeDisconnectedCallback(int socket) {
+  if (disconnected_callback_ != NULL)
+    disconnected_callback_->Invoke(socket);
+}
+
+} // namespace
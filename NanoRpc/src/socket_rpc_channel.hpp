@@ -0,0 +1,158 @@
+#if !defined(NANO_RPC_SOCKET_RPC_CHANNEL_HPP__)
+#define NANO_RPC_SOCKET_RPC_CHANNEL_HPP__
+
+#include <deque>
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "RpcMessageTypes.pb.h"
+
+#include "rpc_channel.hpp"
+#include "buffer_pool.hpp"
+#include "callback.hpp"
+#include "message_frame_reader.hpp"
+#include "send_queue.hpp"
+#include "synchronization_primitives.hpp"
+
+namespace NanoRpc {
+
+// Channel that runs over a connected stream socket (AF_UNIX or AF_INET).
+//
+// The socket is switched to non-blocking mode and serviced by an epoll loop
+// that runs on a dedicated thread, the same way NamedPipeRpcChannel services
+// its pipe from the I/O completion thread. Messages are framed with 4-byte
+// length prefix, so the channel is wire compatible with the .NET
+// StreamRpcChannel and SocketRpcChannel.
+//
+// This implementation is only available on Linux.
+class SocketRpcChannel : public RpcChannel {
+public:
+  SocketRpcChannel(RpcController *controller, int socket);
+  ~SocketRpcChannel();
+
+  virtual bool Start();
+  virtual void Close();
+
+  // Important: The socket passed in the disconnected callback is closed.
+  void set_disconnected_callback(CallbackBase<int> *callback) {
+    disconnected_callback_ = callback;
+  }
+  CallbackBase<int> *get_disconnected_callback() {
+    return disconnected_callback_;
+  }
+
+  // Outgoing messages are queued and written by the event loop, see
+  // SendQueue for the meaning of the limits.
+  void set_max_write_size(int max_write_size) {
+    send_queue_.set_max_write_size(max_write_size);
+  }
+  void set_flush_delay(unsigned int flush_delay) {
+    send_queue_.set_flush_delay(flush_delay);
+  }
+  void GetSendStatistics(SendQueue::Statistics *statistics) const {
+    send_queue_.GetStatistics(statistics);
+  }
+
+  // Controls Nagle's algorithm on TCP sockets. The channel turns it off when
+  // started, so small synchronous calls go out immediately.
+  // Returns false if the socket does not support the option (AF_UNIX).
+  bool SetNoDelay(bool no_delay);
+
+  // While the channel is corked, the kernel holds back partially filled
+  // segments and coalesces subsequent messages into full ones, which suits
+  // bursts of events. Uncork pushes out whatever is held back.
+  // The calls can be nested, the socket is uncorked by the outermost Uncork.
+  // Has no effect on sockets other than TCP.
+  void Cork();
+  void Uncork();
+
+protected:
+  virtual void Send(const RpcMessage &message);
+
+private:
+  enum ChannelState { NotConnected = 0, Connected = 1, Disconnected = 2 };
+
+  // Portion of a message that the socket did not accept yet.
+  struct PendingWrite {
+    char *buffer;
+    int size;
+    int offset;
+    bool is_frame_end;
+  };
+
+  int EventLoopThreadProc();
+
+  static void *EventLoopThreadProcThunk(void *parameter) {
+    SocketRpcChannel *channel = reinterpret_cast<SocketRpcChannel *>(parameter);
+    channel->EventLoopThreadProc();
+    return NULL;
+  }
+
+  // Both return false if connection is broken.
+  bool ReadAvailableData();
+  bool WritePendingData();
+
+  // Writes out the send queue, unless the flush is delayed.
+  // Both return false if connection is broken.
+  bool FlushSendQueueIfDue();
+  bool FlushSendQueue();
+
+  // Returns how long the event loop may wait before the delayed flush.
+  int GetFlushTimeout() const;
+
+  // Must be called with write_lock_ held.
+  bool FlushPendingWrites();
+  void SetWriteInterest(bool enabled);
+
+  int CloseConnection();
+
+  void HandleSurpriseDisconnect();
+
+  void InvokeDisconnectedCallback(int socket);
+
+  int socket_;
+  int epoll_;
+  int wakeup_event_;
+  int send_event_;
+  pthread_t event_thread_;
+  bool has_event_thread_;
+
+  Lock write_lock_;
+  std::deque<PendingWrite> pending_writes_;
+  bool write_interest_;
+  int cork_count_;
+
+  BufferPool buffer_pool_;
+
+  SendQueue send_queue_;
+  bool is_flush_scheduled_;
+  unsigned int flush_scheduled_at_;
+
+  // The socket is read directly into the frame reader buffer.
+  MessageFrameReader frame_reader_;
+
+  CallbackBase<int> *disconnected_callback_;
+
+  volatile int is_connected_;
+
+  DISALLOW_COPY_AND_ASSIGN(SocketRpcChannel);
+};
+
+// Keeps the channel corked for the lifetime of the object.
+class ScopedCork {
+public:
+  explicit ScopedCork(SocketRpcChannel *channel) : channel_(channel) {
+    channel_->Cork();
+  }
+  ~ScopedCork() { channel_->Uncork(); }
+
+private:
+  SocketRpcChannel *channel_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedCork);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_SOCKET_RPC_CHANNEL_HPP__
@@ -0,0 +1,82 @@
+#include "strand.hpp"
+
+#include <cassert>
+
+namespace NanoRpc {
+
+void Strand::Run() {
+  // The strand may be recycled and posted to again as soon as it runs out of
+  // tasks, so the loop does not touch the members after that.
+  StrandMap *owner = owner_;
+  for (int i = 0; i < StrandMap::MaxTasksPerRun; ++i) {
+    WorkerPool::Task *task = owner->TakeNextTask(this);
+    if (task == NULL)
+      return;
+    task->Run();
+  }
+
+  // Let the other strands run, the rest of the tasks is picked up later.
+  owner->worker_pool_->Submit(this);
+}
+
+StrandMap::StrandMap(WorkerPool *worker_pool) : worker_pool_(worker_pool) {}
+
+StrandMap::~StrandMap() {
+  assert(strands_.empty());
+  for (size_t i = 0; i < free_strands_.size(); ++i)
+    delete free_strands_[i];
+}
+
+void StrandMap::Post(unsigned int key, WorkerPool::Task *task) {
+  assert(task != NULL);
+  assert(worker_pool_ != NULL);
+
+  Strand *strand;
+  {
+    ScopedLock lock(lock_);
+
+    std::map<unsigned int, Strand *>::iterator iter = strands_.find(key);
+    if (iter != strands_.end()) {
+      strand = iter->second;
+    } else {
+      if (free_strands_.empty()) {
+        strand = new Strand();
+        strand->owner_ = this;
+      } else {
+        strand = free_strands_.back();
+        free_strands_.pop_back();
+      }
+      strand->key_ = key;
+      strands_.insert(std::make_pair(key, strand));
+    }
+
+    strand->tasks_.push_back(task);
+    if (strand->is_scheduled_)
+      return;
+    strand->is_scheduled_ = true;
+  }
+
+  worker_pool_->Submit(strand);
+}
+
+size_t StrandMap::GetActiveStrandCount() {
+  ScopedLock lock(lock_);
+  return strands_.size();
+}
+
+WorkerPool::Task *StrandMap::TakeNextTask(Strand *strand) {
+  ScopedLock lock(lock_);
+
+  if (strand->tasks_.empty()) {
+    strand->is_scheduled_ = false;
+    strands_.erase(strand->key_);
+    free_strands_.push_back(strand);
+    return NULL;
+  }
+
+  WorkerPool::Task *task = strand->tasks_.front();
+  strand->tasks_.pop_front();
+  return task;
+}
+
+} // namespace
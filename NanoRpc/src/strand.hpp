@@ -0,0 +1,84 @@
+#if !defined(NANO_RPC_STRAND_HPP__)
+#define NANO_RPC_STRAND_HPP__
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "basictypes.hpp"
+#include "synchronization_primitives.hpp"
+#include "worker_pool.hpp"
+
+namespace NanoRpc {
+
+class StrandMap;
+
+// Serial executor on top of the worker pool. Tasks posted to the same strand
+// run one at a time in the order they were posted, although not necessarily
+// on the same worker. Tasks of different strands run in parallel.
+//
+// Strands are owned by StrandMap, which creates them on demand and recycles
+// them as soon as they run out of tasks.
+class Strand : public WorkerPool::Task {
+  friend class StrandMap;
+
+public:
+  virtual void Run();
+
+private:
+  Strand() : owner_(NULL), key_(0), is_scheduled_(false) {}
+
+  StrandMap *owner_;
+  unsigned int key_;
+
+  // Guarded by the owner's lock.
+  std::deque<WorkerPool::Task *> tasks_;
+  bool is_scheduled_;
+
+  DISALLOW_COPY_AND_ASSIGN(Strand);
+};
+
+// Strands keyed by an arbitrary number (e.g. the id of the object the tasks
+// work on), so the tasks with the same key are serialized and the rest run
+// in parallel.
+//
+// This class is thread safe.
+class StrandMap {
+  friend class Strand;
+
+public:
+  explicit StrandMap(WorkerPool *worker_pool);
+  ~StrandMap();
+
+  // Must not be changed while any strand has tasks.
+  void set_worker_pool(WorkerPool *worker_pool) { worker_pool_ = worker_pool; }
+  WorkerPool *get_worker_pool() { return worker_pool_; }
+
+  // Queues the task on the strand of the key. The map does not take the
+  // ownership of the task.
+  void Post(unsigned int key, WorkerPool::Task *task);
+
+  // Number of the strands that have tasks.
+  size_t GetActiveStrandCount();
+
+private:
+  // Strand gives its turn up after this many tasks, so a busy strand does
+  // not hog the worker.
+  static const int MaxTasksPerRun = 16;
+
+  // Returns the next task of the strand, or NULL if it has none left, in
+  // which case the strand is recycled.
+  WorkerPool::Task *TakeNextTask(Strand *strand);
+
+  WorkerPool *worker_pool_;
+
+  Lock lock_;
+  std::map<unsigned int, Strand *> strands_;
+  std::vector<Strand *> free_strands_;
+
+  DISALLOW_COPY_AND_ASSIGN(StrandMap);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_STRAND_HPP__
@@ -2,10 +2,10 @@
 
 #include <cassert>
 
-#include <windows.h>
-
 namespace NanoRpc {
 
+#if defined(_WIN32)
+
 Event::Event()
     : SynchronizationObject(::CreateEvent(NULL, TRUE, FALSE, NULL)) {}
 
@@ -37,4 +37,71 @@ int Semaphore::Release(int count) {
   return previuos_count;
 }
 
+#else  // !_WIN32
+
+Event::Event() : manual_(true), signalled_(false) {
+  pthread_mutex_init(&mutex_, NULL);
+  pthread_cond_init(&cond_, NULL);
+}
+
+Event::Event(bool manual, bool signalled)
+    : manual_(manual), signalled_(signalled) {
+  pthread_mutex_init(&mutex_, NULL);
+  pthread_cond_init(&cond_, NULL);
+}
+
+Event::~Event() {
+  pthread_cond_destroy(&cond_);
+  pthread_mutex_destroy(&mutex_);
+}
+
+void Event::Set() {
+  pthread_mutex_lock(&mutex_);
+  signalled_ = true;
+  if (manual_)
+    pthread_cond_broadcast(&cond_);
+  else
+    pthread_cond_signal(&cond_);
+  pthread_mutex_unlock(&mutex_);
+}
+
+void Event::Reset() {
+  pthread_mutex_lock(&mutex_);
+  signalled_ = false;
+  pthread_mutex_unlock(&mutex_);
+}
+
+bool Event::Wait() {
+  pthread_mutex_lock(&mutex_);
+  while (!signalled_)
+    pthread_cond_wait(&cond_, &mutex_);
+  if (!manual_)
+    signalled_ = false;
+  pthread_mutex_unlock(&mutex_);
+  return true;
+}
+
+bool Event::Wait(unsigned int timeout) {
+  timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += timeout / 1000;
+  deadline.tv_nsec += (timeout % 1000) * 1000000;
+  if (deadline.tv_nsec >= 1000000000) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000;
+  }
+
+  pthread_mutex_lock(&mutex_);
+  int err = 0;
+  while (!signalled_ && err != ETIMEDOUT)
+    err = pthread_cond_timedwait(&cond_, &mutex_, &deadline);
+  bool signalled = signalled_;
+  if (signalled && !manual_)
+    signalled_ = false;
+  pthread_mutex_unlock(&mutex_);
+  return signalled;
+}
+
+#endif  // _WIN32
+
 } // namespace
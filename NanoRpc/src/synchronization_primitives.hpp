@@ -3,12 +3,20 @@
 
 #include <cassert>
 
+#if defined(_WIN32)
 #include <windows.h>
+#else
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#endif
 
 #include "basictypes.hpp"
 
 namespace NanoRpc {
 
+#if defined(_WIN32)
+
 class SynchronizationObject {
 public:
   explicit SynchronizationObject(HANDLE handle) : handle_(handle) {}
@@ -97,6 +105,78 @@ inline ScopedLock::ScopedLock(Lock &lock) : lock_(lock) { lock_.Acquire(); }
 
 inline ScopedLock::~ScopedLock() { lock_.Release(); }
 
+#else  // !_WIN32
+
+// POSIX counterparts of the primitives above. They only cover what the
+// platform independent parts of the library and the socket based channels
+// need, so there is no Semaphore and no generic wait on multiple objects.
+
+class Event {
+public:
+  Event();
+  Event(bool manual, bool signalled);
+  ~Event();
+
+  void Set();
+  void Reset();
+
+  // Waits until the event is signalled. Returns false if the timeout
+  // (in milliseconds) expired before that.
+  bool Wait();
+  bool Wait(unsigned int timeout);
+
+private:
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
+  bool manual_;
+  bool signalled_;
+
+  DISALLOW_COPY_AND_ASSIGN(Event);
+};
+
+class Lock {
+public:
+  Lock(unsigned int spin_count = 0);
+  ~Lock();
+
+  void Acquire();
+  void Release();
+
+private:
+  pthread_mutex_t mutex_;
+
+  DISALLOW_COPY_AND_ASSIGN(Lock);
+};
+
+class ScopedLock {
+public:
+  ScopedLock(Lock &lock);
+  ~ScopedLock();
+
+private:
+  Lock &lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedLock);
+};
+
+// The spin count is a Windows critical section tuning knob and is ignored
+// here.
+inline Lock::Lock(unsigned int /* spin_count */) {
+  pthread_mutex_init(&mutex_, NULL);
+}
+
+inline Lock::~Lock() { pthread_mutex_destroy(&mutex_); }
+
+inline void Lock::Acquire() { pthread_mutex_lock(&mutex_); }
+
+inline void Lock::Release() { pthread_mutex_unlock(&mutex_); }
+
+inline ScopedLock::ScopedLock(Lock &lock) : lock_(lock) { lock_.Acquire(); }
+
+inline ScopedLock::~ScopedLock() { lock_.Release(); }
+
+#endif  // _WIN32
+
 }  // namespace
 
 #endif  // NANO_RPC_SYNCHRONIZATION_PRIMITIVES_HPP__
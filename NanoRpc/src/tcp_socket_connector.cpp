@@ -0,0 +1,103 @@
+#include "tcp_socket_connector.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace NanoRpc {
+
+namespace {
+
+const int ListenBacklog = 64;
+
+// Resolves the address. Caller must free the result with freeaddrinfo.
+addrinfo *ResolveAddress(const std::string &host_name, unsigned short port,
+                         bool passive) {
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_protocol = IPPROTO_TCP;
+  hints.ai_flags = passive ? AI_PASSIVE : 0;
+
+  char service[8];
+  snprintf(service, sizeof(service), "%u", static_cast<unsigned int>(port));
+
+  addrinfo *result = NULL;
+  if (getaddrinfo(host_name.empty() ? NULL : host_name.c_str(), service,
+                  &hints, &result) != 0)
+    return NULL;
+  return result;
+}
+
+} // namespace
+
+TcpSocketConnector::TcpSocketConnector(const char *host_name,
+                                       unsigned short port)
+    : port_(port) {
+  set_host_name(host_name);
+}
+
+TcpSocketConnector::~TcpSocketConnector() { Shutdown(); }
+
+int TcpSocketConnector::CreateListeningSocket() {
+  addrinfo *addresses = ResolveAddress(host_name_, port_, true);
+  if (addresses == NULL)
+    return -1;
+
+  int listen_socket = -1;
+  for (addrinfo *address = addresses; address != NULL;
+       address = address->ai_next) {
+    listen_socket =
+        socket(address->ai_family,
+               address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+               address->ai_protocol);
+    if (listen_socket == -1)
+      continue;
+
+    // Allow server restart while old connections are in TIME_WAIT.
+    int reuse = 1;
+    setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, &reuse,
+               sizeof(reuse));
+
+    if (bind(listen_socket, address->ai_addr, address->ai_addrlen) == 0 &&
+        listen(listen_socket, ListenBacklog) == 0)
+      break;
+
+    close(listen_socket);
+    listen_socket = -1;
+  }
+
+  freeaddrinfo(addresses);
+  return listen_socket;
+}
+
+int TcpSocketConnector::AttemptConnectToServer() {
+  addrinfo *addresses = ResolveAddress(host_name_, port_, false);
+  if (addresses == NULL)
+    return -1;
+
+  int socket = -1;
+  for (addrinfo *address = addresses; address != NULL;
+       address = address->ai_next) {
+    socket = ::socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC,
+                      address->ai_protocol);
+    if (socket == -1)
+      continue;
+
+    if (connect(socket, address->ai_addr, address->ai_addrlen) == 0)
+      break;
+
+    close(socket);
+    socket = -1;
+  }
+
+  freeaddrinfo(addresses);
+  return socket;
+}
+
+} // namespace
@@ -0,0 +1,45 @@
+#if !defined(NANO_RPC_TCP_SOCKET_CONNECTOR_HPP__)
+#define NANO_RPC_TCP_SOCKET_CONNECTOR_HPP__
+
+#include <string>
+
+#include "socket_connector.hpp"
+
+namespace NanoRpc {
+
+// Connects TCP sockets, so the server can be reached from other hosts.
+// See SocketConnector for the connection sequence.
+//
+// In server mode the host name selects the local interface to listen on,
+// the empty host name means all interfaces.
+//
+// This implementation is only available on Linux.
+class TcpSocketConnector : public SocketConnector {
+public:
+  TcpSocketConnector() : port_(0) {}
+  TcpSocketConnector(const char *host_name, unsigned short port);
+  ~TcpSocketConnector();
+
+  std::string get_host_name() const { return host_name_; }
+  void set_host_name(const char *host_name) {
+    host_name_ = host_name == NULL ? "" : host_name;
+  }
+
+  unsigned short get_port() const { return port_; }
+  void set_port(unsigned short port) { port_ = port; }
+
+protected:
+  virtual bool HasAddress() const { return port_ != 0; }
+  virtual int CreateListeningSocket();
+  virtual int AttemptConnectToServer();
+
+private:
+  std::string host_name_;
+  unsigned short port_;
+
+  DISALLOW_COPY_AND_ASSIGN(TcpSocketConnector);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_TCP_SOCKET_CONNECTOR_HPP__
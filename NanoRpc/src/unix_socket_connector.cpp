@@ -0,0 +1,79 @@
+#include "unix_socket_connector.hpp"
+
+#include <cstring>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace NanoRpc {
+
+namespace {
+
+const int ListenBacklog = 16;
+
+bool FillSocketAddress(const std::string &path, sockaddr_un *address) {
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address->sun_path))
+    return false;
+  memcpy(address->sun_path, path.c_str(), path.size());
+  return true;
+}
+
+} // namespace
+
+UnixSocketConnector::UnixSocketConnector(const char *socket_path) {
+  set_socket_path(socket_path);
+}
+
+UnixSocketConnector::~UnixSocketConnector() { Shutdown(); }
+
+int UnixSocketConnector::CreateListeningSocket() {
+  sockaddr_un address;
+  if (!FillSocketAddress(socket_path_, &address))
+    return -1;
+
+  int listen_socket =
+      socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listen_socket == -1)
+    return -1;
+
+  // Remove socket file left over by a previous server instance.
+  unlink(socket_path_.c_str());
+
+  if (bind(listen_socket, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) == -1 ||
+      listen(listen_socket, ListenBacklog) == -1) {
+    close(listen_socket);
+    return -1;
+  }
+
+  return listen_socket;
+}
+
+int UnixSocketConnector::AttemptConnectToServer() {
+  sockaddr_un address;
+  if (!FillSocketAddress(socket_path_, &address))
+    return -1;
+
+  int socket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (socket == -1)
+    return -1;
+
+  if (connect(socket, reinterpret_cast<sockaddr *>(&address),
+              sizeof(address)) == -1) {
+    close(socket);
+    return -1;
+  }
+
+  return socket;
+}
+
+void UnixSocketConnector::CloseListeningSocket(int socket) {
+  close(socket);
+  unlink(socket_path_.c_str());
+}
+
+} // namespace
@@ -0,0 +1,39 @@
+#if !defined(NANO_RPC_UNIX_SOCKET_CONNECTOR_HPP__)
+#define NANO_RPC_UNIX_SOCKET_CONNECTOR_HPP__
+
+#include <string>
+
+#include "socket_connector.hpp"
+
+namespace NanoRpc {
+
+// Connects Unix domain stream sockets bound to a file system path.
+// See SocketConnector for the connection sequence.
+//
+// This implementation is only available on Linux.
+class UnixSocketConnector : public SocketConnector {
+public:
+  UnixSocketConnector() {}
+  explicit UnixSocketConnector(const char *socket_path);
+  ~UnixSocketConnector();
+
+  std::string get_socket_path() const { return socket_path_; }
+  void set_socket_path(const char *socket_path) {
+    socket_path_ = socket_path == NULL ? "" : socket_path;
+  }
+
+protected:
+  virtual bool HasAddress() const { return !socket_path_.empty(); }
+  virtual int CreateListeningSocket();
+  virtual int AttemptConnectToServer();
+  virtual void CloseListeningSocket(int socket);
+
+private:
+  std::string socket_path_;
+
+  DISALLOW_COPY_AND_ASSIGN(UnixSocketConnector);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_UNIX_SOCKET_CONNECTOR_HPP__
@@ -0,0 +1,283 @@
+#include "worker_pool.hpp"
+
+#include <cassert>
+#include <deque>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "atomic_operations.hpp"
+#include "synchronization_primitives.hpp"
+
+#if defined(_WIN32)
+#define NANO_RPC_THREAD_LOCAL __declspec(thread)
+#else
+#define NANO_RPC_THREAD_LOCAL __thread
+#endif
+
+namespace NanoRpc {
+
+namespace {
+
+// Idle workers wake up this often to look for tasks even if nobody woke
+// them up. It only matters if the wake up was missed.
+const unsigned int IdleTimeout = 100;
+
+WorkerPool *volatile default_pool = NULL;
+
+} // namespace
+
+struct WorkerPool::Worker {
+  explicit Worker(WorkerPool *owner)
+      : pool(owner), wakeup_event(false, false), is_idle(0) {}
+
+#if defined(_WIN32)
+  static DWORD WINAPI ThreadProcThunk(void *parameter) {
+    Worker *worker = reinterpret_cast<Worker *>(parameter);
+    worker->pool->WorkerThreadProc(worker);
+    return 0;
+  }
+
+  HANDLE thread;
+#else
+  static void *ThreadProcThunk(void *parameter) {
+    Worker *worker = reinterpret_cast<Worker *>(parameter);
+    worker->pool->WorkerThreadProc(worker);
+    return NULL;
+  }
+
+  pthread_t thread;
+#endif
+
+  WorkerPool *pool;
+
+  // The owner works at the back, thieves take from the front.
+  Lock lock;
+  std::deque<Task *> tasks;
+
+  Event wakeup_event;
+  volatile long is_idle;
+};
+
+namespace {
+
+// Worker the current thread runs, if any.
+NANO_RPC_THREAD_LOCAL void *current_worker = NULL;
+
+} // namespace
+
+WorkerPool::WorkerPool()
+    : next_worker_(0), idle_worker_count_(0), is_stopping_(0) {}
+
+WorkerPool::~WorkerPool() { Stop(); }
+
+WorkerPool *WorkerPool::GetDefault() {
+  WorkerPool *pool = default_pool;
+  if (pool != NULL)
+    return pool;
+
+  // Threads racing here may start a pool each, only one of them wins.
+  pool = new WorkerPool();
+  if (!pool->Start()) {
+    delete pool;
+    return NULL;
+  }
+
+  WorkerPool *current = AtomicCompareExchangePointer(
+      &default_pool, pool, static_cast<WorkerPool *>(NULL));
+  if (current != NULL) {
+    delete pool;
+    return current;
+  }
+
+  return pool;
+}
+
+int WorkerPool::GetProcessorCount() {
+#if defined(_WIN32)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  int count = static_cast<int>(info.dwNumberOfProcessors);
+#else
+  int count = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+  return count > 0 ? count : 1;
+}
+
+bool WorkerPool::Start(int worker_count) {
+  assert(workers_.empty());
+
+  if (worker_count <= 0)
+    worker_count = GetProcessorCount();
+
+  is_stopping_ = 0;
+
+  // All workers must exist before any of them starts stealing.
+  for (int i = 0; i < worker_count; ++i)
+    workers_.push_back(new Worker(this));
+
+  for (int i = 0; i < worker_count; ++i) {
+    Worker *worker = workers_[i];
+#if defined(_WIN32)
+    worker->thread =
+        CreateThread(NULL, 0, &Worker::ThreadProcThunk, worker, 0, NULL);
+    bool started = worker->thread != NULL;
+#else
+    bool started = pthread_create(&worker->thread, NULL,
+                                  &Worker::ThreadProcThunk, worker) == 0;
+#endif
+    if (!started) {
+      // The workers that are already running may be stealing from the
+      // others, so they are stopped before any worker is deleted.
+      StopWorkers(i);
+      for (int j = 0; j < worker_count; ++j)
+        delete workers_[j];
+      workers_.clear();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void WorkerPool::Stop() {
+  if (workers_.empty())
+    return;
+
+  assert(!IsWorkerThread());
+
+  StopWorkers(workers_.size());
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    assert(workers_[i]->tasks.empty());
+    delete workers_[i];
+  }
+
+  workers_.clear();
+}
+
+void WorkerPool::StopWorkers(size_t running_count) {
+  AtomicExchange(&is_stopping_, 1);
+  for (size_t i = 0; i < running_count; ++i)
+    workers_[i]->wakeup_event.Set();
+
+  for (size_t i = 0; i < running_count; ++i) {
+#if defined(_WIN32)
+    WaitForSingleObject(workers_[i]->thread, INFINITE);
+    CloseHandle(workers_[i]->thread);
+#else
+    pthread_join(workers_[i]->thread, NULL);
+#endif
+  }
+}
+
+bool WorkerPool::IsWorkerThread() const {
+  Worker *worker = reinterpret_cast<Worker *>(current_worker);
+  return worker != NULL && worker->pool == this;
+}
+
+void WorkerPool::Submit(Task *task) {
+  assert(task != NULL);
+  assert(!workers_.empty());
+
+  Worker *worker = reinterpret_cast<Worker *>(current_worker);
+  if (worker == NULL || worker->pool != this) {
+    long index = AtomicIncrement(&next_worker_);
+    worker = workers_[static_cast<unsigned long>(index) % workers_.size()];
+  }
+
+  {
+    ScopedLock lock(worker->lock);
+    worker->tasks.push_back(task);
+  }
+
+  if (idle_worker_count_ > 0)
+    WakeUpWorker(worker);
+}
+
+void WorkerPool::WorkerThreadProc(Worker *worker) {
+  current_worker = worker;
+
+  while (true) {
+    Task *task = TakeTask(worker);
+    if (task != NULL) {
+      task->Run();
+      continue;
+    }
+
+    if (is_stopping_ != 0)
+      break;
+
+    // Announce the idleness first and look once more, so a task submitted
+    // in between is either seen here or the submitter wakes us up.
+    AtomicIncrement(&idle_worker_count_);
+    AtomicExchange(&worker->is_idle, 1);
+
+    task = TakeTask(worker);
+    if (task == NULL && is_stopping_ == 0)
+      worker->wakeup_event.Wait(IdleTimeout);
+
+    AtomicExchange(&worker->is_idle, 0);
+    AtomicDecrement(&idle_worker_count_);
+
+    if (task != NULL)
+      task->Run();
+  }
+
+  current_worker = NULL;
+}
+
+WorkerPool::Task *WorkerPool::TakeTask(Worker *worker) {
+  {
+    ScopedLock lock(worker->lock);
+    if (!worker->tasks.empty()) {
+      Task *task = worker->tasks.back();
+      worker->tasks.pop_back();
+      return task;
+    }
+  }
+
+  return StealTask(worker);
+}
+
+WorkerPool::Task *WorkerPool::StealTask(Worker *thief) {
+  size_t count = workers_.size();
+  size_t start = 0;
+  while (start < count && workers_[start] != thief)
+    ++start;
+
+  // Start with the neighbour, so thieves do not all go after the same
+  // victim.
+  for (size_t i = 1; i < count; ++i) {
+    Worker *victim = workers_[(start + i) % count];
+    ScopedLock lock(victim->lock);
+    if (!victim->tasks.empty()) {
+      Task *task = victim->tasks.front();
+      victim->tasks.pop_front();
+      return task;
+    }
+  }
+
+  return NULL;
+}
+
+void WorkerPool::WakeUpWorker(Worker *preferred) {
+  if (AtomicCompareExchange(&preferred->is_idle, 0, 1) == 1) {
+    preferred->wakeup_event.Set();
+    return;
+  }
+
+  // The owner is busy, the task goes to whoever steals it first.
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    Worker *worker = workers_[i];
+    if (AtomicCompareExchange(&worker->is_idle, 0, 1) == 1) {
+      worker->wakeup_event.Set();
+      return;
+    }
+  }
+}
+
+} // namespace
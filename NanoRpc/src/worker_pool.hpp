@@ -0,0 +1,87 @@
+#if !defined(NANO_RPC_WORKER_POOL_HPP__)
+#define NANO_RPC_WORKER_POOL_HPP__
+
+#include <vector>
+
+#include "basictypes.hpp"
+
+namespace NanoRpc {
+
+// Fixed set of worker threads that run tasks off the I/O threads.
+//
+// Every worker has its own deque of tasks. A task submitted from a worker
+// goes to the back of that worker's deque and the worker takes its tasks
+// from the back, so work spawned by a task tends to run on the same thread
+// while its data is still in the cache. A task submitted from any other
+// thread (e.g. an I/O thread) is distributed round-robin. A worker that
+// runs out of tasks steals from the front of the other workers' deques, so
+// a slow task only delays the tasks queued behind it until another worker
+// becomes idle.
+//
+// Tasks are run in no particular order.
+//
+// This class is thread safe.
+class WorkerPool {
+public:
+  class Task {
+  public:
+    virtual ~Task() {}
+
+    // Called on a worker thread. The task may delete itself.
+    virtual void Run() = 0;
+  };
+
+  WorkerPool();
+  ~WorkerPool();
+
+  // Returns the process-wide pool, started on the first use with one worker
+  // per processor. It is never stopped.
+  static WorkerPool *GetDefault();
+
+  // Zero worker count means one worker per processor.
+  bool Start(int worker_count = 0);
+
+  // Runs the tasks that are already queued and stops the workers.
+  void Stop();
+
+  bool IsRunning() const { return !workers_.empty(); }
+
+  int get_worker_count() const { return static_cast<int>(workers_.size()); }
+
+  // Returns true if called from one of the workers of this pool.
+  bool IsWorkerThread() const;
+
+  // The pool does not take the ownership of the task; it is up to the task
+  // to delete (or recycle) itself when it is run.
+  void Submit(Task *task);
+
+private:
+  struct Worker;
+
+  static int GetProcessorCount();
+
+  // Stops and joins the first running_count workers.
+  void StopWorkers(size_t running_count);
+
+  void WorkerThreadProc(Worker *worker);
+
+  // Takes the task from the back of the worker's deque, or steals one from
+  // the front of another worker's deque.
+  Task *TakeTask(Worker *worker);
+  Task *StealTask(Worker *thief);
+
+  // Wakes up one of the idle workers, preferably the specified one.
+  void WakeUpWorker(Worker *preferred);
+
+  std::vector<Worker *> workers_;
+
+  volatile long next_worker_;
+  volatile long idle_worker_count_;
+  volatile long is_stopping_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkerPool);
+};
+
+}  // namespace
+
+#endif  // NANO_RPC_WORKER_POOL_HPP__